@@ -7,11 +7,17 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
 #include "include/core/SkFont.h"
+#include "include/core/SkString.h"
 #include "include/core/SkTypeface.h"
 #include "include/utils/SkRandom.h"
 #include "src/utils/SkCharToGlyphCache.h"
 #include "src/utils/SkUTF.h"
+#include "tools/Resources.h"
+
+#include <algorithm>
+#include <vector>
 
 enum {
     NGLYPHS = 100
@@ -122,3 +128,71 @@ DEF_BENCH( return new CMAPBench(textToGlyphs_proc, "font_charToGlyph", BIG); )
 DEF_BENCH( return new CMAPBench(charsToGlyphs_proc, "face_charToGlyph", BIG); )
 DEF_BENCH( return new CMAPBench(addcache_proc, "addcache_charToGlyph", BIG); )
 DEF_BENCH( return new CMAPBench(findcache_proc, "findcache_charToGlyph", BIG); )
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+// Decodes, or decodes and maps to glyphs, a UTF-8 corpus made of the given scripts' sample text.
+class UTF8TextBench : public Benchmark {
+public:
+    UTF8TextBench(bool toGlyphs, const char name[], std::vector<const char*> scripts)
+            : fToGlyphs(toGlyphs), fScripts(std::move(scripts)) {
+        fName.printf("%s_%s", toGlyphs ? "utf8_textToGlyphs" : "utf8_decode", name);
+    }
+
+protected:
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onDelayedSetup() override {
+        for (const char* script : fScripts) {
+            SkString path = SkStringPrintf("text/%s.txt", script);
+            if (sk_sp<SkData> data = GetResourceAsData(path.c_str())) {
+                fText.append(static_cast<const char*>(data->data()), data->size());
+            }
+        }
+        int count = SkUTF::CountUTF8(fText.c_str(), fText.size());
+        fUnichars.resize(std::max(count, 0));
+        fGlyphs.resize(std::max(count, 0));
+        fFont.setTypeface(SkTypeface::MakeDefault());
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        if (fUnichars.empty()) {
+            return;
+        }
+        for (int i = 0; i < loops; ++i) {
+            if (fToGlyphs) {
+                fFont.textToGlyphs(fText.c_str(), fText.size(), SkTextEncoding::kUTF8,
+                                   fGlyphs.data(), (int)fGlyphs.size());
+            } else {
+                SkUTF::UTF8ToUTF32(fUnichars.data(), (int)fUnichars.size(),
+                                   fText.c_str(), fText.size());
+            }
+        }
+    }
+
+private:
+    const bool fToGlyphs;
+    const std::vector<const char*> fScripts;
+    SkString fName;
+    SkString fText;
+    std::vector<SkUnichar> fUnichars;
+    std::vector<SkGlyphID> fGlyphs;
+    SkFont fFont;
+};
+}  // namespace
+
+#define UTF8_TEXT_BENCH(name, ...)                                                   \
+    DEF_BENCH( return new UTF8TextBench(false, #name, {__VA_ARGS__}); )              \
+    DEF_BENCH( return new UTF8TextBench(true, #name, {__VA_ARGS__}); )
+UTF8_TEXT_BENCH(english, "english")
+UTF8_TEXT_BENCH(cyrillic, "cyrillic")
+UTF8_TEXT_BENCH(han, "han_simplified")
+UTF8_TEXT_BENCH(mixed, "english", "arabic", "greek", "han_simplified", "hangul", "emoji")
+#undef UTF8_TEXT_BENCH
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/codec/SkCodec.h"
+#include "include/core/SkData.h"
+#include "tools/Resources.h"
+
+#include <vector>
+
+// Measures how quickly we can learn the size, orientation and color profile of many images,
+// either with SkCodec::ProbeInfo() or by constructing a full codec for each one.
+class CodecProbeBench : public Benchmark {
+public:
+    explicit CodecProbeBench(bool fullCodec)
+        : fName(fullCodec ? "codec_probe_make_codec" : "codec_probe_header_only")
+        , fFullCodec(fullCodec) {}
+
+protected:
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    const char* onGetName() override { return fName; }
+
+    void onDelayedSetup() override {
+        for (const char* path : { "images/mandrill_512_q075.jpg",
+                                  "images/dog.jpg",
+                                  "images/color_wheel.jpg",
+                                  "images/wide_gamut_yellow_224_224_64.jpeg",
+                                  "images/orientation/6_420.jpg",
+                                  "images/mandrill_512.png",
+                                  "images/color_wheel.png",
+                                  "images/yellow_rose.png",
+                                  "images/color_wheel.webp",
+                                  "images/stoplight.webp",
+                                  "images/orientation/5.webp",
+                                  "images/color_wheel.gif" }) {
+            if (auto data = GetResourceAsData(path)) {
+                fData.push_back(std::move(data));
+            }
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        int sum = 0;
+        while (loops --> 0) {
+            for (const sk_sp<SkData>& data : fData) {
+                if (fFullCodec) {
+                    if (auto codec = SkCodec::MakeFromData(data)) {
+                        sum += codec->dimensions().width() + codec->getOrigin();
+                        sum += codec->getICCProfile() ? 1 : 0;
+                    }
+                } else {
+                    SkCodec::ProbeResult probe;
+                    if (SkCodec::ProbeInfo(data->data(), data->size(), &probe)) {
+                        sum += probe.fDimensions.width() + probe.fOrigin;
+                        sum += probe.fHasColorProfile ? 1 : 0;
+                    }
+                }
+            }
+        }
+        // Keep the work from being optimized away.
+        fSink = sum;
+    }
+
+private:
+    const char*                fName;
+    const bool                 fFullCodec;
+    std::vector<sk_sp<SkData>> fData;
+    volatile int               fSink = 0;
+};
+
+DEF_BENCH(return new CodecProbeBench(false);)
+DEF_BENCH(return new CodecProbeBench(true);)
@@ -6,7 +6,9 @@
  */
 
 #include "bench/Benchmark.h"
+#include "include/codec/SkAndroidCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkImage.h"
 #include "include/core/SkPictureRecorder.h"
 #include "modules/skottie/include/Skottie.h"
 #include "tools/Resources.h"
@@ -55,6 +57,88 @@ private:
 };
 
 
+// Compares shrinking while decoding (area-averaging in SkSampledCodec) against decoding at full
+// size and then calling scalePixels().
+class ScaledDecodeBench final : public DecodeBench {
+public:
+    ScaledDecodeBench(const char* name, const char* source, SkISize size, bool fused)
+        : INHERITED(name, source)
+        , fSize(size)
+        , fFused(fused)
+    {}
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkBitmap dst;
+        dst.allocN32Pixels(fSize.width(), fSize.height());
+        while (loops-- > 0) {
+            auto codec = SkAndroidCodec::MakeFromData(fData);
+            const SkImageInfo info = dst.info().makeAlphaType(kPremul_SkAlphaType);
+            if (fFused) {
+                SkAndroidCodec::AndroidOptions options;
+                options.fDownsample = SkAndroidCodec::AndroidOptions::Downsample::kAreaAverage;
+                codec->getAndroidPixels(info, dst.getPixels(), dst.rowBytes(), &options);
+            } else {
+                SkBitmap full;
+                full.allocPixels(info.makeDimensions(codec->getInfo().dimensions()));
+                codec->getAndroidPixels(full.info(), full.getPixels(), full.rowBytes());
+                full.pixmap().scalePixels(dst.pixmap(), SkSamplingOptions(SkFilterMode::kLinear,
+                                                                          SkMipmapMode::kLinear));
+            }
+        }
+    }
+
+private:
+    const SkISize fSize;
+    const bool    fFused;
+
+    using INHERITED = DecodeBench;
+};
+
+DEF_BENCH(return new ScaledDecodeBench("scaled_mandrill_1600_area",
+                                       "images/mandrill_1600.png", {300, 300}, true));
+DEF_BENCH(return new ScaledDecodeBench("scaled_mandrill_1600_decode_then_scale",
+                                       "images/mandrill_1600.png", {300, 300}, false));
+DEF_BENCH(return new ScaledDecodeBench("scaled_mandrill_512_q075_area",
+                                       "images/mandrill_512_q075.jpg", {100, 100}, true));
+DEF_BENCH(return new ScaledDecodeBench("scaled_mandrill_512_q075_decode_then_scale",
+                                       "images/mandrill_512_q075.jpg", {100, 100}, false));
+
+// Downscales a JPEG-backed lazy image with SkImage::scalePixels(), either directly (which can
+// use the decoder's YUV planes) or after forcing a full-size RGBA raster copy.
+class LazyScaleBench final : public DecodeBench {
+public:
+    LazyScaleBench(const char* name, const char* source, SkISize size, bool viaRaster)
+        : INHERITED(name, source)
+        , fSize(size)
+        , fViaRaster(viaRaster)
+    {}
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkBitmap dst;
+        dst.allocN32Pixels(fSize.width(), fSize.height());
+        const SkSamplingOptions sampling(SkFilterMode::kLinear, SkMipmapMode::kLinear);
+        while (loops-- > 0) {
+            // A new image each time, so nothing is served from the planes or bitmap caches.
+            sk_sp<SkImage> image = SkImage::MakeFromEncoded(fData);
+            if (fViaRaster) {
+                image = image->makeRasterImage();
+            }
+            image->scalePixels(dst.pixmap(), sampling, SkImage::kDisallow_CachingHint);
+        }
+    }
+
+private:
+    const SkISize fSize;
+    const bool    fViaRaster;
+
+    using INHERITED = DecodeBench;
+};
+
+DEF_BENCH(return new LazyScaleBench("lazyscale_mandrill_512_q075_yuv",
+                                    "images/mandrill_512_q075.jpg", {128, 128}, false));
+DEF_BENCH(return new LazyScaleBench("lazyscale_mandrill_512_q075_rgba",
+                                    "images/mandrill_512_q075.jpg", {128, 128}, true));
+
 class SkottieDecodeBench final : public DecodeBench {
 public:
     SkottieDecodeBench(const char* name, const char* source)
@@ -10,9 +10,11 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkData.h"
 #include "include/core/SkExecutor.h"
+#include "include/core/SkFont.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkStream.h"
+#include "include/core/SkString.h"
 #include "include/effects/SkGradientShader.h"
 #include "include/private/base/SkTo.h"
 #include "include/utils/SkRandom.h"
@@ -76,6 +78,7 @@ DEF_BENCH(return new PDFScalarBench("PDFScalar_random", next_any);)
 
 #ifdef SK_SUPPORT_PDF
 
+#include "src/pdf/SkDeflate.h"
 #include "src/pdf/SkPDFBitmap.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/pdf/SkPDFShader.h"
@@ -185,6 +188,52 @@ private:
     std::unique_ptr<SkStreamAsset> fAsset;
 };
 
+/** Raw SkDeflateWStream throughput, on a PDF command stream and on image pixels, written in
+    pieces of fChunkSize bytes as the PDF backend does. */
+class DeflateBench : public Benchmark {
+public:
+    DeflateBench(const char* input, size_t chunkSize, int level)
+            : fInput(input), fChunkSize(chunkSize), fLevel(level) {
+        fName.printf("Deflate_%s_%zu_level%d", input, chunkSize, level);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+    void onDelayedSetup() override {
+        if (0 == strcmp(fInput, "content")) {
+            fData = GetResourceAsData("pdf_command_stream.txt");
+        } else if (sk_sp<SkImage> image = GetResourceAsImage("images/mandrill_512.png")) {
+            SkBitmap bitmap;
+            bitmap.allocN32Pixels(image->width(), image->height());
+            if (image->readPixels(nullptr, bitmap.pixmap(), 0, 0)) {
+                fData = SkData::MakeWithCopy(bitmap.getPixels(), bitmap.computeByteSize());
+            }
+        }
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        SkASSERT(fData);
+        if (!fData) { return; }
+        while (loops-- > 0) {
+            SkNullWStream wStream;
+            SkDeflateWStream deflate(&wStream, fLevel);
+            const uint8_t* bytes = fData->bytes();
+            for (size_t i = 0; i < fData->size(); i += fChunkSize) {
+                deflate.write(bytes + i, std::min(fChunkSize, fData->size() - i));
+            }
+        }
+    }
+
+private:
+    const char* fInput;
+    size_t fChunkSize;
+    int fLevel;
+    SkString fName;
+    sk_sp<SkData> fData;
+};
+
 struct PDFColorComponentBench : public Benchmark {
     bool isSuitableFor(Backend b) override {
         return b == kNonRendering_Backend;
@@ -303,14 +352,59 @@ struct PDFClipPathBenchmark : public Benchmark {
     }
 };
 
+// Many small drawings in one graphic state, the common shape of tables, charts
+// and text documents.  Consecutive rect fills are painted with a single 'f' and
+// consecutive glyph runs share one BT/ET text object.
+struct PDFContentStreamBench : public Benchmark {
+    bool fText;
+    PDFContentStreamBench(bool text) : fText(text) {}
+    const char* onGetName() override {
+        return fText ? "PDFContentStream_text" : "PDFContentStream_rects";
+    }
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        SkFont font;
+        font.setSize(8);
+        SkPaint paint;
+        paint.setColor(SK_ColorBLUE);
+        while (loops-- > 0) {
+            SkNullWStream wStream;
+            SkPDF::Metadata metadata;
+            metadata.fCompressionLevel = SkPDF::Metadata::CompressionLevel::None;
+            auto doc = SkPDF::MakeDocument(&wStream, metadata);
+            SkCanvas* canvas = doc->beginPage(612, 792);
+            for (int y = 0; y < 96; ++y) {
+                for (int x = 0; x < 48; ++x) {
+                    if (fText) {
+                        canvas->drawString("cell", 12.0f * x, 8.0f * y + 8, font, paint);
+                    } else {
+                        canvas->drawRect(SkRect::MakeXYWH(12.0f * x, 8.0f * y, 10, 6), paint);
+                    }
+                }
+            }
+            doc->close();
+        }
+    }
+};
+
 }  // namespace
 DEF_BENCH(return new PDFImageBench;)
 DEF_BENCH(return new PDFJpegImageBench;)
 DEF_BENCH(return new PDFCompressionBench;)
+DEF_BENCH(return new DeflateBench("content", 64, -1);)
+DEF_BENCH(return new DeflateBench("content", 4096, -1);)
+DEF_BENCH(return new DeflateBench("content", 4096, 1);)
+DEF_BENCH(return new DeflateBench("pixels", 2048, -1);)
+DEF_BENCH(return new DeflateBench("pixels", 2048, 1);)
+DEF_BENCH(return new DeflateBench("pixels", 1 << 20, -1);)
 DEF_BENCH(return new PDFColorComponentBench;)
 DEF_BENCH(return new PDFShaderBench;)
 DEF_BENCH(return new WritePDFTextBenchmark;)
 DEF_BENCH(return new PDFClipPathBenchmark;)
+DEF_BENCH(return new PDFContentStreamBench(false);)
+DEF_BENCH(return new PDFContentStreamBench(true);)
 
 #ifdef SK_PDF_ENABLE_SLOW_TESTS
 #include "include/core/SkExecutor.h"
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+
+#include "include/core/SkTypes.h"
+
+#ifdef SK_XML
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkRect.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkString.h"
+#include "include/private/base/SkTArray.h"
+#include "include/svg/SkSVGCanvas.h"
+#include "include/utils/SkRandom.h"
+
+namespace {
+
+// Draws a chart-like scene: many curved and straight paths sharing a handful of paints, which
+// is what most SVG exported from Skia looks like.
+class SVGCanvasBench : public Benchmark {
+public:
+    SVGCanvasBench(const char* name, uint32_t flags) : fFlags(flags) {
+        fName.printf("SVGCanvas_%s", name);
+    }
+
+private:
+    static constexpr SkScalar kSize = 1024;
+
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    void onDelayedSetup() override {
+        SkRandom rand;
+        auto coord = [&rand] { return rand.nextRangeScalar(0, kSize); };
+        for (int i = 0; i < 500; ++i) {
+            SkPath path;
+            path.moveTo(coord(), coord());
+            for (int j = 0; j < 8; ++j) {
+                if (rand.nextBool()) {
+                    path.cubicTo(coord(), coord(), coord(), coord(), coord(), coord());
+                } else {
+                    path.lineTo(coord(), coord());
+                }
+            }
+            fPaths.push_back(path);
+        }
+
+        static constexpr SkColor kColors[] = { 0xff1f77b4, 0xffff7f0e, 0xff2ca02c, 0x80d62728 };
+        for (SkColor color : kColors) {
+            SkPaint paint;
+            paint.setAntiAlias(true);
+            paint.setColor(color);
+            fPaints.push_back(paint);
+            paint.setStyle(SkPaint::kStroke_Style);
+            paint.setStrokeWidth(2);
+            fPaints.push_back(paint);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops-- > 0) {
+            SkNullWStream stream;
+            this->draw(&stream);
+        }
+    }
+
+    void draw(SkWStream* stream) {
+        auto canvas = SkSVGCanvas::Make(SkRect::MakeWH(kSize, kSize), stream, fFlags);
+        for (int i = 0; i < fPaths.size(); ++i) {
+            canvas->drawPath(fPaths[i], fPaints[i % fPaints.size()]);
+            canvas->drawRect(fPaths[i].getBounds(), fPaints[i % fPaints.size()]);
+        }
+    }
+
+    SkString fName;
+    const uint32_t fFlags;
+    SkTArray<SkPath> fPaths;
+    SkTArray<SkPaint> fPaints;
+};
+
+}  // namespace
+
+DEF_BENCH(return new SVGCanvasBench("default", 0);)
+DEF_BENCH(return new SVGCanvasBench("relative", SkSVGCanvas::kRelativePathEncoding_Flag);)
+DEF_BENCH(return new SVGCanvasBench("compact", SkSVGCanvas::kCompact_Flag);)
+DEF_BENCH(return new SVGCanvasBench("compact_nopretty", SkSVGCanvas::kCompact_Flag |
+                                                        SkSVGCanvas::kNoPrettyXML_Flag);)
+
+#endif  // SK_XML
@@ -5,10 +5,13 @@
 
 #if !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) && !defined(SK_BUILD_FOR_GOOGLE3)
 
+#include "include/core/SkExecutor.h"
 #include "modules/skshaper/include/SkShaper.h"
 #include "tools/Resources.h"
 
 #include <cfloat>
+#include <iterator>
+#include <vector>
 
 namespace {
 struct ShaperBench : public Benchmark {
@@ -35,8 +38,115 @@ struct ShaperBench : public Benchmark {
         }
     }
 };
+
+// Shapes short labels the way a UI does: a small set of captions and numbers, over and over.
+struct ShaperLabelBench : public Benchmark {
+    ShaperLabelBench(bool cached) : fCached(cached) {
+        fName.printf("shaper_labels_%s", cached ? "cached" : "uncached");
+    }
+    static constexpr int kLabels = 1000;
+    std::unique_ptr<SkShaper> fShaper;
+    std::vector<SkString> fLabels;
+    bool fCached;
+    SkString fName;
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    void onDelayedSetup() override {
+        fShaper = SkShaper::Make();
+        if (fCached) {
+            fShaper = SkShaper::MakeCached(std::move(fShaper), SkShaperCache::Make(1 << 20));
+        }
+        const char* captions[] = { "OK", "Cancel", "Save", "Open", "Close", "Settings", "Help",
+                                   "Back", "Next", "Done", "Edit", "Delete", "Share", "Search" };
+        // Captions come up far more often than any one number.
+        for (int i = 0; i < kLabels; ++i) {
+            if (i % 3) {
+                fLabels.push_back(SkString(captions[i % std::size(captions)]));
+            } else {
+                fLabels.push_back(SkStringPrintf("%d.%02d", (i * 37) % 200, i % 100));
+            }
+        }
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        if (!fShaper) { return; }
+        SkFont font;
+        while (loops-- > 0) {
+            for (const SkString& label : fLabels) {
+                SkTextBlobBuilderRunHandler rh(label.c_str(), {0, 0});
+                fShaper->shape(label.c_str(), label.size(), font, true, FLT_MAX, &rh);
+                (void)rh.makeBlob();
+            }
+        }
+    }
+};
+
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+// Shapes every word of a text as its own run and builds a blob from them, with the runs spread
+// over a pool of threads, or one at a time when threads is 0.
+struct ShaperBatchBench : public Benchmark {
+    ShaperBatchBench(int threads) : fThreads(threads) {
+        fName.printf("shaper_batch_%d", threads);
+    }
+    static constexpr int kCopies = 16;
+    sk_sp<SkData> fData;
+    std::unique_ptr<SkExecutor> fExecutor;
+    std::vector<SkShaper::BatchRun> fRuns;
+    int fThreads;
+    SkString fName;
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    void onDelayedSetup() override {
+        fData = GetResourceAsData("text/english.txt");
+        if (!fData) {
+            return;
+        }
+        if (fThreads > 0) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+        const char* text = (const char*)fData->data();
+        const size_t size = fData->size();
+        SkFont font;
+        for (int copy = 0; copy < kCopies; ++copy) {
+            for (size_t start = 0; start < size;) {
+                size_t end = start;
+                while (end < size && text[end] != ' ') {
+                    ++end;
+                }
+                fRuns.push_back({text + start, end - start, font, 0, "en", true});
+                start = end + 1;
+            }
+        }
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        if (!fData) { return; }
+        while (loops-- > 0) {
+            SkTextBlobBuilder builder;
+            if (fExecutor) {
+                SkShaper::BatchResult batch = SkShaper::ShapeBatch(fRuns, fExecutor.get());
+                for (size_t i = 0; i < fRuns.size(); ++i) {
+                    batch.appendRun(i, &builder, {0, 0});
+                }
+            } else {
+                for (const SkShaper::BatchRun& run : fRuns) {
+                    SkShaper::ShapeBatch(SkSpan(&run, 1)).appendRun(0, &builder, {0, 0});
+                }
+            }
+            (void)builder.make();
+        }
+    }
+};
+#endif
 }  // namespace
 
+DEF_BENCH(return new ShaperLabelBench(false);)
+DEF_BENCH(return new ShaperLabelBench(true);)
+
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+DEF_BENCH(return new ShaperBatchBench(0);)
+DEF_BENCH(return new ShaperBatchBench(1);)
+DEF_BENCH(return new ShaperBatchBench(4);)
+#endif
+
 #define SHAPER_BENCH(X) DEF_BENCH(return new ShaperBench("text/" #X ".txt", "shaper_" #X);)
 SHAPER_BENCH(arabic)
 SHAPER_BENCH(armenian)
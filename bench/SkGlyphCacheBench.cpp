@@ -10,9 +10,12 @@
 #include "bench/Benchmark.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColorSpace.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkGraphics.h"
 #include "include/core/SkTypeface.h"
 #include "include/private/chromium/SkChromeRemoteGlyphCache.h"
+#include "src/core/SkPersistentGlyphCache.h"
+#include "src/core/SkStrikeCache.h"
 #include "src/core/SkStrikeSpec.h"
 #include "src/core/SkTLazy.h"
 #include "src/core/SkTaskGroup.h"
@@ -20,6 +23,10 @@
 #include "tools/Resources.h"
 #include "tools/ToolUtils.h"
 
+#if defined(SK_TYPEFACE_FREETYPE)
+#include "src/ports/SkFontHost_FreeType_common.h"
+#endif
+
 static void do_font_stuff(SkFont* font) {
     SkPaint defaultPaint;
     for (SkScalar i = 8; i < 64; i++) {
@@ -118,6 +125,209 @@ DEF_BENCH( return new SkGlyphCacheBasic(32 * 1024 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(256 * 1024); )
 DEF_BENCH( return new SkGlyphCacheStressTest(32 * 1024 * 1024); )
 
+#if defined(SK_TYPEFACE_FREETYPE)
+// Rasterizes glyphs nobody has asked for yet from several threads at once, each in its own strike,
+// with FreeType faces either shared behind the global lock or opened per thread.
+class FreeTypeColdGlyphsBench : public Benchmark {
+public:
+    FreeTypeColdGlyphsBench(int threads, bool perThreadFaces)
+            : fThreads(threads), fPerThreadFaces(perThreadFaces) {
+        fName.printf("FreeTypeColdGlyphs_%s_%d",
+                     perThreadFaces ? "perthread" : "shared", threads);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        // A typeface from data, so the default font manager (FreeType based) opens it.
+        fTypeface = SkTypeface::MakeFromStream(GetResourceAsStream("fonts/Distortable.ttf"));
+        if (!fTypeface) {
+            fTypeface = ToolUtils::create_portable_typeface("serif", SkFontStyle());
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        const bool oldPerThreadFaces = SkTypeface_FreeType::GetPerThreadFaces();
+        SkTypeface_FreeType::SetPerThreadFaces(fPerThreadFaces);
+
+        for (int work = 0; work < loops; work++) {
+            // Start from an empty cache so every strike has to go to the scaler context.
+            SkGraphics::PurgeFontCache();
+            SkTaskGroup().batch(fThreads, [&](int threadIndex) {
+                SkFont font(fTypeface);
+                font.setEdging(SkFont::Edging::kAntiAlias);
+                SkPaint defaultPaint;
+                // Sizes are distinct per thread, so no two threads share a strike.
+                for (int size = 8 + threadIndex; size < 8 + 32 * fThreads; size += fThreads) {
+                    font.setSize(size);
+                    auto strikeSpec = SkStrikeSpec::MakeMask(
+                            font, defaultPaint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                            SkScalerContextFlags::kNone, SkMatrix::I());
+                    SkPackedGlyphID glyphs['z' - ' '];
+                    for (int c = ' '; c < 'z'; c++) {
+                        glyphs[c - ' '] = SkPackedGlyphID{font.unicharToGlyph(c)};
+                    }
+                    SkBulkGlyphMetricsAndImages images{strikeSpec};
+                    (void)images.glyphs(glyphs);
+                }
+            });
+        }
+
+        SkTypeface_FreeType::SetPerThreadFaces(oldPerThreadFaces);
+    }
+
+private:
+    const int fThreads;
+    const bool fPerThreadFaces;
+    sk_sp<SkTypeface> fTypeface;
+    SkString fName;
+};
+
+DEF_BENCH( return new FreeTypeColdGlyphsBench(1, false); )
+DEF_BENCH( return new FreeTypeColdGlyphsBench(1, true); )
+DEF_BENCH( return new FreeTypeColdGlyphsBench(4, false); )
+DEF_BENCH( return new FreeTypeColdGlyphsBench(4, true); )
+DEF_BENCH( return new FreeTypeColdGlyphsBench(16, false); )
+DEF_BENCH( return new FreeTypeColdGlyphsBench(16, true); )
+#endif
+
+// Rasterizes a page worth of stroked CJK glyphs into a cold cache in one batch. Stroked glyphs are
+// drawn from their paths, which is what the batch can spread over the threads of the default
+// executor. Filled glyphs come from the font's own rasterizer one at a time, so they are not
+// measured here.
+class ColdGlyphImagesBench : public Benchmark {
+public:
+    ColdGlyphImagesBench(int threads) : fThreads(threads) {
+        fName.printf("ColdGlyphImages_stroke_%d", threads);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        fTypeface = MakeResourceAsTypeface("fonts/NotoSansCJK-VF-subset.otf.ttc");
+        if (!fTypeface) {
+            fTypeface = ToolUtils::create_portable_typeface("serif", SkFontStyle());
+        }
+        const int glyphCount = std::min(fTypeface->countGlyphs(), 2048);
+        for (int i = 0; i < glyphCount; ++i) {
+            fGlyphs.push_back(SkPackedGlyphID{SkTo<SkGlyphID>(i)});
+        }
+        if (fThreads > 0) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool(fThreads);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        SkExecutor& oldExecutor = SkExecutor::GetDefault();
+        SkExecutor::SetDefault(fExecutor.get());
+
+        SkFont font(fTypeface, 24);
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        SkPaint paint;
+        paint.setStyle(SkPaint::kStroke_Style);
+        paint.setStrokeWidth(1);
+        auto strikeSpec = SkStrikeSpec::MakeMask(
+                font, paint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I());
+
+        for (int work = 0; work < loops; work++) {
+            SkGraphics::PurgeFontCache();
+            SkBulkGlyphMetricsAndImages images{strikeSpec};
+            (void)images.glyphs(fGlyphs);
+        }
+
+        SkExecutor::SetDefault(&oldExecutor);
+    }
+
+private:
+    const int fThreads;
+    sk_sp<SkTypeface> fTypeface;
+    std::vector<SkPackedGlyphID> fGlyphs;
+    std::unique_ptr<SkExecutor> fExecutor;
+    SkString fName;
+};
+
+DEF_BENCH( return new ColdGlyphImagesBench(0); )
+DEF_BENCH( return new ColdGlyphImagesBench(4); )
+DEF_BENCH( return new ColdGlyphImagesBench(8); )
+
+#if defined(SK_BUILD_FOR_ANDROID)
+static constexpr const char* kPersistentGlyphDir = "/data/local/tmp/bench_glyphs";
+#else
+static constexpr const char* kPersistentGlyphDir = "/tmp/bench_glyphs";
+#endif
+
+// The glyph work of a process starting up and drawing a page of CJK text, with the glyph images
+// rasterized or read back from a persistent glyph cache another process filled.
+class ColdStartGlyphsBench : public Benchmark {
+public:
+    explicit ColdStartGlyphsBench(bool persistent) : fPersistent(persistent) {
+        fName.printf("ColdStartGlyphs_%s", persistent ? "persistent" : "rasterize");
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onDelayedSetup() override {
+        sk_sp<SkTypeface> typeface = MakeResourceAsTypeface("fonts/NotoSansCJK-VF-subset.otf.ttc");
+        if (!typeface) {
+            typeface = ToolUtils::create_portable_typeface("serif", SkFontStyle());
+        }
+        const int glyphCount = std::min(typeface->countGlyphs(), 2048);
+        for (int i = 0; i < glyphCount; ++i) {
+            fGlyphs.push_back(SkPackedGlyphID{SkTo<SkGlyphID>(i)});
+        }
+        SkFont font(typeface, 24);
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        fStrikeSpec.init(SkStrikeSpec::MakeMask(
+                font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I()));
+
+        if (fPersistent) {
+            fPersistentCache = SkPersistentGlyphCache::Make(kPersistentGlyphDir, 64 << 20);
+            this->startProcess();
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int work = 0; work < loops; work++) {
+            this->startProcess();
+        }
+    }
+
+private:
+    void startProcess() {
+        SkStrikeCache cache;
+        cache.setPersistentGlyphCache(fPersistentCache);
+        sk_sp<SkStrike> strike = fStrikeSpec->findOrCreateStrike(&cache);
+        std::vector<const SkGlyph*> results(fGlyphs.size());
+        (void)strike->prepareImages(fGlyphs, results.data());
+    }
+
+    const bool fPersistent;
+    SkTLazy<SkStrikeSpec> fStrikeSpec;
+    std::vector<SkPackedGlyphID> fGlyphs;
+    sk_sp<SkPersistentGlyphCache> fPersistentCache;
+    SkString fName;
+};
+
+DEF_BENCH( return new ColdStartGlyphsBench(false); )
+DEF_BENCH( return new ColdStartGlyphsBench(true); )
+
 namespace {
 class DiscardableManager : public SkStrikeServer::DiscardableHandleManager,
                            public SkStrikeClient::DiscardableHandleManager {
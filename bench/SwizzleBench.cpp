@@ -13,21 +13,35 @@ public:
 
     SwizzleBench(const char* name, SkOpts::Swizzle_8888_u32 fn) : fName(name), fFn_u32(fn) {}
     SwizzleBench(const char* name, SkOpts::Swizzle_8888_u8  fn) : fName(name), fFn_u8 (fn) {}
+    SwizzleBench(const char* name, decltype(SkOpts::index_to_8888) fn)
+            : fName(name), fFn_index(fn) {
+        for (int i = 0; i < K; i++) {
+            fSrc[i] = 0x01010101u * (uint32_t)(i & 0xFF);
+        }
+        for (int i = 0; i < 256; i++) {
+            fCTable[i] = 0xFF000000u | (uint32_t)(i * 0x010101);
+        }
+    }
 
     bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
     const char* onGetName() override { return fName; }
     void onDraw(int loops, SkCanvas*) override {
-        static const int K = 1023; // Arbitrary, but nice to be a non-power-of-two to trip up SIMD.
         uint32_t dst[K], src[K];
         while (loops --> 0) {
-            if (fFn_u32) { fFn_u32(dst,                 src, K); }
-            if (fFn_u8)  { fFn_u8 (dst, (const uint8_t*)src, K); }
+            if (fFn_u32)   { fFn_u32  (dst,                 src, K); }
+            if (fFn_u8)    { fFn_u8   (dst, (const uint8_t*)src, K); }
+            if (fFn_index) { fFn_index(dst, (const uint8_t*)fSrc, K, fCTable); }
         }
     }
 private:
+    static constexpr int K = 1023; // Arbitrary, but nice to be a non-power-of-two to trip up SIMD.
+
+    uint32_t fSrc[K];
+    uint32_t fCTable[256];
     const char* fName;
     SkOpts::Swizzle_8888_u32 fFn_u32 = nullptr;
     SkOpts::Swizzle_8888_u8  fFn_u8  = nullptr;
+    decltype(SkOpts::index_to_8888) fFn_index = nullptr;
 };
 
 
@@ -39,5 +53,6 @@ DEF_BENCH(return new SwizzleBench("SkOpts::RGB_to_BGR1",  SkOpts::RGB_to_BGR1));
 DEF_BENCH(return new SwizzleBench("SkOpts::gray_to_RGB1", SkOpts::gray_to_RGB1));
 DEF_BENCH(return new SwizzleBench("SkOpts::grayA_to_RGBA", SkOpts::grayA_to_RGBA));
 DEF_BENCH(return new SwizzleBench("SkOpts::grayA_to_rgbA", SkOpts::grayA_to_rgbA));
+DEF_BENCH(return new SwizzleBench("SkOpts::index_to_8888", SkOpts::index_to_8888));
 DEF_BENCH(return new SwizzleBench("SkOpts::inverted_CMYK_to_RGB1", SkOpts::inverted_CMYK_to_RGB1));
 DEF_BENCH(return new SwizzleBench("SkOpts::inverted_CMYK_to_BGR1", SkOpts::inverted_CMYK_to_BGR1));
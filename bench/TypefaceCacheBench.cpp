@@ -0,0 +1,78 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkString.h"
+#include "include/core/SkTypeface.h"
+#include "include/private/base/SkTArray.h"
+#include "src/core/SkTypefaceCache.h"
+#include "tools/fonts/TestEmptyTypeface.h"
+
+namespace {
+
+// Looks up every typeface in a cache the size a document renderer builds up, the way font
+// managers do when matching: by scanning with a FindProc, or by key.
+class TypefaceCacheLookupBench : public Benchmark {
+public:
+    TypefaceCacheLookupBench(int count, bool byKey) : fCount(count), fByKey(byKey) {
+        fName.printf("TypefaceCacheLookup_%s_%d", byKey ? "key" : "proc", count);
+    }
+
+private:
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    static SkTypefaceCache::Key MakeKey(int i) {
+        SkTypefaceCache::Key key;
+        key.fIdentity.printf("/usr/share/fonts/truetype/family%d/Regular.ttf", i / 4);
+        key.fIndex = i % 4;
+        return key;
+    }
+
+    void onDelayedSetup() override {
+        for (int i = 0; i < fCount; ++i) {
+            sk_sp<SkTypeface> typeface = TestEmptyTypeface::Make();
+            fKeys.push_back(MakeKey(i));
+            fIDs.push_back(typeface->uniqueID());
+            fCache.add(typeface, fKeys.back());
+            fTypefaces.push_back(std::move(typeface));
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops-- > 0) {
+            for (int i = 0; i < fCount; ++i) {
+                sk_sp<SkTypeface> found;
+                if (fByKey) {
+                    found = fCache.findByKeyAndRef(fKeys[i]);
+                } else {
+                    SkTypefaceID id = fIDs[i];
+                    found = fCache.findByProcAndRef([](SkTypeface* typeface, void* ctx) {
+                        return typeface->uniqueID() == *static_cast<SkTypefaceID*>(ctx);
+                    }, &id);
+                }
+                SkASSERT(found);
+            }
+        }
+    }
+
+    const int fCount;
+    const bool fByKey;
+    SkString fName;
+    SkTypefaceCache fCache;
+    SkTArray<sk_sp<SkTypeface>> fTypefaces;
+    SkTArray<SkTypefaceCache::Key> fKeys;
+    SkTArray<SkTypefaceID> fIDs;
+};
+
+}  // namespace
+
+DEF_BENCH(return new TypefaceCacheLookupBench(100, false);)
+DEF_BENCH(return new TypefaceCacheLookupBench(100, true);)
+DEF_BENCH(return new TypefaceCacheLookupBench(2000, false);)
+DEF_BENCH(return new TypefaceCacheLookupBench(2000, true);)
@@ -210,9 +210,15 @@ public:
     //        these Options when SkCodec has a slightly different set of Options.  Maybe these
     //        should be DecodeOptions or SamplingOptions?
     struct AndroidOptions : public SkCodec::Options {
+        enum class Downsample {
+            kPoint,
+            kAreaAverage,
+        };
+
         AndroidOptions()
             : SkCodec::Options()
             , fSampleSize(1)
+            , fDownsample(Downsample::kPoint)
         {}
 
         /**
@@ -223,6 +229,22 @@ public:
          *  The default is 1, representing no downscaling.
          */
         int fSampleSize;
+
+        /**
+         *  How to shrink the image when the requested size is smaller than the encoded size.
+         *
+         *  kPoint keeps one source pixel out of every fSampleSize in each dimension.
+         *
+         *  kAreaAverage box-filters every source pixel that falls under each destination pixel
+         *  as rows come out of the decoder, so the full-size image is never materialized. Any
+         *  destination size no larger than the encoded size is accepted, and fSampleSize is
+         *  ignored. This is currently limited to 8-bit-per-channel color types with premul or
+         *  opaque alpha, top-down scanline orders, and no fSubset; other requests return
+         *  kUnimplemented.
+         *
+         *  The default is kPoint.
+         */
+        Downsample fDownsample;
     };
 
     /**
@@ -194,6 +194,45 @@ public:
      */
     static std::unique_ptr<SkCodec> MakeFromData(sk_sp<SkData>, SkPngChunkReader* = nullptr);
 
+    /**
+     *  What ProbeInfo() can learn about an encoded image from its headers alone.
+     */
+    struct ProbeResult {
+        SkEncodedImageFormat fFormat = SkEncodedImageFormat::kBMP;
+
+        /**
+         *  The encoded dimensions, before fOrigin is applied (i.e. the same as
+         *  SkCodec::dimensions()).
+         */
+        SkISize              fDimensions = {0, 0};
+        SkEncodedOrigin      fOrigin = kDefault_SkEncodedOrigin;
+
+        /**
+         *  Whether the image carries an embedded color profile (or, for PNG, an sRGB chunk).
+         */
+        bool                 fHasColorProfile = false;
+
+        /**
+         *  If the ICC profile is stored uncompressed and in one piece, this points at it
+         *  inside the data passed to ProbeInfo(), and is only valid as long as that data is.
+         *  Otherwise this is nullptr even if fHasColorProfile is true; use a full codec to
+         *  read it.
+         */
+        const uint8_t*       fICCProfile = nullptr;
+        size_t               fICCProfileSize = 0;
+    };
+
+    /**
+     *  Parse just enough of |data| to fill out |result|, without creating a decoder or
+     *  allocating memory. This is much cheaper than MakeFromData() when only the size,
+     *  orientation or presence of a color profile is needed.
+     *
+     *  Supports JPEG, PNG, WEBP and GIF when the corresponding decoder is compiled in. Returns
+     *  false if the format is not recognized or not supported, or if the headers are
+     *  truncated or malformed.
+     */
+    static bool ProbeInfo(const void* data, size_t length, ProbeResult* result);
+
     virtual ~SkCodec();
 
     /**
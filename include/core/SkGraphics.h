@@ -73,6 +73,15 @@ public:
      */
     static void PurgeFontCache();
 
+    /**
+     *  Keep the glyph images of the font cache in files in the directory, so that processes
+     *  rendering the same text can reuse each other's glyphs instead of rasterizing them again.
+     *  The files are kept under byteBudget bytes in total, deleting the least recently written
+     *  ones first. Only affects strikes created afterwards. Pass nullptr to stop using files.
+     *  Returns false if the directory cannot be created.
+     */
+    static bool SetPersistentFontCache(const char directory[], size_t byteBudget);
+
     /**
      *  This function returns the memory used for temporary images and other resources.
      */
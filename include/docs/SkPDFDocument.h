@@ -5,11 +5,15 @@
 
 #include "include/core/SkDocument.h"
 
+#include <functional>
 #include <vector>
 
 #include "include/core/SkColor.h"
 #include "include/core/SkMilestone.h"
+#include "include/core/SkPicture.h"
 #include "include/core/SkScalar.h"
+#include "include/core/SkSize.h"
+#include "include/core/SkSpan.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTime.h"
 #include "include/private/SkNoncopyable.h"
@@ -63,6 +67,21 @@ struct StructureElementNode {
     SkString fLang;
 };
 
+/** Counters describing how many images and form XObjects were found to have
+    the same content as one already in the document, and were shared instead
+    of being written again.
+*/
+struct DedupStats {
+    int fImagesDeduplicated = 0;
+    int fFormXObjectsDeduplicated = 0;
+
+    /** Bytes the duplicate objects would have added to the output. */
+    size_t fBytesSaved = 0;
+
+    /** Time spent computing content hashes, in milliseconds. */
+    double fHashingMs = 0;
+};
+
 /** Optional metadata to be passed into the PDF factory function.
 */
 struct Metadata {
@@ -154,6 +173,36 @@ struct Metadata {
         HighButSlow = 9,
     } fCompressionLevel = CompressionLevel::Default;
 
+    /** If true, each page is written to the stream as soon as it ends and the
+        page tree is built incrementally, instead of keeping every page
+        dictionary in memory until close().  Memory use then stays roughly
+        flat as pages are added; only font subsetting and objects shared
+        between pages are deferred until close().  The page tree has a
+        slightly different shape than the one written by default.
+
+        Experimental.
+    */
+    bool fStreamPages = false;
+
+    /** If true, write a PDF 1.5 file that packs dictionaries and other
+        non-stream objects into compressed object streams, and replaces the
+        cross-reference table with a compressed cross-reference stream.  This
+        makes documents with many small graphic-state, font and page
+        dictionaries substantially smaller.  Readers older than PDF 1.5
+        cannot open these files.
+
+        Ignored when fPDFA is true, since PDF/A-1 does not allow object
+        streams.  With fStreamPages, the objects of each page are packed into
+        an object stream of their own when the page ends, so pages are still
+        written as they end but compress less well.
+    */
+    bool fUseObjectStreams = false;
+
+    /** If not null, filled in with content deduplication counters when the
+        document is closed.  The caller should retain ownership.
+    */
+    DedupStats* fDedupStats = nullptr;
+
     /** Preferred Subsetter. Only respected if both are compiled in.
 
         The Sfntly subsetter is deprecated.
@@ -164,6 +213,14 @@ struct Metadata {
         kHarfbuzz_Subsetter,
         kSfntly_Subsetter,
     } fSubsetter = kHarfbuzz_Subsetter;
+
+    /** If true, font subsets are kept in a small process-wide cache keyed by
+        typeface and glyph set, so that documents drawing the same glyphs with
+        the same SkTypeface reuse a subset instead of computing it again.
+
+        Experimental.
+    */
+    bool fCacheFontSubsets = false;
 };
 
 /** Associate a node ID with subsequent drawing commands in an
@@ -178,6 +235,35 @@ struct Metadata {
 */
 SK_API void SetNodeId(SkCanvas* dst, int nodeID);
 
+/** The content of one page passed to DrawPages().  If fPicture is set it is
+    drawn, otherwise fDraw is called with a canvas to draw the page into.
+*/
+struct Page {
+    SkSize fSize;
+    sk_sp<SkPicture> fPicture;
+    std::function<void(SkCanvas*)> fDraw;
+};
+
+/** Append a batch of pages to a document created by MakeDocument().
+
+    If an executor is given, the fDraw callbacks of different pages are run
+    concurrently, each into its own SkPictureRecorder, so they must not share
+    unsynchronized mutable state.  The recorded pages are then emitted into
+    the document in page order on the calling thread, so passing an executor
+    here does not change the output.  Pages given as an fPicture need no
+    recording and are only played back, in order, on the calling thread.
+
+    Experimental.
+
+    @param document  A document returned by MakeDocument(), with no page in progress.
+    @param pages     The pages to append, in order.
+    @param executor  Optional executor used to run the fDraw callbacks.  The
+                     document's Metadata::fExecutor is not used for this.
+*/
+SK_API void DrawPages(SkDocument* document,
+                      SkSpan<const Page> pages,
+                      SkExecutor* executor = nullptr);
+
 /** Create a PDF-backed document, writing the results into a SkWStream.
 
     PDF pages are sized in point units. 1 pt == 1/72 inch == 127/360 mm.
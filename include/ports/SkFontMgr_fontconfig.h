@@ -19,4 +19,17 @@ class SkFontMgr;
  */
 SK_API sk_sp<SkFontMgr> SkFontMgr_New_FontConfig(FcConfig* fc);
 
+/** As above, but starts from the family names and font matches saved in the file at
+ *  'snapshotPath' by an earlier font manager, if the installed fonts and FontConfig
+ *  configuration files have not changed since. The snapshot is (re)written by
+ *  SkFontMgr_FontConfig_WriteSnapshot and when the returned font manager is destroyed.
+ */
+SK_API sk_sp<SkFontMgr> SkFontMgr_New_FontConfig(FcConfig* fc, const char snapshotPath[]);
+
+/** Writes the snapshot of 'fontMgr' now, for font managers which are never destroyed.
+ *  'fontMgr' must have been created by SkFontMgr_New_FontConfig.
+ *  Returns false if it has no snapshot path or the file could not be written.
+ */
+SK_API bool SkFontMgr_FontConfig_WriteSnapshot(SkFontMgr* fontMgr);
+
 #endif // #ifndef SkFontMgr_fontconfig_DEFINED
@@ -23,8 +23,12 @@ public:
         kConvertTextToPaths_Flag   = 0x01, // emit text as <path>s
         kNoPrettyXML_Flag          = 0x02, // suppress newlines and tabs in output
         kRelativePathEncoding_Flag = 0x04, // use relative commands for path encoding
+        kCompact_Flag              = 0x08, // minimize output size (see below)
     };
 
+    /** Default number of decimals kept for coordinates in compact output. */
+    static constexpr int kDefaultPrecision = 2;
+
     /**
      *  Returns a new canvas that will generate SVG commands from its draw calls, and send
      *  them to the provided stream. Ownership of the stream is not transfered, and it must
@@ -37,6 +41,15 @@ public:
      *  SVG element).
      */
     static std::unique_ptr<SkCanvas> Make(const SkRect& bounds, SkWStream*, uint32_t flags = 0);
+
+    /**
+     *  As above, with the number of decimals (0-6) kept for coordinates when kCompact_Flag is
+     *  set. Compact output rounds coordinates to that precision, writes path data with the
+     *  shortest relative commands, shares repeated paints through CSS classes and buffers
+     *  writes to the stream.
+     */
+    static std::unique_ptr<SkCanvas> Make(const SkRect& bounds, SkWStream*, uint32_t flags,
+                                          int precision);
 };
 
 #endif
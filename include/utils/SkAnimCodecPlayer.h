@@ -12,11 +12,16 @@
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSize.h"
+#include "include/private/base/SkMutex.h"
+#include "include/private/base/SkSemaphore.h"
+#include "include/private/base/SkThreadAnnotations.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
+class SkExecutor;
 class SkImage;
 
 class SkAnimCodecPlayer {
@@ -51,16 +56,53 @@ public:
      */
     bool seek(uint32_t msec);
 
+    /**
+     *  Limits the total size of decoded frames kept around for reuse. When the budget is
+     *  exceeded, the least recently used frames (other than the current one) are dropped and
+     *  will be decoded again if needed. The default, 0, means unlimited.
+     */
+    void setFrameCacheBudget(size_t bytes);
+
+    /**
+     *  After each seek(), decode up to |depth| of the following frames on |executor| so that
+     *  they are ready by the time they are shown. Pass nullptr or a depth of 0 to turn this off.
+     *  The executor must outlive this player, or decode-ahead must be turned off first.
+     */
+    void setDecodeAhead(SkExecutor* executor, int depth);
+
+    struct CacheStats {
+        int    fHits       = 0;  // getFrame() calls answered from the frame cache
+        int    fMisses     = 0;  // getFrame() calls that had to decode
+        int    fPrefetched = 0;  // frames decoded ahead of time on the executor
+        int    fEvicted    = 0;  // frames dropped to stay within the budget
+        size_t fCacheBytes = 0;  // bytes of decoded frames currently held
+    };
+    CacheStats cacheStats() const;
+
 
 private:
+    // fMutex guards the codec and the frame cache, which decode-ahead touches from the executor.
+    mutable SkMutex                 fMutex;
     std::unique_ptr<SkCodec>        fCodec;
     SkImageInfo                     fImageInfo;
     std::vector<SkCodec::FrameInfo> fFrameInfos;
-    std::vector<sk_sp<SkImage> >    fImages;
+    std::vector<sk_sp<SkImage> >    fImages       SK_GUARDED_BY(fMutex);
+    std::vector<uint64_t>           fLastUsed     SK_GUARDED_BY(fMutex);
+    uint64_t                        fUseCounter   SK_GUARDED_BY(fMutex) = 0;
+    size_t                          fCacheBudget  SK_GUARDED_BY(fMutex) = 0;
+    CacheStats                      fStats        SK_GUARDED_BY(fMutex);
     int                             fCurrIndex = 0;
     uint32_t                        fTotalDuration;
 
-    sk_sp<SkImage> getFrameAt(int index);
+    SkExecutor*                     fExecutor = nullptr;
+    int                             fDecodeAhead = 0;
+    bool                            fDecodeAheadPending = false;
+    SkSemaphore                     fDecodeAheadDone;
+
+    sk_sp<SkImage> getFrameAt(int index) SK_REQUIRES(fMutex);
+    void purgeToBudget(int keepIndex) SK_REQUIRES(fMutex);
+    void waitForDecodeAhead();
+    void scheduleDecodeAhead();
 };
 
 #endif
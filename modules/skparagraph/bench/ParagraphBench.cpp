@@ -13,6 +13,7 @@
 
 #include <cfloat>
 #include "include/core/SkPictureRecorder.h"
+#include "src/core/SkTaskGroup.h"
 #include "modules/skparagraph/utils/TestFontCollection.h"
 
 using namespace skia::textlayout;
@@ -53,8 +54,111 @@ struct ParagraphBench : public Benchmark {
         }
     }
 };
+
+// Types a character in the middle of a long paragraph and deletes it again,
+// laying out the paragraph after each edit
+struct ParagraphEditBench : public Benchmark {
+    ParagraphEditBench(bool incremental) : fIncremental(incremental) {
+        fName.printf("paragraph_edit_%s", incremental ? "incremental" : "full");
+    }
+    sk_sp<SkData> fData;
+    bool fIncremental;
+    SkString fName;
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    void onDelayedSetup() override { fData = GetResourceAsData("text/english.txt"); }
+    void onDraw(int loops, SkCanvas*) override {
+        if (!fData) {
+            return;
+        }
+
+        const char* text = (const char*)fData->data();
+        const SkScalar width = 500;
+
+        auto fontCollection = sk_make_sp<FontCollection>();
+        fontCollection->setDefaultFontManager(SkFontMgr::RefDefault());
+        // Measure the layout, not the paragraph cache
+        fontCollection->getParagraphCache()->turnOn(false);
+        ParagraphStyle paragraph_style;
+        paragraph_style.turnHintingOff();
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.addText(text, fData->size());
+        auto paragraph = builder.Build();
+        paragraph->layout(width);
+
+        size_t position = fData->size() / 2;
+        while (position > 0 && (text[position] & 0xC0) == 0x80) {
+            --position;
+        }
+        while (loops-- > 0) {
+            if (!fIncremental) {
+                paragraph->markDirty();
+            }
+            paragraph->updateText(position, position, SkString("x"));
+            paragraph->layout(width);
+            if (!fIncremental) {
+                paragraph->markDirty();
+            }
+            paragraph->updateText(position, position + 1, SkString());
+            paragraph->layout(width);
+        }
+    }
+};
+
+// Lays out a set of distinct paragraphs from several threads that share one font collection,
+// and so one paragraph cache. After the first loop every layout is a cache hit.
+struct ParagraphThreadsBench : public Benchmark {
+    ParagraphThreadsBench(int threads) : fThreads(threads) {
+        fName.printf("paragraph_threads_%d", threads);
+    }
+    static constexpr int kParagraphs = 256;
+    sk_sp<SkData> fData;
+    int fThreads;
+    SkString fName;
+    std::vector<SkString> fTexts;
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    void onDelayedSetup() override {
+        fData = GetResourceAsData("text/english.txt");
+        if (!fData) {
+            return;
+        }
+        for (int i = 0; i < kParagraphs; ++i) {
+            fTexts.push_back(SkStringPrintf("%d ", i));
+            fTexts.back().append((const char*)fData->data(), fData->size());
+        }
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        if (!fData) {
+            return;
+        }
+
+        auto fontCollection = sk_make_sp<FontCollection>();
+        fontCollection->setDefaultFontManager(SkFontMgr::RefDefault());
+        ParagraphStyle paragraph_style;
+        paragraph_style.turnHintingOff();
+
+        while (loops-- > 0) {
+            SkTaskGroup().batch(fThreads, [&](int thread) {
+                for (int i = thread; i < kParagraphs; i += fThreads) {
+                    ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+                    builder.addText(fTexts[i].c_str(), fTexts[i].size());
+                    auto paragraph = builder.Build();
+                    paragraph->layout(500);
+                }
+            });
+        }
+    }
+};
 }  // namespace
 
+DEF_BENCH(return new ParagraphThreadsBench(1);)
+DEF_BENCH(return new ParagraphThreadsBench(4);)
+DEF_BENCH(return new ParagraphThreadsBench(16);)
+
+DEF_BENCH(return new ParagraphEditBench(false);)
+DEF_BENCH(return new ParagraphEditBench(true);)
+
 #define PARAGRAPH_BENCH(X) DEF_BENCH(return new ParagraphBench(50000, "text/" #X ".txt", "paragraph_" #X);)
 //PARAGRAPH_BENCH(arabic)
 //PARAGRAPH_BENCH(emoji)
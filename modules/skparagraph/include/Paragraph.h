@@ -71,12 +71,18 @@ public:
     virtual int32_t unresolvedGlyphs() = 0;
 
     // Experimental API that allows fast way to update some of "immutable" paragraph attributes
-    // but not the text itself
     virtual void updateTextAlign(TextAlign textAlign) = 0;
     virtual void updateFontSize(size_t from, size_t to, SkScalar fontSize) = 0;
     virtual void updateForegroundPaint(size_t from, size_t to, SkPaint paint) = 0;
     virtual void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) = 0;
 
+    // Replaces the text in [from:to) (UTF-8 indexes) with the given text that gets the style of
+    // the text before it. The next layout only shapes again the words around the edit and
+    // keeps the lines before it (if the width does not change).
+    // Paragraphs with placeholders are shaped again entirely; the edit removes the placeholders
+    // it touches.
+    virtual void updateText(size_t from, size_t to, SkString text) = 0;
+
     enum VisitorFlags {
         kWhiteSpace_VisitorFlag = 1 << 0,
     };
@@ -2,9 +2,11 @@
 #ifndef ParagraphCache_DEFINED
 #define ParagraphCache_DEFINED
 
+#include "include/core/SkString.h"
 #include "include/private/base/SkMutex.h"
-#include "src/core/SkLRUCache.h"
+#include <atomic>
 #include <functional>  // std::function
+#include <memory>
 
 #define PARAGRAPH_CACHE_STATS
 
@@ -15,9 +17,16 @@ class ParagraphImpl;
 class ParagraphCacheKey;
 class ParagraphCacheValue;
 
+// Shaped paragraphs keyed by their text and styles. The cache is split into shards, each with its
+// own lock and LRU list, so that paragraphs laid out on different threads rarely wait for each
+// other. The size of the cache is bounded by the memory its shaped results use, not by the
+// number of paragraphs.
 class ParagraphCache {
 public:
+    static constexpr size_t kDefaultByteBudget = 8 * 1024 * 1024;
+
     ParagraphCache();
+    explicit ParagraphCache(size_t byteBudget);
     ~ParagraphCache();
 
     void abandon();
@@ -25,39 +34,58 @@ public:
     bool updateParagraph(ParagraphImpl* paragraph);
     bool findParagraph(ParagraphImpl* paragraph);
 
+    // Evicts the least recently used paragraphs until the cache fits into the new budget.
+    void setByteBudget(size_t byteBudget);
+    size_t byteBudget() const { return fByteBudget.load(std::memory_order_relaxed); }
+    size_t bytesUsed() const;
+
+    struct Stats {
+        int fRequests;
+        int fHits;
+        int fMisses;
+        int fEvictions;
+    };
+    Stats stats() const;
+
     // For testing
     void setChecker(std::function<void(ParagraphImpl* impl, const char*, bool)> checker) {
         fChecker = std::move(checker);
     }
     void printStatistics();
     void turnOn(bool value) { fCacheIsOn = value; }
-    int count() { return fLRUCacheMap.count(); }
+    int count() const;
 
     bool isPossiblyTextEditing(ParagraphImpl* paragraph);
 
  private:
 
     struct Entry;
-    void updateFrom(const ParagraphImpl* paragraph, Entry* entry);
-    void updateTo(ParagraphImpl* paragraph, const Entry* entry);
+    struct Shard;
+    static constexpr int kShardBits = 4;
+    static constexpr int kShardCount = 1 << kShardBits;
 
-     mutable SkMutex fParagraphMutex;
-     std::function<void(ParagraphImpl* impl, const char*, bool)> fChecker;
+    Shard& shardFor(const ParagraphCacheKey& key) const;
+    // Drops the least recently used entries of the locked shard until it fits into bytes.
+    void purgeShard(Shard* shard, size_t bytes);
+    void updateTo(ParagraphImpl* paragraph, const ParagraphCacheValue& value);
+    void rememberLastCached(const ParagraphImpl* paragraph);
 
-    static const int kMaxEntries = 128;
+    std::function<void(ParagraphImpl* impl, const char*, bool)> fChecker;
 
-    struct KeyHash {
-        uint32_t operator()(const ParagraphCacheKey& key) const;
-    };
+    std::unique_ptr<Shard[]> fShards;
+    std::atomic<size_t> fByteBudget;
+    std::atomic<bool> fCacheIsOn;
 
-    SkLRUCache<ParagraphCacheKey, std::unique_ptr<Entry>, KeyHash> fLRUCacheMap;
-    bool fCacheIsOn;
-    ParagraphCacheValue* fLastCachedValue;
+    // The start and the end of the last paragraph added to the cache, for isPossiblyTextEditing
+    mutable SkMutex fLastCachedMutex;
+    SkString fLastCachedHead;
+    SkString fLastCachedTail;
 
 #ifdef PARAGRAPH_CACHE_STATS
-    int fTotalRequests;
-    int fCacheMisses;
-    int fHashMisses; // cache hit but hash table missed
+    std::atomic<int> fTotalRequests;   // lookups and insertions
+    std::atomic<int> fCacheHits;
+    std::atomic<int> fCacheMisses;
+    std::atomic<int> fEvictions;
 #endif
 };
 
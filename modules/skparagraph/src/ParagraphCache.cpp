@@ -1,9 +1,13 @@
 // Copyright 2019 Google LLC.
 #include <memory>
 
+#include "include/core/SkRefCnt.h"
+#include "include/private/SkChecksum.h"
 #include "modules/skparagraph/include/FontArguments.h"
 #include "modules/skparagraph/include/ParagraphCache.h"
 #include "modules/skparagraph/src/ParagraphImpl.h"
+#include "src/core/SkTHash.h"
+#include "src/core/SkTInternalLList.h"
 
 namespace skia {
 namespace textlayout {
@@ -51,6 +55,10 @@ public:
 
     const SkString& text() const { return fText; }
 
+    size_t bytes() const {
+        return fText.size() + fPlaceholders.size() * sizeof(Placeholder) + fTextStyles.size() * sizeof(Block);
+    }
+
 private:
     static uint32_t mix(uint32_t hash, uint32_t data);
     uint32_t computeHash() const;
@@ -62,7 +70,7 @@ private:
     uint32_t fHash;
 };
 
-class ParagraphCacheValue {
+class ParagraphCacheValue : public SkNVRefCnt<ParagraphCacheValue> {
 public:
     ParagraphCacheValue(ParagraphCacheKey&& key, const ParagraphImpl* paragraph)
         : fKey(std::move(key))
@@ -76,7 +84,12 @@ public:
         , fUTF16IndexForUTF8Index(paragraph->fUTF16IndexForUTF8Index)
         , fHasLineBreaks(paragraph->fHasLineBreaks)
         , fHasWhitespacesInside(paragraph->fHasWhitespacesInside)
-        , fTrailingSpaces(paragraph->fTrailingSpaces) { }
+        , fTrailingSpaces(paragraph->fTrailingSpaces) {
+        fBytes = computeBytes();
+    }
+
+    // The memory held by the shaped results, which is what the cache budget is spent on
+    size_t bytes() const { return fBytes; }
 
     // Input == key
     ParagraphCacheKey fKey;
@@ -94,8 +107,27 @@ public:
     bool fHasLineBreaks;
     bool fHasWhitespacesInside;
     TextIndex fTrailingSpaces;
+
+private:
+    size_t computeBytes() const;
+    size_t fBytes;
 };
 
+size_t ParagraphCacheValue::computeBytes() const {
+    size_t bytes = sizeof(ParagraphCacheValue) + fKey.bytes();
+    for (auto& run : fRuns) {
+        bytes += sizeof(Run) + run.size() * (sizeof(SkGlyphID) + 2 * sizeof(SkPoint) + sizeof(uint32_t));
+    }
+    bytes += fClusters.size() * sizeof(Cluster);
+    bytes += fClustersIndexFromCodeUnit.size() * sizeof(size_t);
+    bytes += fCodeUnitProperties.size() * sizeof(SkUnicode::CodeUnitFlags);
+    bytes += fWords.size() * sizeof(size_t);
+    bytes += fBidiRegions.size() * sizeof(SkUnicode::BidiRegion);
+    bytes += fUTF8IndexForUTF16Index.size() * sizeof(TextIndex);
+    bytes += fUTF16IndexForUTF8Index.size() * sizeof(size_t);
+    return bytes;
+}
+
 uint32_t ParagraphCacheKey::mix(uint32_t hash, uint32_t data) {
     hash += data;
     hash += (hash << 10);
@@ -163,10 +195,6 @@ uint32_t ParagraphCacheKey::computeHash() const {
     return hash;
 }
 
-uint32_t ParagraphCache::KeyHash::operator()(const ParagraphCacheKey& key) const {
-    return key.hash();
-}
-
 bool ParagraphCacheKey::operator==(const ParagraphCacheKey& other) const {
     if (fText.size() != other.fText.size()) {
         return false;
@@ -233,40 +261,90 @@ bool ParagraphCacheKey::operator==(const ParagraphCacheKey& other) const {
     return true;
 }
 
+// Special situation: (very) long paragraph that is close to the last formatted paragraph
+#define NOCACHE_PREFIX_LENGTH 40
+
 struct ParagraphCache::Entry {
 
-    Entry(ParagraphCacheValue* value) : fValue(value) {}
-    std::unique_ptr<ParagraphCacheValue> fValue;
+    Entry(sk_sp<const ParagraphCacheValue> value) : fValue(std::move(value)) {}
+    // Shared, so that a hit can be copied into the paragraph after the shard is unlocked
+    sk_sp<const ParagraphCacheValue> fValue;
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+};
+
+struct ParagraphCache::Shard {
+    struct Traits {
+        static const ParagraphCacheKey& GetKey(const Entry* entry) { return entry->fValue->fKey; }
+        static uint32_t Hash(const ParagraphCacheKey& key) { return key.hash(); }
+    };
+
+    ~Shard() { this->reset(); }
+
+    void reset() {
+        fMap.reset();
+        for (Entry* entry = fLRU.head(); entry; entry = fLRU.head()) {
+            fLRU.remove(entry);
+            delete entry;
+        }
+        fBytes = 0;
+    }
+
+    mutable SkMutex fMutex;
+    SkTHashTable<Entry*, ParagraphCacheKey, Traits> fMap;
+    SkTInternalLList<Entry> fLRU;
+    size_t fBytes = 0;
 };
 
-ParagraphCache::ParagraphCache()
+ParagraphCache::ParagraphCache() : ParagraphCache(kDefaultByteBudget) { }
+
+ParagraphCache::ParagraphCache(size_t byteBudget)
     : fChecker([](ParagraphImpl* impl, const char*, bool){ })
-    , fLRUCacheMap(kMaxEntries)
+    , fShards(new Shard[kShardCount])
+    , fByteBudget(byteBudget)
     , fCacheIsOn(true)
-    , fLastCachedValue(nullptr)
 #ifdef PARAGRAPH_CACHE_STATS
     , fTotalRequests(0)
+    , fCacheHits(0)
     , fCacheMisses(0)
-    , fHashMisses(0)
+    , fEvictions(0)
 #endif
 { }
 
 ParagraphCache::~ParagraphCache() { }
 
-void ParagraphCache::updateTo(ParagraphImpl* paragraph, const Entry* entry) {
+ParagraphCache::Shard& ParagraphCache::shardFor(const ParagraphCacheKey& key) const {
+    // The hash tables index by the low bits of the hash, so pick the shard by the high ones
+    return fShards[SkChecksum::CheapMix(key.hash()) >> (32 - kShardBits)];
+}
+
+void ParagraphCache::purgeShard(Shard* shard, size_t bytes) {
+    while (shard->fBytes > bytes) {
+        Entry* entry = shard->fLRU.tail();
+        SkASSERT(entry);
+        shard->fBytes -= entry->fValue->bytes();
+        shard->fMap.remove(entry->fValue->fKey);
+        shard->fLRU.remove(entry);
+        delete entry;
+#ifdef PARAGRAPH_CACHE_STATS
+        fEvictions.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+}
+
+void ParagraphCache::updateTo(ParagraphImpl* paragraph, const ParagraphCacheValue& value) {
 
     paragraph->fRuns.clear();
-    paragraph->fRuns = entry->fValue->fRuns;
-    paragraph->fClusters = entry->fValue->fClusters;
-    paragraph->fClustersIndexFromCodeUnit = entry->fValue->fClustersIndexFromCodeUnit;
-    paragraph->fCodeUnitProperties = entry->fValue->fCodeUnitProperties;
-    paragraph->fWords = entry->fValue->fWords;
-    paragraph->fBidiRegions = entry->fValue->fBidiRegions;
-    paragraph->fUTF8IndexForUTF16Index = entry->fValue->fUTF8IndexForUTF16Index;
-    paragraph->fUTF16IndexForUTF8Index = entry->fValue->fUTF16IndexForUTF8Index;
-    paragraph->fHasLineBreaks = entry->fValue->fHasLineBreaks;
-    paragraph->fHasWhitespacesInside = entry->fValue->fHasWhitespacesInside;
-    paragraph->fTrailingSpaces = entry->fValue->fTrailingSpaces;
+    paragraph->fRuns = value.fRuns;
+    paragraph->fClusters = value.fClusters;
+    paragraph->fClustersIndexFromCodeUnit = value.fClustersIndexFromCodeUnit;
+    paragraph->fCodeUnitProperties = value.fCodeUnitProperties;
+    paragraph->fWords = value.fWords;
+    paragraph->fBidiRegions = value.fBidiRegions;
+    paragraph->fUTF8IndexForUTF16Index = value.fUTF8IndexForUTF16Index;
+    paragraph->fUTF16IndexForUTF8Index = value.fUTF16IndexForUTF8Index;
+    paragraph->fHasLineBreaks = value.fHasLineBreaks;
+    paragraph->fHasWhitespacesInside = value.fHasWhitespacesInside;
+    paragraph->fTrailingSpaces = value.fTrailingSpaces;
     for (auto& run : paragraph->fRuns) {
         run.setOwner(paragraph);
     }
@@ -275,13 +353,52 @@ void ParagraphCache::updateTo(ParagraphImpl* paragraph, const Entry* entry) {
     }
 }
 
+void ParagraphCache::setByteBudget(size_t byteBudget) {
+    fByteBudget = byteBudget;
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexExclusive lock(fShards[i].fMutex);
+        this->purgeShard(&fShards[i], byteBudget / kShardCount);
+    }
+}
+
+size_t ParagraphCache::bytesUsed() const {
+    size_t bytes = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexExclusive lock(fShards[i].fMutex);
+        bytes += fShards[i].fBytes;
+    }
+    return bytes;
+}
+
+int ParagraphCache::count() const {
+    int count = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexExclusive lock(fShards[i].fMutex);
+        count += fShards[i].fMap.count();
+    }
+    return count;
+}
+
+ParagraphCache::Stats ParagraphCache::stats() const {
+    Stats stats = {0, 0, 0, 0};
+#ifdef PARAGRAPH_CACHE_STATS
+    stats.fRequests = fTotalRequests.load(std::memory_order_relaxed);
+    stats.fMisses = fCacheMisses.load(std::memory_order_relaxed);
+    stats.fHits = fCacheHits.load(std::memory_order_relaxed);
+    stats.fEvictions = fEvictions.load(std::memory_order_relaxed);
+#endif
+    return stats;
+}
+
 void ParagraphCache::printStatistics() {
+    Stats stats = this->stats();
     SkDebugf("--- Paragraph Cache ---\n");
-    SkDebugf("Total requests: %d\n", fTotalRequests);
-    SkDebugf("Cache misses: %d\n", fCacheMisses);
-    SkDebugf("Cache miss %%: %f\n", (fTotalRequests > 0) ? 100.f * fCacheMisses / fTotalRequests : 0.f);
-    int cacheHits = fTotalRequests - fCacheMisses;
-    SkDebugf("Hash miss %%: %f\n", (cacheHits > 0) ? 100.f * fHashMisses / cacheHits : 0.f);
+    SkDebugf("Total requests: %d\n", stats.fRequests);
+    SkDebugf("Cache hits: %d\n", stats.fHits);
+    SkDebugf("Cache misses: %d\n", stats.fMisses);
+    SkDebugf("Cache miss %%: %f\n", (stats.fRequests > 0) ? 100.f * stats.fMisses / stats.fRequests : 0.f);
+    SkDebugf("Evictions: %d\n", stats.fEvictions);
+    SkDebugf("Memory: %zu of %zu bytes in %d paragraphs\n", this->bytesUsed(), this->byteBudget(), this->count());
     SkDebugf("---------------------\n");
 }
 
@@ -290,14 +407,21 @@ void ParagraphCache::abandon() {
 }
 
 void ParagraphCache::reset() {
-    SkAutoMutexExclusive lock(fParagraphMutex);
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexExclusive lock(fShards[i].fMutex);
+        fShards[i].reset();
+    }
+    {
+        SkAutoMutexExclusive lock(fLastCachedMutex);
+        fLastCachedHead.reset();
+        fLastCachedTail.reset();
+    }
 #ifdef PARAGRAPH_CACHE_STATS
     fTotalRequests = 0;
+    fCacheHits = 0;
     fCacheMisses = 0;
-    fHashMisses = 0;
+    fEvictions = 0;
 #endif
-    fLRUCacheMap.reset();
-    fLastCachedValue = nullptr;
 }
 
 bool ParagraphCache::findParagraph(ParagraphImpl* paragraph) {
@@ -305,21 +429,35 @@ bool ParagraphCache::findParagraph(ParagraphImpl* paragraph) {
         return false;
     }
 #ifdef PARAGRAPH_CACHE_STATS
-    ++fTotalRequests;
+    fTotalRequests.fetch_add(1, std::memory_order_relaxed);
 #endif
-    SkAutoMutexExclusive lock(fParagraphMutex);
     ParagraphCacheKey key(paragraph);
-    std::unique_ptr<Entry>* entry = fLRUCacheMap.find(key);
+    Shard& shard = this->shardFor(key);
+    sk_sp<const ParagraphCacheValue> value;
+    {
+        SkAutoMutexExclusive lock(shard.fMutex);
+        Entry** entry = shard.fMap.find(key);
+        if (entry) {
+            if (*entry != shard.fLRU.head()) {
+                shard.fLRU.remove(*entry);
+                shard.fLRU.addToHead(*entry);
+            }
+            value = (*entry)->fValue;
+        }
+    }
 
-    if (!entry) {
+    if (!value) {
         // We have a cache miss
 #ifdef PARAGRAPH_CACHE_STATS
-        ++fCacheMisses;
+        fCacheMisses.fetch_add(1, std::memory_order_relaxed);
 #endif
         fChecker(paragraph, "missingParagraph", true);
         return false;
     }
-    updateTo(paragraph, entry->get());
+#ifdef PARAGRAPH_CACHE_STATS
+    fCacheHits.fetch_add(1, std::memory_order_relaxed);
+#endif
+    updateTo(paragraph, *value);
     fChecker(paragraph, "foundParagraph", true);
     return true;
 }
@@ -329,50 +467,75 @@ bool ParagraphCache::updateParagraph(ParagraphImpl* paragraph) {
         return false;
     }
 #ifdef PARAGRAPH_CACHE_STATS
-    ++fTotalRequests;
+    fTotalRequests.fetch_add(1, std::memory_order_relaxed);
 #endif
-    SkAutoMutexExclusive lock(fParagraphMutex);
-
     ParagraphCacheKey key(paragraph);
-    std::unique_ptr<Entry>* entry = fLRUCacheMap.find(key);
-    if (!entry) {
-        // isTooMuchMemoryWasted(paragraph) not needed for now
-        if (isPossiblyTextEditing(paragraph)) {
-            // Skip this paragraph
+    Shard& shard = this->shardFor(key);
+    {
+        SkAutoMutexExclusive lock(shard.fMutex);
+        if (shard.fMap.find(key)) {
+            // We do not have to update the paragraph
             return false;
         }
-        ParagraphCacheValue* value = new ParagraphCacheValue(std::move(key), paragraph);
-        fLRUCacheMap.insert(value->fKey, std::make_unique<Entry>(value));
-        fChecker(paragraph, "addedParagraph", true);
-        fLastCachedValue = value;
-        return true;
-    } else {
-        // We do not have to update the paragraph
+    }
+
+    // isTooMuchMemoryWasted(paragraph) not needed for now
+    if (isPossiblyTextEditing(paragraph)) {
+        // Skip this paragraph
         return false;
     }
-}
 
-// Special situation: (very) long paragraph that is close to the last formatted paragraph
-#define NOCACHE_PREFIX_LENGTH 40
-bool ParagraphCache::isPossiblyTextEditing(ParagraphImpl* paragraph) {
-    if (fLastCachedValue == nullptr) {
+    // Copy the shaped results before locking the shard
+    auto value = sk_make_sp<ParagraphCacheValue>(std::move(key), paragraph);
+    const size_t shardBudget = this->byteBudget() / kShardCount;
+    if (value->bytes() > shardBudget) {
+        // The paragraph alone would flush the whole shard
         return false;
     }
+    {
+        SkAutoMutexExclusive lock(shard.fMutex);
+        if (shard.fMap.find(value->fKey)) {
+            // Another thread has added it in the meantime
+            return false;
+        }
+        this->purgeShard(&shard, shardBudget - value->bytes());
+        Entry* entry = new Entry(value);
+        shard.fMap.set(entry);
+        shard.fLRU.addToHead(entry);
+        shard.fBytes += value->bytes();
+        fChecker(paragraph, "addedParagraph", true);
+    }
+    this->rememberLastCached(paragraph);
+    return true;
+}
+
+void ParagraphCache::rememberLastCached(const ParagraphImpl* paragraph) {
+    SkAutoMutexExclusive lock(fLastCachedMutex);
+    auto& text = paragraph->fText;
+    if (text.size() < NOCACHE_PREFIX_LENGTH) {
+        fLastCachedHead.reset();
+        fLastCachedTail.reset();
+        return;
+    }
+    fLastCachedHead.set(text.c_str(), NOCACHE_PREFIX_LENGTH);
+    fLastCachedTail.set(text.c_str() + text.size() - NOCACHE_PREFIX_LENGTH, NOCACHE_PREFIX_LENGTH);
+}
 
-    auto& lastText = fLastCachedValue->fKey.text();
+bool ParagraphCache::isPossiblyTextEditing(ParagraphImpl* paragraph) {
+    SkAutoMutexExclusive lock(fLastCachedMutex);
     auto& text = paragraph->fText;
 
-    if ((lastText.size() < NOCACHE_PREFIX_LENGTH) || (text.size() < NOCACHE_PREFIX_LENGTH)) {
+    if (fLastCachedHead.isEmpty() || (text.size() < NOCACHE_PREFIX_LENGTH)) {
         // Either last text or the current are too short
         return false;
     }
 
-    if (std::strncmp(lastText.c_str(), text.c_str(), NOCACHE_PREFIX_LENGTH) == 0) {
+    if (std::strncmp(fLastCachedHead.c_str(), text.c_str(), NOCACHE_PREFIX_LENGTH) == 0) {
         // Texts have the same starts
         return true;
     }
 
-    if (std::strncmp(lastText.c_str() + lastText.size() - NOCACHE_PREFIX_LENGTH, &text[text.size() - NOCACHE_PREFIX_LENGTH], NOCACHE_PREFIX_LENGTH) == 0) {
+    if (std::strncmp(fLastCachedTail.c_str(), &text[text.size() - NOCACHE_PREFIX_LENGTH], NOCACHE_PREFIX_LENGTH) == 0) {
         // Texts have the same ends
         return true;
     }
@@ -75,6 +75,8 @@ ParagraphImpl::ParagraphImpl(const SkString& text,
         , fText(text)
         , fState(kUnknown)
         , fUnresolvedGlyphs(0)
+        , fUnchangedLines(0)
+        , fReshapedText(EMPTY_TEXT)
         , fPicture(nullptr)
         , fStrutMetrics(false)
         , fOldWidth(0)
@@ -134,6 +136,7 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
     }
 
     if (fState < kShaped) {
+        fUnchangedLines = 0;
         // Check if we have the text in the cache and don't need to shape it again
         if (!fFontCollection->getParagraphCache()->findParagraph(this)) {
             if (fState < kIndexed) {
@@ -153,6 +156,7 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
                 this->resolveStrut();
                 this->computeEmptyMetrics();
                 this->fLines.clear();
+                this->fLineStarts.clear();
 
                 // Set the important values that are not zero
                 fWidth = floorWidth;
@@ -179,11 +183,14 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
     }
 
     if (fState == kShaped) {
+        // Keep the lines before the last text edit if they are wrapped for the same width
+        size_t unchangedLines = fOldWidth == floorWidth ? fUnchangedLines : 0;
+        fUnchangedLines = 0;
         this->resetContext();
         this->resolveStrut();
         this->computeEmptyMetrics();
-        this->fLines.clear();
-        this->breakShapedTextIntoLines(floorWidth);
+        this->fLines.pop_back_n(fLines.size() - SkToInt(unchangedLines));
+        this->breakShapedTextIntoLines(floorWidth, unchangedLines);
         fState = kLineBroken;
     }
 
@@ -524,9 +531,10 @@ bool ParagraphImpl::shapeTextIntoEndlessLine() {
     return result;
 }
 
-void ParagraphImpl::breakShapedTextIntoLines(SkScalar maxWidth) {
+void ParagraphImpl::breakShapedTextIntoLines(SkScalar maxWidth, size_t startLine) {
 
-    if (!fHasLineBreaks &&
+    if (startLine == 0 &&
+        !fHasLineBreaks &&
         !fHasWhitespacesInside &&
         fPlaceholders.size() == 1 &&
         fRuns.size() == 1 && fRuns[0].fAdvance.fX <= maxWidth) {
@@ -558,6 +566,7 @@ void ParagraphImpl::breakShapedTextIntoLines(SkScalar maxWidth) {
         if (this->strutEnabled()) {
             this->strutMetrics().updateLineMetrics(metrics);
         }
+        fLineStarts.clear();
         ClusterIndex trailingSpaces = fClusters.size();
         do {
             --trailingSpaces;
@@ -610,7 +619,8 @@ void ParagraphImpl::breakShapedTextIntoLines(SkScalar maxWidth) {
                     line.createEllipsis(maxWidth, getEllipsis(), true);
                 }
                 fLongestLine = std::max(fLongestLine, nearlyZero(advance.fX) ? widthWithSpaces : advance.fX);
-            });
+            },
+            startLine);
 
     fHeight = textWrapper.height();
     fWidth = maxWidth;
@@ -1055,6 +1065,362 @@ void ParagraphImpl::updateBackgroundPaint(size_t from, size_t to, SkPaint paint)
     }
 }
 
+void ParagraphImpl::updateText(size_t from, size_t to, SkString text) {
+    SkASSERT(from <= to && to <= fText.size());
+
+    // Find the words around the edit while we still have the old clusters
+    // (paragraphs with placeholders are always shaped again entirely)
+    ClusterRange window = EMPTY_RANGE;
+    auto reshape = fState >= kShaped && fPlaceholders.size() == 1 &&
+                   this->findReshapeWindow(TextRange(from, to), &window);
+    TextRange textWindow = EMPTY_TEXT;
+    size_t unchangedLines = 0;
+    if (reshape) {
+        textWindow = TextRange(fClusters[window.start].textRange().start,
+                               fClusters[window.end].textRange().start);
+        if (!fParagraphStyle.ellipsized() && !fLineStarts.empty()) {
+            // The line before the window can take the first word from it
+            // (we only have the lines of the last layout or the ones the last edit did not touch)
+            size_t validLines = std::min(fState >= kLineBroken ? fLines.size() : fUnchangedLines,
+                                         SkToSizeT(fLines.size()));
+            while (unchangedLines < validLines &&
+                   fLines[unchangedLines].clustersWithSpaces().end <= window.start) {
+                ++unchangedLines;
+            }
+            unchangedLines = std::min(unchangedLines > 0 ? unchangedLines - 1 : 0,
+                                      SkToSizeT(fLineStarts.size() - 1));
+        }
+    }
+
+    SkString newText(fText.c_str(), from);
+    newText.append(text);
+    newText.append(fText.c_str() + to, fText.size() - to);
+    fText = std::move(newText);
+
+    // The inserted text takes the style of the text before it (unless it is a placeholder)
+    const TextIndex inserted = from + text.size();
+    auto moveStart = [from, to, inserted](TextIndex index) {
+        return index == 0 || index < from ? index : index >= to ? index - to + inserted : inserted;
+    };
+    auto moveEnd = [from, to, inserted](TextIndex index) {
+        return index < from ? index : index >= to ? index - to + inserted : inserted;
+    };
+    SkTArray<Block, true> blocks;
+    bool afterPlaceholder = false;
+    for (auto& block : fTextStyles) {
+        TextRange range(afterPlaceholder && block.fRange.start == from
+                                ? from
+                                : moveStart(block.fRange.start),
+                        moveEnd(block.fRange.end));
+        afterPlaceholder = block.fStyle.isPlaceholder() && block.fRange.end == from &&
+                           &block != &fTextStyles.back();
+        if (afterPlaceholder) {
+            range.end = from;
+        }
+        if (range.width() > 0 || (blocks.empty() && &block == &fTextStyles.back())) {
+            blocks.emplace_back(range, block.fStyle);
+        }
+    }
+    fTextStyles = std::move(blocks);
+
+    // The edit removes the placeholders it touches and moves the ones after it
+    SkTArray<Placeholder, true> placeholders;
+    for (auto& placeholder : fPlaceholders) {
+        auto& range = placeholder.fRange;
+        if (&placeholder == &fPlaceholders.back()) {
+            range = TextRange(fText.size(), fText.size());
+        } else if (from < range.end && to > range.start) {
+            continue;
+        } else if (range.start >= to) {
+            range = TextRange(range.start - to + inserted, range.end - to + inserted);
+        }
+        placeholders.emplace_back(placeholder);
+    }
+    size_t blockIndex = 0;
+    for (auto& placeholder : placeholders) {
+        auto textStart = placeholders.begin() == &placeholder ? 0 : (&placeholder - 1)->fRange.end;
+        auto blocksStart = blockIndex;
+        while (blockIndex < SkToSizeT(fTextStyles.size()) &&
+               fTextStyles[blockIndex].fRange.start < placeholder.fRange.start) {
+            ++blockIndex;
+        }
+        placeholder.fTextBefore = TextRange(textStart, placeholder.fRange.start);
+        placeholder.fBlocksBefore = BlockRange(blocksStart, blockIndex);
+        if (placeholder.fRange.width() > 0 && blockIndex < SkToSizeT(fTextStyles.size())) {
+            // Skip the placeholder's own block
+            ++blockIndex;
+        }
+    }
+    fPlaceholders = std::move(placeholders);
+
+    // Index the new text
+    auto oldBidiRegions = std::move(fBidiRegions);
+    fBidiRegions.clear();
+    fCodeUnitProperties.clear();
+    fWords.clear();
+    fUTF8IndexForUTF16Index.clear();
+    fUTF16IndexForUTF8Index.clear();
+    fillUTF16MappingOnce.emplace();
+    fHasLineBreaks = false;
+    fHasWhitespacesInside = false;
+    fPicture = nullptr;
+    fUnchangedLines = 0;
+
+    if (!reshape ||
+        !this->computeCodeUnitProperties() ||
+        !this->reshapeWindow(textWindow, TextRange(textWindow.start, moveEnd(textWindow.end)),
+                             oldBidiRegions)) {
+        // Shape the entire text on the next layout
+        fLines.clear();
+        fReshapedText = TextRange(0, fText.size());
+        fState = kUnknown;
+        return;
+    }
+
+    // The lines we keep point to runs that reshapeWindow moved
+    fLines.pop_back_n(fLines.size() - SkToInt(unchangedLines));
+    for (auto& line : fLines) {
+        line.resetTextBlobCache();
+    }
+    fUnchangedLines = unchangedLines;
+    fReshapedText = TextRange(textWindow.start, moveEnd(textWindow.end));
+    fState = kShaped;
+}
+
+// The window is a range of clusters that covers the edit. It starts and ends at word starts
+// (after whitespaces, where fonts do not kern or form ligatures) so the rest of the text
+// keeps its glyphs. The window can only cut left-to-right runs.
+bool ParagraphImpl::findReshapeWindow(TextRange edit, ClusterRange* window) {
+    if (fRuns.empty() || fClusters.empty() || fUnresolvedGlyphs > 0) {
+        return false;
+    }
+    for (auto& block : fTextStyles) {
+        if (!SkScalarNearlyZero(block.fStyle.getLetterSpacing()) ||
+            !SkScalarNearlyZero(block.fStyle.getWordSpacing())) {
+            // Spacing is applied to the entire text after shaping
+            return false;
+        }
+    }
+
+    const ClusterIndex last = fClusters.size() - 1;  // The empty cluster at the end of the text
+    auto canCutBefore = [this, last](ClusterIndex index) {
+        if (!fClusters[index - 1].isWhitespaceBreak()) {
+            return false;
+        } else if (index == last) {
+            return true;
+        }
+        auto& run = fRuns[fClusters[index].runIndex()];
+        return run.leftToRight() || run.clusterRange().start == index;
+    };
+
+    ClusterIndex start = this->clusterIndex(edit.start);
+    while (start > 0 && !canCutBefore(start)) {
+        --start;
+    }
+    ClusterIndex end = this->clusterIndex(edit.end);
+    if (end < last) {
+        ++end;
+    }
+    while (end < last && !canCutBefore(end)) {
+        ++end;
+    }
+
+    // The window is shaped in one direction
+    for (auto index = start; index < end; ++index) {
+        if (fRuns[fClusters[index].runIndex()].fBidiLevel !=
+            fRuns[fClusters[start].runIndex()].fBidiLevel) {
+            return false;
+        }
+    }
+
+    *window = ClusterRange(start, end);
+    return true;
+}
+
+bool ParagraphImpl::reshapeWindow(TextRange window,
+                                  TextRange newWindow,
+                                  const std::vector<SkUnicode::BidiRegion>& oldBidiRegions) {
+    if (fText.isEmpty()) {
+        return false;
+    }
+
+    // The edges of the window must still be word starts
+    auto isWordStart = [this](TextIndex index) {
+        return index == 0 || index == fText.size() ||
+               (this->codeUnitHasProperty(index, SkUnicode::CodeUnitFlags::kGraphemeStart) &&
+                this->codeUnitHasProperty(index - 1, SkUnicode::CodeUnitFlags::kPartOfWhiteSpaceBreak));
+    };
+    if (!isWordStart(newWindow.start) || !isWordStart(newWindow.end)) {
+        return false;
+    }
+
+    // The edit must not change the bidi levels outside of the window
+    auto moveIndex = [window, newWindow](TextIndex index) {
+        return index - window.end + newWindow.end;
+    };
+    if (oldBidiRegions.size() != fBidiRegions.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < fBidiRegions.size(); ++i) {
+        auto& oldRegion = oldBidiRegions[i];
+        auto& newRegion = fBidiRegions[i];
+        auto start = oldRegion.start <= window.start ? oldRegion.start
+                   : oldRegion.start >= window.end   ? moveIndex(oldRegion.start)
+                                                     : EMPTY_INDEX;
+        auto end = oldRegion.end >= window.end   ? moveIndex(oldRegion.end)
+                 : oldRegion.end <= window.start ? oldRegion.end
+                                                 : EMPTY_INDEX;
+        if (oldRegion.level != newRegion.level || start != newRegion.start || end != newRegion.end) {
+            return false;
+        }
+    }
+
+    SkTArray<Run, false> windowRuns;
+    SkTArray<ResolvedFontDescriptor> windowFonts;
+    if (newWindow.width() > 0) {
+        const SkUnicode::BidiRegion* bidiRegion = nullptr;
+        for (auto& region : fBidiRegions) {
+            if (region.start <= newWindow.start && newWindow.end <= region.end) {
+                bidiRegion = &region;
+                break;
+            }
+        }
+        if (bidiRegion == nullptr) {
+            return false;
+        }
+
+        // Shape the window as a separate paragraph
+        SkTArray<Block, true> blocks;
+        for (auto& block : fTextStyles) {
+            auto range = block.fRange * newWindow;
+            if (range.width() > 0) {
+                blocks.emplace_back(range.start - newWindow.start,
+                                    range.end - newWindow.start,
+                                    block.fStyle);
+            }
+        }
+        SkTArray<Placeholder, true> placeholders;
+        placeholders.emplace_back(newWindow.width(), newWindow.width(), PlaceholderStyle(),
+                                  fParagraphStyle.getTextStyle(), BlockRange(0, blocks.size()),
+                                  TextRange(0, newWindow.width()));
+        ParagraphImpl paragraph(SkString(fText.c_str() + newWindow.start, newWindow.width()),
+                                fParagraphStyle,
+                                std::move(blocks),
+                                std::move(placeholders),
+                                fFontCollection,
+                                fUnicode);
+        if (!paragraph.computeCodeUnitProperties()) {
+            return false;
+        }
+        // The window has the direction it has in the entire text
+        paragraph.fBidiRegions.clear();
+        paragraph.fBidiRegions.emplace_back(0, newWindow.width(), bidiRegion->level);
+
+        OneLineShaper oneLineShaper(&paragraph);
+        if (!oneLineShaper.shape() || oneLineShaper.unresolvedGlyphs() > 0) {
+            return false;
+        }
+        windowRuns = std::move(paragraph.fRuns);
+        windowFonts = std::move(paragraph.fFontSwitches);
+    }
+
+    // Put the new runs between the old runs (or their pieces) before and after the window;
+    // the old clusters still point to the old runs
+    auto& startCluster = fClusters[this->clusterIndex(window.start)];
+    auto& endCluster = fClusters[this->clusterIndex(window.end)];
+    SkTArray<Run, false> runs;
+    for (auto& run : fRuns) {
+        if (run.fTextRange.start >= window.start) {
+            break;
+        } else if (run.fTextRange.end <= window.start) {
+            runs.emplace_back(std::move(run));
+        } else {
+            this->appendRunPiece(&runs, run, GlyphRange(0, startCluster.startPos()),
+                                 run.fClusterStart);
+        }
+    }
+    for (auto& run : windowRuns) {
+        auto& windowRun = runs.emplace_back(std::move(run));
+        windowRun.fOwner = this;
+        windowRun.fTextRange = TextRange(windowRun.fTextRange.start + newWindow.start,
+                                         windowRun.fTextRange.end + newWindow.start);
+        windowRun.fClusterStart += newWindow.start;
+    }
+    for (auto& run : fRuns) {
+        if (run.fTextRange.end <= window.end) {
+            continue;
+        } else if (run.fTextRange.start >= window.end) {
+            auto& movedRun = runs.emplace_back(std::move(run));
+            movedRun.fTextRange = TextRange(moveIndex(movedRun.fTextRange.start),
+                                            moveIndex(movedRun.fTextRange.end));
+            movedRun.fClusterStart = moveIndex(movedRun.fClusterStart);
+        } else {
+            this->appendRunPiece(&runs, run, GlyphRange(endCluster.startPos(), run.size()),
+                                 moveIndex(run.fClusterStart));
+        }
+    }
+    for (int i = 0; i < runs.size(); ++i) {
+        runs[i].fIndex = i;
+    }
+
+    SkTArray<ResolvedFontDescriptor> fonts;
+    for (auto& font : fFontSwitches) {
+        if (font.fTextStart < window.start) {
+            fonts.emplace_back(font);
+        }
+    }
+    for (auto& font : windowFonts) {
+        fonts.emplace_back(font.fTextStart + newWindow.start, font.fFont);
+    }
+    for (auto& font : fFontSwitches) {
+        if (font.fTextStart >= window.end) {
+            fonts.emplace_back(moveIndex(font.fTextStart), font.fFont);
+        }
+    }
+
+    fRuns = std::move(runs);
+    fFontSwitches = std::move(fonts);
+    fClusters.clear();
+    fClustersIndexFromCodeUnit.clear();
+    fClustersIndexFromCodeUnit.push_back_n(fText.size() + 1, EMPTY_INDEX);
+    this->buildClusterTable();
+    return true;
+}
+
+// Copies a part of a left-to-right run as it is (without shaping it again)
+void ParagraphImpl::appendRunPiece(SkTArray<Run, false>* runs,
+                                   const Run& run,
+                                   GlyphRange glyphs,
+                                   TextIndex clusterStart) {
+    SkASSERT(run.leftToRight() && glyphs.start < glyphs.end && glyphs.end <= run.size());
+    auto textStart = run.fClusterIndexes[glyphs.start];
+    auto textEnd = run.fClusterIndexes[glyphs.end];
+    const SkShaper::RunHandler::RunInfo info = {
+            run.fFont,
+            run.fBidiLevel,
+            SkVector::Make(run.posX(glyphs.end) - run.posX(glyphs.start), run.fAdvance.fY),
+            glyphs.width(),
+            SkShaper::RunHandler::Range(textStart, textEnd - textStart)
+    };
+    auto& piece = runs->emplace_back(this,
+                                     info,
+                                     clusterStart,
+                                     run.fHeightMultiplier,
+                                     run.fUseHalfLeading,
+                                     run.fBaselineShift,
+                                     runs->size(),
+                                     run.posX(glyphs.start));
+    for (size_t i = glyphs.start; i <= glyphs.end; ++i) {
+        auto index = i - glyphs.start;
+        if (i < glyphs.end) {
+            piece.fGlyphs[index] = run.fGlyphs[i];
+        }
+        piece.fClusterIndexes[index] = run.fClusterIndexes[i];
+        piece.fPositions[index] = run.fPositions[i];
+        piece.fOffsets[index] = run.fOffsets[i];
+    }
+}
+
 TextIndex ParagraphImpl::findPreviousGraphemeBoundary(TextIndex utf8) {
     while (utf8 > 0 &&
           (fCodeUnitProperties[utf8] & SkUnicode::CodeUnitFlags::kGraphemeStart) == 0) {
@@ -1072,7 +1438,7 @@ TextIndex ParagraphImpl::findNextGraphemeBoundary(TextIndex utf8) {
 }
 
 void ParagraphImpl::ensureUTF16Mapping() {
-    fillUTF16MappingOnce([&] {
+    (*fillUTF16MappingOnce)([&] {
         fUnicode->extractUtfConversionMapping(
                 this->text(),
                 [&](size_t index) { fUTF8IndexForUTF16Index.emplace_back(index); },
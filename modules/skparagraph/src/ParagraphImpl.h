@@ -25,10 +25,12 @@
 #include "modules/skparagraph/include/TextStyle.h"
 #include "modules/skparagraph/src/Run.h"
 #include "modules/skparagraph/src/TextLine.h"
+#include "modules/skparagraph/src/TextWrapper.h"
 #include "modules/skunicode/include/SkUnicode.h"
 #include "src/core/SkTHash.h"
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -195,12 +197,15 @@ public:
     void applySpacingAndBuildClusterTable();
     void buildClusterTable();
     bool shapeTextIntoEndlessLine();
-    void breakShapedTextIntoLines(SkScalar maxWidth);
+    void breakShapedTextIntoLines(SkScalar maxWidth, size_t startLine = 0);
 
     void updateTextAlign(TextAlign textAlign) override;
     void updateFontSize(size_t from, size_t to, SkScalar fontSize) override;
     void updateForegroundPaint(size_t from, size_t to, SkPaint paint) override;
     void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) override;
+    void updateText(size_t from, size_t to, SkString text) override;
+    // For testing: the text that the last updateText shaped again (or will shape on layout)
+    TextRange reshapedText() const { return fReshapedText; }
 
     void visit(const Visitor&) override;
 
@@ -232,6 +237,13 @@ private:
 
     void computeEmptyMetrics();
 
+    // Incremental reshaping after a text edit
+    bool findReshapeWindow(TextRange edit, ClusterRange* window);
+    bool reshapeWindow(TextRange window, TextRange newWindow,
+                       const std::vector<SkUnicode::BidiRegion>& oldBidiRegions);
+    void appendRunPiece(SkTArray<Run, false>* runs, const Run& run, GlyphRange glyphs,
+                        TextIndex clusterStart);
+
     // Input
     SkTArray<StyleBlock<SkScalar>> fLetterSpaceStyles;
     SkTArray<StyleBlock<SkScalar>> fWordSpaceStyles;
@@ -255,10 +267,13 @@ private:
     // They are filled lazily whenever they need and cached
     SkTArray<TextIndex, true> fUTF8IndexForUTF16Index;
     SkTArray<size_t, true> fUTF16IndexForUTF8Index;
-    SkOnce fillUTF16MappingOnce;
+    std::optional<SkOnce> fillUTF16MappingOnce{std::in_place};  // Reset when the text changes
     size_t fUnresolvedGlyphs;
 
     SkTArray<TextLine, false> fLines;   // kFormatted   (cached: width, max lines, ellipsis, text align)
+    SkTArray<TextWrapper::LineStart, true> fLineStarts;  // kLineBroken
+    size_t fUnchangedLines;             // Lines before the last text edit (if the width stays)
+    TextRange fReshapedText;            // The text shaped again after the last text edit
     sk_sp<SkPicture> fPicture;          // kRecorded    (cached: text styles)
 
     SkTArray<ResolvedFontDescriptor> fFontSwitches;
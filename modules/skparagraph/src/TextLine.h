@@ -89,6 +89,11 @@ public:
     void paint(ParagraphPainter* painter, SkScalar x, SkScalar y);
     void visit(SkScalar x, SkScalar y);
     void ensureTextBlobCachePopulated();
+    // The records point to the runs; they have to be built again after the runs change
+    void resetTextBlobCache() {
+        fTextBlobCache.clear();
+        fTextBlobCachePopulated = false;
+    }
 
     void createEllipsis(SkScalar maxWidth, const SkString& ellipsis, bool ltr);
 
@@ -1,4 +1,5 @@
 // Copyright 2019 Google LLC.
+#include "include/private/base/SkTo.h"
 #include "modules/skparagraph/src/ParagraphImpl.h"
 #include "modules/skparagraph/src/TextWrapper.h"
 
@@ -260,7 +261,8 @@ std::tuple<Cluster*, size_t, SkScalar> TextWrapper::trimStartSpaces(Cluster* end
 // TODO: refactor the code for line ending (with/without ellipsis)
 void TextWrapper::breakTextIntoLines(ParagraphImpl* parent,
                                      SkScalar maxWidth,
-                                     const AddLineToParagraph& addLine) {
+                                     const AddLineToParagraph& addLine,
+                                     size_t startLine) {
     fHeight = 0;
     fMinIntrinsicWidth = std::numeric_limits<SkScalar>::min();
     fMaxIntrinsicWidth = std::numeric_limits<SkScalar>::min();
@@ -283,10 +285,38 @@ void TextWrapper::breakTextIntoLines(ParagraphImpl* parent,
     fEndLine = TextStretch(span.begin(), span.begin(), parent->strutForceHeight());
     auto end = span.end() - 1;
     auto start = span.begin();
+
+    auto& lineStarts = parent->fLineStarts;
+    if (startLine > 0) {
+        // Pick up where the unchanged lines end
+        SkASSERT(startLine < SkToSizeT(lineStarts.size()));
+        SkASSERT(startLine == SkToSizeT(parent->fLines.size()));
+        const auto& lineStart = lineStarts[startLine];
+        fHeight = lineStart.fHeight;
+        fMinIntrinsicWidth = lineStart.fMinIntrinsicWidth;
+        fMaxIntrinsicWidth = lineStart.fMaxIntrinsicWidth;
+        softLineMaxIntrinsicWidth = lineStart.fSoftLineMaxIntrinsicWidth;
+        parent->fMaxWidthWithTrailingSpaces = lineStart.fMaxWidthWithTrailingSpaces;
+        parent->fLongestLine = lineStart.fLongestLine;
+        fLineNumber = startLine + 1;
+        firstLine = false;
+        fEndLine.clean();
+        fEndLine.startFrom(start + lineStart.fCluster, 0);
+    }
+    lineStarts.pop_back_n(lineStarts.size() - SkToInt(startLine));
+
     InternalLineMetrics maxRunMetrics;
     bool needEllipsis = false;
     while (fEndLine.endCluster() != end) {
 
+        lineStarts.push_back({SkToSizeT(fEndLine.startCluster() - start),
+                              fHeight,
+                              fMinIntrinsicWidth,
+                              fMaxIntrinsicWidth,
+                              softLineMaxIntrinsicWidth,
+                              parent->fMaxWidthWithTrailingSpaces,
+                              parent->fLongestLine});
+
         lookAhead(maxWidth, end);
 
         auto lastLine = (hasEllipsis && unlimitedLines) || fLineNumber >= maxLines;
@@ -179,9 +179,25 @@ public:
                                                   SkVector advance,
                                                   InternalLineMetrics metrics,
                                                   bool addEllipsis)>;
+
+    // The state of the wrapper at the start of a line; wrapping can resume from there
+    // when the text before that line has not changed
+    struct LineStart {
+        ClusterIndex fCluster;
+        SkScalar fHeight;
+        SkScalar fMinIntrinsicWidth;
+        SkScalar fMaxIntrinsicWidth;
+        SkScalar fSoftLineMaxIntrinsicWidth;
+        SkScalar fMaxWidthWithTrailingSpaces;
+        SkScalar fLongestLine;
+    };
+
+    // Breaks the text into lines starting from the line with index startLine;
+    // the parent must already have all the lines before it
     void breakTextIntoLines(ParagraphImpl* parent,
                             SkScalar maxWidth,
-                            const AddLineToParagraph& addLine);
+                            const AddLineToParagraph& addLine,
+                            size_t startLine = 0);
 
     SkScalar height() const { return fHeight; }
     SkScalar minIntrinsicWidth() const { return fMinIntrinsicWidth; }
@@ -36,6 +36,7 @@
 #include "modules/skparagraph/tests/SkShaperJSONWriter.h"
 #include "modules/skparagraph/utils/TestFontCollection.h"
 #include "src/core/SkOSFile.h"
+#include "src/core/SkPointPriv.h"
 #include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
@@ -5342,6 +5343,88 @@ UNIX_ONLY_TEST(SkParagraph_CacheStyles, reporter) {
     test(2, false);
 }
 
+UNIX_ONLY_TEST(SkParagraph_CacheByteBudget, reporter) {
+    const size_t budget = 64 * 1024;
+    ParagraphCache cache(budget);
+    cache.turnOn(true);
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+
+    ParagraphStyle paragraph_style;
+    paragraph_style.turnHintingOff();
+
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setColor(SK_ColorBLACK);
+
+    const int paragraphs = 256;
+    for (int i = 0; i < paragraphs; ++i) {
+        TestParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(SkStringPrintf("paragraph %d", i).c_str());
+        builder.pop();
+        auto paragraph = builder.Build();
+        auto impl = static_cast<ParagraphImpl*>(paragraph.get());
+        cache.updateParagraph(impl);
+        REPORTER_ASSERT(reporter, cache.bytesUsed() <= budget);
+    }
+    REPORTER_ASSERT(reporter, cache.count() < paragraphs);
+    auto stats = cache.stats();
+    REPORTER_ASSERT(reporter, stats.fRequests == paragraphs);
+    REPORTER_ASSERT(reporter, stats.fHits == 0);
+    REPORTER_ASSERT(reporter, stats.fEvictions == paragraphs - cache.count());
+
+    cache.setByteBudget(0);
+    REPORTER_ASSERT(reporter, cache.count() == 0);
+    REPORTER_ASSERT(reporter, cache.bytesUsed() == 0);
+}
+
+UNIX_ONLY_TEST(SkParagraph_CacheThreads, reporter) {
+    ParagraphCache cache;
+    cache.turnOn(true);
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+
+    ParagraphStyle paragraph_style;
+    paragraph_style.turnHintingOff();
+
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setColor(SK_ColorBLACK);
+
+    const int paragraphs = 32;
+    const int threadCount = 4;
+    auto work = [&]() {
+        for (int i = 0; i < paragraphs; ++i) {
+            TestParagraphBuilderImpl builder(paragraph_style, fontCollection);
+            builder.pushStyle(text_style);
+            builder.addText(SkStringPrintf("paragraph %d", i).c_str());
+            builder.pop();
+            auto paragraph = builder.Build();
+            auto impl = static_cast<ParagraphImpl*>(paragraph.get());
+            if (!cache.findParagraph(impl)) {
+                cache.updateParagraph(impl);
+            }
+        }
+    };
+    std::thread threads[threadCount];
+    for (auto& thread : threads) {
+        thread = std::thread(work);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Every paragraph is cached once, whichever thread got there first
+    REPORTER_ASSERT(reporter, cache.count() == paragraphs);
+    auto stats = cache.stats();
+    REPORTER_ASSERT(reporter, stats.fEvictions == 0);
+    // Every lookup is a hit or a miss; every miss is followed by an insertion
+    REPORTER_ASSERT(reporter, stats.fHits + stats.fMisses == threadCount * paragraphs);
+    REPORTER_ASSERT(reporter, stats.fMisses >= paragraphs);
+    REPORTER_ASSERT(reporter, stats.fRequests == threadCount * paragraphs + stats.fMisses);
+}
+
 UNIX_ONLY_TEST(SkParagraph_EmptyParagraphWithLineBreak, reporter) {
     sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
     if (!fontCollection->fontsFound()) return;
@@ -7273,3 +7356,195 @@ DEF_TEST(SkParagraph_lineMetricsAfterUpdate, reporter) {
     paragraph->getLineMetrics(lm);
     REPORTER_ASSERT(reporter, lm.size() == 2);
 }
+
+DEF_TEST(SkParagraph_UpdateText, reporter) {
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+
+    ParagraphStyle paragraph_style;
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setFontSize(20);
+    text_style.setColor(SK_ColorBLACK);
+    const SkScalar width = 300;
+
+    auto build = [&](const std::string& text) {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text.c_str(), text.size());
+        auto paragraph = builder.Build();
+        paragraph->layout(width);
+        return paragraph;
+    };
+    auto glyphs = [](Paragraph* paragraph) {
+        std::vector<SkGlyphID> result;
+        for (auto& run : static_cast<ParagraphImpl*>(paragraph)->runs()) {
+            result.insert(result.end(), run.glyphs().begin(), run.glyphs().end());
+        }
+        return result;
+    };
+    auto draw = [width](Paragraph* paragraph) {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(SkScalarCeilToInt(width), 400);
+        bitmap.eraseColor(SK_ColorWHITE);
+        SkCanvas canvas(bitmap);
+        paragraph->paint(&canvas, 0, 0);
+        return bitmap;
+    };
+    struct VisitedRun {
+        int line;
+        SkPoint origin;
+        std::vector<SkGlyphID> glyphs;
+        std::vector<SkPoint> positions;
+        std::vector<uint32_t> utf8Starts;
+    };
+    auto visit = [](Paragraph* paragraph) {
+        std::vector<VisitedRun> result;
+        paragraph->visit([&](int lineNumber, const Paragraph::VisitorInfo* info) {
+            if (info == nullptr) {
+                return;
+            }
+            result.push_back({lineNumber,
+                              info->origin,
+                              {info->glyphs, info->glyphs + info->count},
+                              {info->positions, info->positions + info->count},
+                              {info->utf8Starts, info->utf8Starts + info->count + 1}});
+        });
+        return result;
+    };
+
+    std::string text = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+                       "tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim "
+                       "veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea "
+                       "commodo consequat.";
+    auto paragraph = build(text);
+
+    // Replace the given number of bytes at the first occurrence of the given text
+    struct Edit {
+        const char* at;
+        size_t length;
+        const char* text;
+        bool incremental;   // Only the words around the edit are shaped again
+    } edits[] = {
+        {"ipsum", 0, "x", true},
+        {"sit", 3, "sat", true},
+        {"amet,", 4, "ameth", true},
+        {"consectetur ", 12, "", true},
+        {"magna", 0, "words that move the following lines ", true},
+        {"Ut enim", 0, "\n", false},
+        {"Lorem", 0, "Hello ", true},
+        {"consequat.", 10, "consequat. The end.", true},
+    };
+    for (auto& edit : edits) {
+        // Fill the caches of the lines the edit keeps
+        draw(paragraph.get());
+        visit(paragraph.get());
+
+        auto from = text.find(edit.at);
+        SkASSERT(from != std::string::npos);
+        text.replace(from, edit.length, edit.text);
+        paragraph->updateText(from, from + edit.length, SkString(edit.text));
+        paragraph->layout(width);
+
+        auto reshaped = static_cast<ParagraphImpl*>(paragraph.get())->reshapedText();
+        REPORTER_ASSERT(reporter, reshaped.start <= from &&
+                                  reshaped.end >= from + strlen(edit.text), "%s", edit.at);
+        if (edit.incremental) {
+            REPORTER_ASSERT(reporter, reshaped.width() < text.size(), "%s", edit.at);
+        }
+
+        auto expected = build(text);
+        REPORTER_ASSERT(reporter, paragraph->lineNumber() == expected->lineNumber(), "%s", edit.at);
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getHeight(), expected->getHeight()));
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getLongestLine(),
+                                                      expected->getLongestLine(), EPSILON100));
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getMinIntrinsicWidth(),
+                                                      expected->getMinIntrinsicWidth(), EPSILON100));
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getMaxIntrinsicWidth(),
+                                                      expected->getMaxIntrinsicWidth(), EPSILON100));
+        REPORTER_ASSERT(reporter, glyphs(paragraph.get()) == glyphs(expected.get()), "%s", edit.at);
+
+        std::vector<LineMetrics> lines;
+        std::vector<LineMetrics> expectedLines;
+        paragraph->getLineMetrics(lines);
+        expected->getLineMetrics(expectedLines);
+        REPORTER_ASSERT(reporter, lines.size() == expectedLines.size());
+        for (size_t i = 0; i < std::min(lines.size(), expectedLines.size()); ++i) {
+            REPORTER_ASSERT(reporter, lines[i].fStartIndex == expectedLines[i].fStartIndex);
+            REPORTER_ASSERT(reporter, lines[i].fEndIndex == expectedLines[i].fEndIndex);
+            REPORTER_ASSERT(reporter, SkScalarNearlyEqual(lines[i].fWidth,
+                                                          expectedLines[i].fWidth, EPSILON100));
+        }
+
+        auto visited = visit(paragraph.get());
+        auto expectedVisited = visit(expected.get());
+        REPORTER_ASSERT(reporter, visited.size() == expectedVisited.size(), "%s", edit.at);
+        for (size_t i = 0; i < std::min(visited.size(), expectedVisited.size()); ++i) {
+            auto& run = visited[i];
+            auto& expectedRun = expectedVisited[i];
+            REPORTER_ASSERT(reporter, run.line == expectedRun.line);
+            REPORTER_ASSERT(reporter, run.glyphs == expectedRun.glyphs, "%s", edit.at);
+            REPORTER_ASSERT(reporter, run.utf8Starts == expectedRun.utf8Starts, "%s", edit.at);
+            REPORTER_ASSERT(reporter, SkPointPriv::EqualsWithinTolerance(
+                                              run.origin, expectedRun.origin, EPSILON100));
+            for (size_t j = 0; j < std::min(run.positions.size(),
+                                            expectedRun.positions.size()); ++j) {
+                REPORTER_ASSERT(reporter, SkPointPriv::EqualsWithinTolerance(
+                                                  run.positions[j], expectedRun.positions[j],
+                                                  EPSILON100));
+            }
+        }
+
+        auto bitmap = draw(paragraph.get());
+        auto expectedBitmap = draw(expected.get());
+        int differentPixels = 0;
+        for (int y = 0; y < bitmap.height(); ++y) {
+            for (int x = 0; x < bitmap.width(); ++x) {
+                differentPixels += bitmap.getColor(x, y) != expectedBitmap.getColor(x, y);
+            }
+        }
+        REPORTER_ASSERT(reporter, differentPixels == 0, "%s: %d", edit.at, differentPixels);
+    }
+
+    // Placeholders make the paragraph shape the entire text again
+    PlaceholderStyle placeholder(50, 20, PlaceholderAlignment::kBaseline,
+                                 TextBaseline::kAlphabetic, 0);
+    auto buildWithPlaceholder = [&](const std::string& before, const std::string& after) {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(before.c_str(), before.size());
+        builder.addPlaceholder(placeholder);
+        builder.addText(after.c_str(), after.size());
+        auto paragraph = builder.Build();
+        paragraph->layout(width);
+        return paragraph;
+    };
+    std::string before = "Lorem ipsum dolor sit amet, ";
+    std::string after = " consectetur adipiscing elit.";
+    paragraph = buildWithPlaceholder(before, after);
+    const size_t placeholderSize = 3;   // U+FFFC in UTF-8
+    paragraph->updateText(before.size() + placeholderSize, before.size() + placeholderSize,
+                          SkString(" sed"));
+    after.insert(0, " sed");
+    paragraph->updateText(0, 6, SkString("Hello "));
+    before.replace(0, 6, "Hello ");
+    paragraph->layout(width);
+    REPORTER_ASSERT(reporter, static_cast<ParagraphImpl*>(paragraph.get())->reshapedText().width() ==
+                              before.size() + placeholderSize + after.size());
+
+    auto expected = buildWithPlaceholder(before, after);
+    REPORTER_ASSERT(reporter, paragraph->lineNumber() == expected->lineNumber());
+    REPORTER_ASSERT(reporter, glyphs(paragraph.get()) == glyphs(expected.get()));
+    auto boxes = paragraph->getRectsForPlaceholders();
+    auto expectedBoxes = expected->getRectsForPlaceholders();
+    REPORTER_ASSERT(reporter, boxes.size() == 1 && expectedBoxes.size() == 1);
+    if (boxes.size() == 1 && expectedBoxes.size() == 1) {
+        REPORTER_ASSERT(reporter, boxes[0].rect == expectedBoxes[0].rect);
+    }
+
+    // Removing the placeholder character removes the placeholder
+    paragraph->updateText(before.size(), before.size() + placeholderSize, SkString());
+    paragraph->layout(width);
+    REPORTER_ASSERT(reporter, paragraph->getRectsForPlaceholders().empty());
+    REPORTER_ASSERT(reporter, glyphs(paragraph.get()) == glyphs(build(before + after).get()));
+}
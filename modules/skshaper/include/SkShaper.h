@@ -12,10 +12,12 @@
 #include "include/core/SkPoint.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkScalar.h"
+#include "include/core/SkSpan.h"
 #include "include/core/SkTextBlob.h"
 #include "include/core/SkTypes.h"
 
 #include <memory>
+#include <vector>
 
 #if !defined(SKSHAPER_IMPLEMENTATION)
     #define SKSHAPER_IMPLEMENTATION 0
@@ -37,8 +39,10 @@
     #endif
 #endif
 
+class SkExecutor;
 class SkFont;
 class SkFontMgr;
+class SkShaperCache;
 class SkUnicode;
 
 class SKSHAPER_API SkShaper {
@@ -57,6 +61,15 @@ public:
     static std::unique_ptr<SkShaper> Make(sk_sp<SkFontMgr> = nullptr);
     static void PurgeCaches();
 
+    /**
+     *  Wraps shaper so that shape() calls with a single font and direction look up the result in
+     *  cache before shaping, and add it on a miss. Results are replayed into the RunHandler exactly
+     *  as shaper produced them. Calls with run iterators are passed through to shaper.
+     *  A cache must only be shared by shapers which shape alike (same kind and font manager).
+     */
+    static std::unique_ptr<SkShaper> MakeCached(std::unique_ptr<SkShaper> shaper,
+                                                sk_sp<SkShaperCache> cache);
+
     SkShaper();
     virtual ~SkShaper();
 
@@ -249,11 +262,82 @@ public:
                        SkScalar width,
                        RunHandler*) const = 0;
 
+    #ifdef SK_SHAPER_HARFBUZZ_AVAILABLE
+    /** A run of text already split by font, script, language and direction. */
+    struct BatchRun {
+        const char* utf8;
+        size_t utf8Bytes;
+        SkFont font;
+        SkFourByteTag script;   // iso15924, or 0 to guess it from the text
+        const char* language;   // BCP-47, or nullptr if undefined
+        bool leftToRight;
+        const Feature* features = nullptr;  // offsets are relative to utf8
+        size_t featuresSize = 0;
+    };
+
+    /** The glyphs of a shaped batch, all kept in one allocation. */
+    class SKSHAPER_API BatchResult {
+    public:
+        struct Run {
+            SkFont font;
+            size_t glyphStart;  // index of the run's first glyph in glyphs(), positions() and clusters()
+            size_t glyphCount;
+            SkVector advance;
+        };
+
+        SkSpan<const Run> runs() const { return SkSpan<const Run>(fRuns.data(), fRuns.size()); }
+        /** Glyphs of each run in visual order. */
+        const SkGlyphID* glyphs() const { return fGlyphs; }
+        /** Positions relative to the origin of each run. */
+        const SkPoint* positions() const { return fPositions; }
+        /** Offsets into the utf8 of each run of the text which produced each glyph. */
+        const uint32_t* clusters() const { return fClusters; }
+
+        /** Adds the run at index as a positioned run starting at origin. */
+        void appendRun(size_t index, SkTextBlobBuilder* builder, SkPoint origin) const;
+
+    private:
+        friend class SkShaper;
+        std::vector<Run> fRuns;
+        std::unique_ptr<char[]> fStorage;
+        SkPoint* fPositions = nullptr;
+        uint32_t* fClusters = nullptr;
+        SkGlyphID* fGlyphs = nullptr;
+    };
+
+    /**
+     *  Shapes each run on its own, without fallback, bidi reordering or line breaking. Runs are
+     *  independent of each other, so large batches are split into tasks shaped concurrently on
+     *  the executor (the default executor if nullptr).
+     */
+    static BatchResult ShapeBatch(SkSpan<const BatchRun> runs, SkExecutor* executor = nullptr);
+    #endif
+
 private:
     SkShaper(const SkShaper&) = delete;
     SkShaper& operator=(const SkShaper&) = delete;
 };
 
+/**
+ * Shaped results kept by the shapers made with SkShaper::MakeCached, keyed by the text, the font,
+ * the direction, the width and the locale. The least recently used results are dropped when they
+ * use more than the byte budget.
+ */
+class SKSHAPER_API SkShaperCache : public SkRefCnt {
+public:
+    static sk_sp<SkShaperCache> Make(size_t byteBudget);
+
+    virtual size_t byteBudget() const = 0;
+    virtual size_t bytesUsed() const = 0;
+    virtual int count() const = 0;
+    virtual uint64_t hits() const = 0;
+    virtual uint64_t misses() const = 0;
+    virtual void purge() = 0;
+
+protected:
+    SkShaperCache() = default;
+};
+
 /**
  * Helper for shaping text directly into a SkTextBlob.
  */
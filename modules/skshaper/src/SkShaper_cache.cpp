@@ -0,0 +1,357 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkFont.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkString.h"
+#include "include/core/SkTypeface.h"
+#include "include/private/base/SkMutex.h"
+#include "modules/skshaper/include/SkShaper.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkTHash.h"
+#include "src/core/SkTInternalLList.h"
+
+#include <atomic>
+#include <locale>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Everything a shape() call with a single font and direction depends on. The script is found from
+// the text, and the language from the locale.
+class CacheKey {
+public:
+    CacheKey(const char* utf8, size_t utf8Bytes, const SkFont& font, bool leftToRight,
+             SkScalar width)
+        : fText(utf8, utf8Bytes)
+        , fFont(font)
+        , fLeftToRight(leftToRight)
+        , fWidth(width)
+        , fLanguage(std::locale().name().c_str()) {
+        struct {
+            SkTypefaceID typefaceID;
+            SkScalar size;
+            SkScalar scaleX;
+            SkScalar skewX;
+            SkScalar width;
+            uint32_t leftToRight;
+        } fields = {font.getTypeface() ? font.getTypeface()->uniqueID() : 0,
+                    font.getSize(), font.getScaleX(), font.getSkewX(), width,
+                    leftToRight ? 1u : 0u};
+        uint32_t hash = SkOpts::hash_fn(fText.c_str(), fText.size(), 0);
+        hash = SkOpts::hash_fn(fLanguage.c_str(), fLanguage.size(), hash);
+        fHash = SkOpts::hash_fn(&fields, sizeof(fields), hash);
+    }
+
+    bool operator==(const CacheKey& other) const {
+        return fHash == other.fHash &&
+               fLeftToRight == other.fLeftToRight &&
+               fWidth == other.fWidth &&
+               fFont == other.fFont &&
+               fText == other.fText &&
+               fLanguage == other.fLanguage;
+    }
+
+    uint32_t hash() const { return fHash; }
+    size_t bytes() const { return sizeof(CacheKey) + fText.size() + fLanguage.size(); }
+
+private:
+    SkString fText;
+    SkFont fFont;
+    bool fLeftToRight;
+    SkScalar fWidth;
+    SkString fLanguage;
+    uint32_t fHash;
+};
+
+// The calls a shaper made on its RunHandler, with the glyphs of every run buffer.
+class Recording : public SkNVRefCnt<Recording> {
+public:
+    enum class Call : uint8_t {
+        kBeginLine,
+        kRunInfo,
+        kCommitRunInfo,
+        kRunBuffer,     // also stands for the following commitRunBuffer
+        kCommitLine,
+    };
+
+    struct Run {
+        SkFont fFont;
+        uint8_t fBidiLevel;
+        SkVector fAdvance;
+        size_t fGlyphCount;
+        SkShaper::RunHandler::Range fUtf8Range;
+        size_t fGlyphStart;
+    };
+
+    void replay(SkShaper::RunHandler* handler) const;
+
+    size_t bytes() const {
+        return sizeof(Recording)
+             + fCalls.size() * sizeof(Call)
+             + fRuns.size() * sizeof(Run)
+             + fGlyphs.size() * (sizeof(SkGlyphID) + 2 * sizeof(SkPoint) + sizeof(uint32_t));
+    }
+
+private:
+    friend class RecordingRunHandler;
+
+    std::vector<Call> fCalls;
+    std::vector<Run> fRuns;  // one for each kRunInfo and kRunBuffer call
+    std::vector<SkGlyphID> fGlyphs;
+    std::vector<SkPoint> fPositions;  // relative to the point of the run buffer
+    std::vector<SkPoint> fOffsets;
+    std::vector<uint32_t> fClusters;
+};
+
+class RecordingRunHandler final : public SkShaper::RunHandler {
+public:
+    RecordingRunHandler(Recording* recording) : fRecording(recording) {}
+
+    void beginLine() override { fRecording->fCalls.push_back(Recording::Call::kBeginLine); }
+
+    void runInfo(const RunInfo& info) override {
+        fRecording->fCalls.push_back(Recording::Call::kRunInfo);
+        this->addRun(info);
+    }
+
+    void commitRunInfo() override {
+        fRecording->fCalls.push_back(Recording::Call::kCommitRunInfo);
+    }
+
+    Buffer runBuffer(const RunInfo& info) override {
+        fRecording->fCalls.push_back(Recording::Call::kRunBuffer);
+        const size_t start = this->addRun(info).fGlyphStart;
+        const size_t end = start + info.glyphCount;
+        fRecording->fGlyphs.resize(end);
+        fRecording->fPositions.resize(end);
+        // Not every shaper writes offsets.
+        fRecording->fOffsets.resize(end, {0, 0});
+        fRecording->fClusters.resize(end);
+        return {fRecording->fGlyphs.data() + start,
+                fRecording->fPositions.data() + start,
+                fRecording->fOffsets.data() + start,
+                fRecording->fClusters.data() + start,
+                {0, 0}};
+    }
+
+    void commitRunBuffer(const RunInfo&) override {}
+
+    void commitLine() override { fRecording->fCalls.push_back(Recording::Call::kCommitLine); }
+
+private:
+    const Recording::Run& addRun(const RunInfo& info) {
+        fRecording->fRuns.push_back({info.fFont, info.fBidiLevel, info.fAdvance, info.glyphCount,
+                                     info.utf8Range, fRecording->fGlyphs.size()});
+        return fRecording->fRuns.back();
+    }
+
+    Recording* fRecording;
+};
+
+void Recording::replay(SkShaper::RunHandler* handler) const {
+    size_t runIndex = 0;
+    for (Call call : fCalls) {
+        switch (call) {
+            case Call::kBeginLine:
+                handler->beginLine();
+                break;
+            case Call::kRunInfo: {
+                const Run& run = fRuns[runIndex++];
+                handler->runInfo({run.fFont, run.fBidiLevel, run.fAdvance, run.fGlyphCount,
+                                  run.fUtf8Range});
+                break;
+            }
+            case Call::kCommitRunInfo:
+                handler->commitRunInfo();
+                break;
+            case Call::kRunBuffer: {
+                const Run& run = fRuns[runIndex++];
+                const SkShaper::RunHandler::RunInfo info = {
+                        run.fFont, run.fBidiLevel, run.fAdvance, run.fGlyphCount, run.fUtf8Range};
+                const auto buffer = handler->runBuffer(info);
+                SkASSERT(buffer.glyphs);
+                SkASSERT(buffer.positions);
+                for (size_t i = 0; i < run.fGlyphCount; ++i) {
+                    const size_t glyph = run.fGlyphStart + i;
+                    buffer.glyphs[i] = fGlyphs[glyph];
+                    if (buffer.offsets) {
+                        buffer.positions[i] = fPositions[glyph] + buffer.point;
+                        buffer.offsets[i] = fOffsets[glyph];
+                    } else {
+                        buffer.positions[i] = fPositions[glyph] + buffer.point + fOffsets[glyph];
+                    }
+                    if (buffer.clusters) {
+                        buffer.clusters[i] = fClusters[glyph];
+                    }
+                }
+                handler->commitRunBuffer(info);
+                break;
+            }
+            case Call::kCommitLine:
+                handler->commitLine();
+                break;
+        }
+    }
+}
+
+class ShaperCache final : public SkShaperCache {
+public:
+    explicit ShaperCache(size_t byteBudget) : fByteBudget(byteBudget) {}
+    ~ShaperCache() override { this->purge(); }
+
+    size_t byteBudget() const override { return fByteBudget; }
+    size_t bytesUsed() const override {
+        SkAutoMutexExclusive lock(fMutex);
+        return fBytesUsed;
+    }
+    int count() const override {
+        SkAutoMutexExclusive lock(fMutex);
+        return fMap.count();
+    }
+    uint64_t hits() const override { return fHits.load(std::memory_order_relaxed); }
+    uint64_t misses() const override { return fMisses.load(std::memory_order_relaxed); }
+
+    void purge() override {
+        SkAutoMutexExclusive lock(fMutex);
+        fMap.reset();
+        for (Entry* entry = fLRU.head(); entry; entry = fLRU.head()) {
+            fLRU.remove(entry);
+            delete entry;
+        }
+        fBytesUsed = 0;
+    }
+
+    sk_sp<const Recording> find(const CacheKey& key) {
+        SkAutoMutexExclusive lock(fMutex);
+        Entry** entry = fMap.find(key);
+        if (!entry) {
+            fMisses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (*entry != fLRU.head()) {
+            fLRU.remove(*entry);
+            fLRU.addToHead(*entry);
+        }
+        fHits.fetch_add(1, std::memory_order_relaxed);
+        return (*entry)->fRecording;
+    }
+
+    void add(CacheKey key, sk_sp<const Recording> recording) {
+        const size_t bytes = key.bytes() + recording->bytes();
+        if (bytes > fByteBudget) {
+            return;
+        }
+        SkAutoMutexExclusive lock(fMutex);
+        if (fMap.find(key)) {
+            // Another thread has shaped the same text in the meantime.
+            return;
+        }
+        while (fBytesUsed > fByteBudget - bytes) {
+            Entry* entry = fLRU.tail();
+            fBytesUsed -= entry->fBytes;
+            fMap.remove(entry->fKey);
+            fLRU.remove(entry);
+            delete entry;
+        }
+        Entry* entry = new Entry(std::move(key), std::move(recording), bytes);
+        fMap.set(entry);
+        fLRU.addToHead(entry);
+        fBytesUsed += bytes;
+    }
+
+private:
+    struct Entry {
+        Entry(CacheKey key, sk_sp<const Recording> recording, size_t bytes)
+            : fKey(std::move(key)), fRecording(std::move(recording)), fBytes(bytes) {}
+
+        CacheKey fKey;
+        sk_sp<const Recording> fRecording;
+        size_t fBytes;
+        SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+    };
+
+    struct Traits {
+        static const CacheKey& GetKey(const Entry* entry) { return entry->fKey; }
+        static uint32_t Hash(const CacheKey& key) { return key.hash(); }
+    };
+
+    const size_t fByteBudget;
+    mutable SkMutex fMutex;
+    SkTHashTable<Entry*, CacheKey, Traits> fMap;
+    SkTInternalLList<Entry> fLRU;
+    size_t fBytesUsed = 0;
+    std::atomic<uint64_t> fHits{0};
+    std::atomic<uint64_t> fMisses{0};
+};
+
+class CachedShaper final : public SkShaper {
+public:
+    CachedShaper(std::unique_ptr<SkShaper> shaper, sk_sp<ShaperCache> cache)
+        : fShaper(std::move(shaper)), fCache(std::move(cache)) {}
+
+private:
+    void shape(const char* utf8, size_t utf8Bytes,
+               const SkFont& font,
+               bool leftToRight,
+               SkScalar width,
+               RunHandler* handler) const override {
+        CacheKey key(utf8, utf8Bytes, font, leftToRight, width);
+        sk_sp<const Recording> recording = fCache->find(key);
+        if (!recording) {
+            auto shaped = sk_make_sp<Recording>();
+            RecordingRunHandler recorder(shaped.get());
+            fShaper->shape(utf8, utf8Bytes, font, leftToRight, width, &recorder);
+            fCache->add(std::move(key), shaped);
+            recording = std::move(shaped);
+        }
+        recording->replay(handler);
+    }
+
+    void shape(const char* utf8, size_t utf8Bytes,
+               FontRunIterator& font,
+               BiDiRunIterator& bidi,
+               ScriptRunIterator& script,
+               LanguageRunIterator& language,
+               SkScalar width,
+               RunHandler* handler) const override {
+        fShaper->shape(utf8, utf8Bytes, font, bidi, script, language, width, handler);
+    }
+
+    void shape(const char* utf8, size_t utf8Bytes,
+               FontRunIterator& font,
+               BiDiRunIterator& bidi,
+               ScriptRunIterator& script,
+               LanguageRunIterator& language,
+               const Feature* features, size_t featuresSize,
+               SkScalar width,
+               RunHandler* handler) const override {
+        fShaper->shape(utf8, utf8Bytes, font, bidi, script, language,
+                       features, featuresSize, width, handler);
+    }
+
+    const std::unique_ptr<SkShaper> fShaper;
+    const sk_sp<ShaperCache> fCache;
+};
+
+}  // namespace
+
+sk_sp<SkShaperCache> SkShaperCache::Make(size_t byteBudget) {
+    return sk_make_sp<ShaperCache>(byteBudget);
+}
+
+std::unique_ptr<SkShaper> SkShaper::MakeCached(std::unique_ptr<SkShaper> shaper,
+                                               sk_sp<SkShaperCache> cache) {
+    if (!shaper || !cache) {
+        return shaper;
+    }
+    // Every SkShaperCache is a ShaperCache, since only SkShaperCache::Make creates them.
+    return std::make_unique<CachedShaper>(
+            std::move(shaper), sk_sp<ShaperCache>(static_cast<ShaperCache*>(cache.release())));
+}
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkFontArguments.h"
 #include "include/core/SkFontMetrics.h"
@@ -24,21 +25,25 @@
 #include "include/private/base/SkTypeTraits.h"
 #include "include/private/base/SkMalloc.h"
 #include "include/private/base/SkMutex.h"
+#include "include/private/base/SkTDArray.h"
 #include "include/private/base/SkTFitsIn.h"
 #include "include/private/base/SkTo.h"
 #include "modules/skshaper/include/SkShaper.h"
 #include "modules/skunicode/include/SkUnicode.h"
 #include "src/core/SkLRUCache.h"
 #include "src/core/SkTDPQueue.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/utils/SkUTF.h"
 
 #include <hb.h>
 #include <hb-ot.h>
+#include <algorithm>
 #include <cstring>
 #include <locale>
 #include <memory>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 // HB_FEATURE_GLOBAL_START and HB_FEATURE_GLOBAL_END were not added until HarfBuzz 2.0
 // They would have always worked, they just hadn't been named yet.
@@ -1315,10 +1320,26 @@ private:
 };
 static HBLockedFaceCache get_hbFace_cache() {
     static SkMutex gHBFaceCacheMutex;
+    // The size of 100 here is completely arbitrary and used to match libtxt.
     static SkLRUCache<SkTypefaceID, HBFont> gHBFaceCache(100);
     return HBLockedFaceCache(gHBFaceCache, gHBFaceCacheMutex);
 }
 
+// TODO: better cache HBFace (data) / hbfont (typeface)
+// An HBFace is expensive (it sanitizes the bits).
+// An HBFont is fairly inexpensive.
+// An HBFace is actually tied to the data, not the typeface.
+HBFont create_hb_font(const SkFont& font) {
+    HBLockedFaceCache cache = get_hbFace_cache();
+    SkTypefaceID dataId = font.getTypeface()->uniqueID();
+    HBFont* typefaceFontCached = cache.find(dataId);
+    if (!typefaceFontCached) {
+        HBFont typefaceFont(create_typeface_hb_font(*font.getTypeface()));
+        typefaceFontCached = cache.insert(dataId, std::move(typefaceFont));
+    }
+    return create_sub_hb_font(font, *typefaceFontCached);
+}
+
 ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
                                   size_t const utf8Bytes,
                                   char const * const utf8Start,
@@ -1370,22 +1391,7 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     hb_buffer_set_language(buffer, hbLanguage);
     hb_buffer_guess_segment_properties(buffer);
 
-    // TODO: better cache HBFace (data) / hbfont (typeface)
-    // An HBFace is expensive (it sanitizes the bits).
-    // An HBFont is fairly inexpensive.
-    // An HBFace is actually tied to the data, not the typeface.
-    // The size of 100 here is completely arbitrary and used to match libtxt.
-    HBFont hbFont;
-    {
-        HBLockedFaceCache cache = get_hbFace_cache();
-        SkTypefaceID dataId = font.currentFont().getTypeface()->uniqueID();
-        HBFont* typefaceFontCached = cache.find(dataId);
-        if (!typefaceFontCached) {
-            HBFont typefaceFont(create_typeface_hb_font(*font.currentFont().getTypeface()));
-            typefaceFontCached = cache.insert(dataId, std::move(typefaceFont));
-        }
-        hbFont = create_sub_hb_font(font.currentFont(), *typefaceFontCached);
-    }
+    HBFont hbFont = create_hb_font(font.currentFont());
     if (!hbFont) {
         return run;
     }
@@ -1462,8 +1468,170 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     return run;
 }
 
+// The runs of a batch are shaped in tasks of this many runs, each with its own hb_buffer.
+constexpr size_t kBatchRunsPerTask = 16;
+
+// The glyphs of the runs shaped by one task, in the order of the runs.
+struct BatchChunk {
+    SkTDArray<SkGlyphID> fGlyphs;
+    SkTDArray<SkPoint> fPositions;
+    SkTDArray<uint32_t> fClusters;
+};
+
+void shape_batch_run(hb_buffer_t* buffer,
+                     hb_font_t* hbFont,
+                     hb_language_t undefinedLanguage,
+                     const SkShaper::BatchRun& run,
+                     SkShaper::BatchResult::Run* shaped,
+                     BatchChunk* chunk) {
+    SkAutoTCallVProc<hb_buffer_t, hb_buffer_clear_contents> autoClearBuffer(buffer);
+    hb_buffer_set_content_type(buffer, HB_BUFFER_CONTENT_TYPE_UNICODE);
+    hb_buffer_set_cluster_level(buffer, HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS);
+
+    const char* utf8End = run.utf8 + run.utf8Bytes;
+    for (const char* utf8Current = run.utf8; utf8Current < utf8End;) {
+        unsigned int cluster = utf8Current - run.utf8;
+        hb_codepoint_t u = utf8_next(&utf8Current, utf8End);
+        hb_buffer_add(buffer, u, cluster);
+    }
+
+    hb_buffer_set_direction(buffer, run.leftToRight ? HB_DIRECTION_LTR : HB_DIRECTION_RTL);
+    if (run.script) {
+        hb_buffer_set_script(buffer, hb_script_from_iso15924_tag((hb_tag_t)run.script));
+    }
+    hb_language_t hbLanguage = run.language ? hb_language_from_string(run.language, -1)
+                                            : HB_LANGUAGE_INVALID;
+    hb_buffer_set_language(buffer, hbLanguage != HB_LANGUAGE_INVALID ? hbLanguage
+                                                                      : undefinedLanguage);
+    hb_buffer_guess_segment_properties(buffer);
+
+    SkSTArray<32, hb_feature_t> hbFeatures;
+    for (const auto& feature : SkSpan(run.features, run.featuresSize)) {
+        if (run.utf8Bytes <= feature.start) {
+            continue;
+        }
+        if (feature.start == 0 && run.utf8Bytes <= feature.end) {
+            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
+                                   HB_FEATURE_GLOBAL_START, HB_FEATURE_GLOBAL_END});
+        } else {
+            hbFeatures.push_back({ (hb_tag_t)feature.tag, feature.value,
+                                   SkTo<unsigned>(feature.start), SkTo<unsigned>(feature.end)});
+        }
+    }
+
+    hb_shape(hbFont, buffer, hbFeatures.data(), hbFeatures.size());
+    unsigned len = hb_buffer_get_length(buffer);
+    hb_glyph_info_t* info = hb_buffer_get_glyph_infos(buffer, nullptr);
+    hb_glyph_position_t* pos = hb_buffer_get_glyph_positions(buffer, nullptr);
+
+    // HarfBuzz leaves the glyphs of rtl runs in visual order, which is what a blob wants.
+    shaped->glyphStart = chunk->fGlyphs.size();
+    shaped->glyphCount = len;
+    SkGlyphID* glyphs = chunk->fGlyphs.append(SkToInt(len));
+    SkPoint* positions = chunk->fPositions.append(SkToInt(len));
+    uint32_t* clusters = chunk->fClusters.append(SkToInt(len));
+
+    // Undo skhb_position with (1.0/(1<<16)) and scale as needed.
+    double SkScalarFromHBPosX = +(1.52587890625e-5) * shaped->font.getScaleX();
+    double SkScalarFromHBPosY = -(1.52587890625e-5);  // HarfBuzz y-up, Skia y-down
+    SkVector advance = { 0, 0 };
+    for (unsigned i = 0; i < len; i++) {
+        glyphs[i] = info[i].codepoint;
+        clusters[i] = info[i].cluster;
+        positions[i] = advance + SkVector::Make(pos[i].x_offset * SkScalarFromHBPosX,
+                                                pos[i].y_offset * SkScalarFromHBPosY);
+        advance += SkVector::Make(pos[i].x_advance * SkScalarFromHBPosX,
+                                  pos[i].y_advance * SkScalarFromHBPosY);
+    }
+    shaped->advance = advance;
+}
+
 }  // namespace
 
+SkShaper::BatchResult SkShaper::ShapeBatch(SkSpan<const BatchRun> runs, SkExecutor* executor) {
+    BatchResult result;
+    result.fRuns.resize(runs.size());
+    const int taskCount = SkToInt((runs.size() + kBatchRunsPerTask - 1) / kBatchRunsPerTask);
+    std::vector<BatchChunk> chunks(taskCount);
+    const hb_language_t undefinedLanguage = hb_language_from_string("und", -1);
+
+    auto shapeTask = [&](int task) {
+        HBBuffer buffer(hb_buffer_create());
+        HBFont hbFont;
+        const size_t begin = task * kBatchRunsPerTask;
+        const size_t end = std::min(begin + kBatchRunsPerTask, runs.size());
+        for (size_t i = begin; i < end; ++i) {
+            BatchResult::Run& shaped = result.fRuns[i];
+            shaped.font = runs[i].font;
+            if (!shaped.font.getTypeface()) {
+                shaped.font.setTypeface(shaped.font.refTypefaceOrDefault());
+            }
+            shaped.glyphStart = 0;
+            shaped.glyphCount = 0;
+            shaped.advance = {0, 0};
+            // Neighbouring runs usually share their font, and so their hb_font.
+            if (i == begin || !(shaped.font == result.fRuns[i - 1].font)) {
+                hbFont = create_hb_font(shaped.font);
+            }
+            if (buffer && hbFont) {
+                shape_batch_run(buffer.get(), hbFont.get(), undefinedLanguage,
+                                runs[i], &shaped, &chunks[task]);
+            }
+        }
+    };
+    if (taskCount > 1) {
+        SkTaskGroup(executor ? *executor : SkExecutor::GetDefault()).batch(taskCount, shapeTask);
+    } else if (taskCount == 1) {
+        shapeTask(0);
+    }
+
+    // Move the glyphs of all the tasks into one allocation, positions first to keep every array
+    // aligned.
+    size_t glyphCount = 0;
+    for (const BatchChunk& chunk : chunks) {
+        glyphCount += chunk.fGlyphs.size();
+    }
+    result.fStorage.reset(
+            new char[glyphCount * (sizeof(SkPoint) + sizeof(uint32_t) + sizeof(SkGlyphID))]);
+    result.fPositions = reinterpret_cast<SkPoint*>(result.fStorage.get());
+    result.fClusters = reinterpret_cast<uint32_t*>(result.fPositions + glyphCount);
+    result.fGlyphs = reinterpret_cast<SkGlyphID*>(result.fClusters + glyphCount);
+
+    std::vector<size_t> chunkStarts(taskCount);
+    size_t glyphStart = 0;
+    for (int task = 0; task < taskCount; ++task) {
+        const BatchChunk& chunk = chunks[task];
+        chunkStarts[task] = glyphStart;
+        const size_t count = chunk.fGlyphs.size();
+        sk_careful_memcpy(result.fPositions + glyphStart, chunk.fPositions.begin(),
+                          count * sizeof(SkPoint));
+        sk_careful_memcpy(result.fClusters + glyphStart, chunk.fClusters.begin(),
+                          count * sizeof(uint32_t));
+        sk_careful_memcpy(result.fGlyphs + glyphStart, chunk.fGlyphs.begin(),
+                          count * sizeof(SkGlyphID));
+        glyphStart += count;
+    }
+    for (size_t i = 0; i < result.fRuns.size(); ++i) {
+        result.fRuns[i].glyphStart += chunkStarts[i / kBatchRunsPerTask];
+    }
+    return result;
+}
+
+void SkShaper::BatchResult::appendRun(size_t index,
+                                      SkTextBlobBuilder* builder,
+                                      SkPoint origin) const {
+    const Run& run = fRuns[index];
+    if (run.glyphCount == 0) {
+        return;
+    }
+    const auto& buffer = builder->allocRunPos(run.font, SkToInt(run.glyphCount));
+    memcpy(buffer.glyphs, fGlyphs + run.glyphStart, run.glyphCount * sizeof(SkGlyphID));
+    SkPoint* points = buffer.points();
+    for (size_t i = 0; i < run.glyphCount; ++i) {
+        points[i] = fPositions[run.glyphStart + i] + origin;
+    }
+}
+
 std::unique_ptr<SkShaper::BiDiRunIterator>
 SkShaper::MakeIcuBiDiRunIterator(const char* utf8, size_t utf8Bytes, uint8_t bidiLevel) {
     auto unicode = SkUnicode::Make();
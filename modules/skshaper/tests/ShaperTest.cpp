@@ -6,6 +6,7 @@
 #if !defined(SK_BUILD_FOR_GOOGLE3)
 
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkPoint.h"
 #include "include/core/SkRefCnt.h"
@@ -20,7 +21,10 @@
 
 #include <cinttypes>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <vector>
 
 namespace {
 struct RunHandler final : public SkShaper::RunHandler {
@@ -193,4 +197,156 @@ SHAPER_TEST(taitham)
 SHAPER_TEST(tamil)
 #undef SHAPER_TEST
 
+namespace {
+// Logs every call a shaper makes, with the glyphs put into each run buffer.
+struct LoggingRunHandler final : public SkShaper::RunHandler {
+    SkString fLog;
+    std::vector<SkGlyphID> fGlyphs;
+    std::vector<SkPoint> fPositions;
+    std::vector<uint32_t> fClusters;
+
+    void beginLine() override { fLog.append("beginLine "); }
+    void runInfo(const RunInfo& info) override {
+        fLog.appendf("runInfo(%zu %zu-%zu) ", info.glyphCount, info.utf8Range.begin(),
+                     info.utf8Range.end());
+    }
+    void commitRunInfo() override { fLog.append("commitRunInfo "); }
+    Buffer runBuffer(const RunInfo& info) override {
+        fLog.appendf("runBuffer(%zu) ", info.glyphCount);
+        const size_t start = fGlyphs.size();
+        fGlyphs.resize(start + info.glyphCount);
+        fPositions.resize(start + info.glyphCount);
+        fClusters.resize(start + info.glyphCount);
+        return {fGlyphs.data() + start, fPositions.data() + start, nullptr,
+                fClusters.data() + start, {SkIntToScalar(start), 0}};
+    }
+    void commitRunBuffer(const RunInfo&) override { fLog.append("commitRunBuffer "); }
+    void commitLine() override { fLog.append("commitLine "); }
+
+    // Positions may be summed up in a different order, so they are only nearly equal.
+    bool operator==(const LoggingRunHandler& other) const {
+        if (fLog != other.fLog || fGlyphs != other.fGlyphs || fClusters != other.fClusters) {
+            return false;
+        }
+        for (size_t i = 0; i < fPositions.size(); ++i) {
+            if (!SkScalarNearlyEqual(fPositions[i].fX, other.fPositions[i].fX) ||
+                !SkScalarNearlyEqual(fPositions[i].fY, other.fPositions[i].fY)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+}  // namespace
+
+DEF_TEST(Shaper_cache, r) {
+    auto shaper = SkShaper::Make();
+    if (!shaper) {
+        ERRORF(r, "Could not create shaper.");
+        return;
+    }
+    sk_sp<SkShaperCache> cache = SkShaperCache::Make(1024 * 1024);
+    auto cachedShaper = SkShaper::MakeCached(SkShaper::Make(), cache);
+
+    SkFont font(SkTypeface::MakeDefault());
+    const char* labels[] = { "", "OK", "Cancel", "12,345.67", "\xd7\xa9\xd7\x9c\xd7\x95\xd7\x9d",
+                             "A label long enough to be wrapped into a few lines" };
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const char* label : labels) {
+            for (bool leftToRight : {true, false}) {
+                LoggingRunHandler expected;
+                shaper->shape(label, strlen(label), font, leftToRight, 100, &expected);
+                LoggingRunHandler cached;
+                cachedShaper->shape(label, strlen(label), font, leftToRight, 100, &cached);
+                REPORTER_ASSERT(r, cached == expected, "\"%s\" pass %d", label, pass);
+            }
+        }
+    }
+    const uint64_t shapes = std::size(labels) * 2;
+    REPORTER_ASSERT(r, cache->misses() == shapes);
+    REPORTER_ASSERT(r, cache->hits() == shapes);
+    REPORTER_ASSERT(r, cache->count() == SkToInt(shapes));
+    REPORTER_ASSERT(r, cache->bytesUsed() <= cache->byteBudget());
+
+    // A different size is a different key.
+    font.setSize(font.getSize() + 1);
+    LoggingRunHandler handler;
+    cachedShaper->shape("OK", 2, font, true, 100, &handler);
+    REPORTER_ASSERT(r, cache->misses() == shapes + 1);
+
+    cache->purge();
+    REPORTER_ASSERT(r, cache->count() == 0);
+    REPORTER_ASSERT(r, cache->bytesUsed() == 0);
+
+    // Results which do not fit into the budget are still shaped, but not kept.
+    sk_sp<SkShaperCache> tinyCache = SkShaperCache::Make(16);
+    auto tinyShaper = SkShaper::MakeCached(SkShaper::Make(), tinyCache);
+    LoggingRunHandler expected, uncached;
+    shaper->shape("OK", 2, font, true, 100, &expected);
+    tinyShaper->shape("OK", 2, font, true, 100, &uncached);
+    REPORTER_ASSERT(r, uncached == expected);
+    REPORTER_ASSERT(r, tinyCache->count() == 0);
+}
+
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+DEF_TEST(Shaper_batch, r) {
+    auto data = GetResourceAsData("text/english.txt");
+    if (!data) {
+        ERRORF(r, "Could not get resource text/english.txt.");
+        return;
+    }
+    const char* text = (const char*)data->data();
+    const size_t size = data->size();
+
+    // Enough words to be split over several tasks, in two sizes to switch fonts between runs.
+    SkFont font(SkTypeface::MakeDefault());
+    SkFont bigFont = font;
+    bigFont.setSize(font.getSize() * 2);
+    constexpr SkFourByteTag latn = SkSetFourByteTag('l','a','t','n');
+    std::vector<SkShaper::BatchRun> runs;
+    for (size_t start = 0; start < size;) {
+        size_t end = start;
+        while (end < size && text[end] != ' ') {
+            ++end;
+        }
+        SkShaper::BatchRun run{text + start, end - start, runs.size() % 3 ? font : bigFont,
+                               runs.size() % 2 ? latn : 0, "en-US", true};
+        runs.push_back(run);
+        start = end + 1;
+    }
+    REPORTER_ASSERT(r, runs.size() > 32);
+
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    SkShaper::BatchResult batch = SkShaper::ShapeBatch(runs, executor.get());
+    REPORTER_ASSERT(r, batch.runs().size() == runs.size());
+
+    SkTextBlobBuilder builder;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        // Each run shapes the same on its own.
+        SkShaper::BatchResult single = SkShaper::ShapeBatch(SkSpan(&runs[i], 1));
+        const auto& expected = single.runs()[0];
+        const auto& run = batch.runs()[i];
+        REPORTER_ASSERT(r, run.glyphCount == expected.glyphCount, "run %zu", i);
+        REPORTER_ASSERT(r, run.advance == expected.advance, "run %zu", i);
+        REPORTER_ASSERT(r, run.font == expected.font, "run %zu", i);
+        if (runs[i].utf8Bytes > 0) {
+            REPORTER_ASSERT(r, run.glyphCount > 0, "run %zu", i);
+        }
+        if (run.glyphCount != expected.glyphCount) {
+            continue;
+        }
+        for (size_t g = 0; g < run.glyphCount; ++g) {
+            REPORTER_ASSERT(r, batch.glyphs()[run.glyphStart + g] ==
+                               single.glyphs()[expected.glyphStart + g], "run %zu", i);
+            REPORTER_ASSERT(r, batch.positions()[run.glyphStart + g] ==
+                               single.positions()[expected.glyphStart + g], "run %zu", i);
+            REPORTER_ASSERT(r, batch.clusters()[run.glyphStart + g] < runs[i].utf8Bytes,
+                            "run %zu", i);
+        }
+        batch.appendRun(i, &builder, {0, SkIntToScalar(i) * 20});
+    }
+    REPORTER_ASSERT(r, builder.make() != nullptr);
+}
+#endif
+
 #endif  // defined(SKSHAPER_IMPLEMENTATION) && !defined(SK_BUILD_FOR_GOOGLE3)
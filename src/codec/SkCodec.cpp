@@ -27,6 +27,7 @@
 #include "src/codec/SkBmpCodec.h"
 #include "src/codec/SkWbmpCodec.h"
 
+#include <cstring>
 #include <utility>
 
 #ifdef SK_HAS_ANDROID_CODEC
@@ -106,6 +107,49 @@ static std::vector<DecoderProc>* decoders() {
     return decoders;
 }
 
+#ifdef SK_HAS_WUFFS_LIBRARY
+static bool probe_gif(const uint8_t* data, size_t length, SkCodec::ProbeResult* result) {
+    // "GIF87a" or "GIF89a", followed by the little-endian logical screen width and height.
+    if (length < 10 || memcmp(data, "GIF8", 4) || (data[4] != '7' && data[4] != '9') ||
+            data[5] != 'a') {
+        return false;
+    }
+    result->fFormat = SkEncodedImageFormat::kGIF;
+    result->fDimensions = { data[6] | (data[7] << 8), data[8] | (data[9] << 8) };
+    return !result->fDimensions.isEmpty();
+}
+#endif
+
+bool SkCodec::ProbeInfo(const void* data, size_t length, ProbeResult* result) {
+    if (!data || !result) {
+        return false;
+    }
+    *result = ProbeResult();
+    [[maybe_unused]] const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+#ifdef SK_CODEC_DECODES_JPEG
+    if (SkJpegCodec::IsJpeg(data, length)) {
+        return SkJpegCodec::Probe(bytes, length, result);
+    }
+#endif
+#ifdef SK_CODEC_DECODES_PNG
+    if (SkPngCodec::IsPng(data, length)) {
+        return SkPngCodec::Probe(bytes, length, result);
+    }
+#endif
+#ifdef SK_CODEC_DECODES_WEBP
+    if (SkWebpCodec::IsWebp(data, length)) {
+        return SkWebpCodec::Probe(bytes, length, result);
+    }
+#endif
+#ifdef SK_HAS_WUFFS_LIBRARY
+    if (probe_gif(bytes, length, result)) {
+        return true;
+    }
+#endif
+    return false;
+}
+
 void SkCodec::Register(
             bool                     (*peek)(const void*, size_t),
             std::unique_ptr<SkCodec> (*make)(std::unique_ptr<SkStream>, SkCodec::Result*)) {
@@ -57,6 +57,69 @@ bool SkJpegCodec::IsJpeg(const void* buffer, size_t bytesRead) {
     return bytesRead >= sizeof(kJpegSig) && !memcmp(buffer, kJpegSig, sizeof(kJpegSig));
 }
 
+static uint16_t read_be16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+bool SkJpegCodec::Probe(const uint8_t* data, size_t length, ProbeResult* result) {
+    result->fFormat = SkEncodedImageFormat::kJPEG;
+
+    bool foundFrame = false;
+    size_t offset = 2;  // Skip StartOfImage.
+    while (offset + 4 <= length) {
+        if (data[offset] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = data[offset + 1];
+        if (marker == 0xFF) {
+            // Fill byte.
+            offset++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            // TEM and RSTn stand alone.
+            offset += 2;
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            // EndOfImage or StartOfScan: every header we care about comes before this.
+            break;
+        }
+
+        const size_t segmentLength = read_be16(data + offset + 2);
+        const uint8_t* params = data + offset + 4;
+        if (segmentLength < 2 || offset + 2 + segmentLength > length) {
+            return false;
+        }
+        const size_t paramsLength = segmentLength - 2;
+
+        // SOFn, excluding DHT (C4), JPG (C8) and DAC (CC), which share the range.
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+                marker != 0xCC) {
+            if (paramsLength < 5) {
+                return false;
+            }
+            result->fDimensions = { read_be16(params + 3), read_be16(params + 1) };
+            foundFrame = true;
+        } else if (marker == kExifMarker && paramsLength >= kExifHeaderSize &&
+                   !memcmp(params, kExifSig, sizeof(kExifSig))) {
+            // Account for 'E', 'x', 'i', 'f', '\0', '<fill byte>'.
+            constexpr size_t kOffset = 6;
+            SkParseEncodedOrigin(params + kOffset, paramsLength - kOffset, &result->fOrigin);
+        } else if (marker == kICCMarker && paramsLength >= kICCMarkerHeaderSize &&
+                   !memcmp(params, kICCSig, sizeof(kICCSig))) {
+            result->fHasColorProfile = true;
+            // Only a profile that fits in one marker can be handed back without copying.
+            if (params[13] == 1 && params[12] == 1) {
+                result->fICCProfile     = params + kICCMarkerHeaderSize;
+                result->fICCProfileSize = paramsLength - kICCMarkerHeaderSize;
+            }
+        }
+        offset += 2 + segmentLength;
+    }
+    return foundFrame && !result->fDimensions.isEmpty();
+}
+
 static bool is_orientation_marker(jpeg_marker_struct* marker, SkEncodedOrigin* orientation) {
     if (kExifMarker != marker->marker || marker->data_length < kExifHeaderSize) {
         return false;
@@ -42,6 +42,12 @@ public:
 
     static bool IsJpeg(const void*, size_t);
 
+    /*
+     * Assumes IsJpeg was called and returned true. Walks the markers up to the
+     * first StartOfScan without involving libjpeg. See SkCodec::ProbeInfo.
+     */
+    static bool Probe(const uint8_t*, size_t, ProbeResult*);
+
     /*
      * Assumes IsJpeg was called and returned true
      * Takes ownership of the stream
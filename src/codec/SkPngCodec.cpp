@@ -342,6 +342,53 @@ bool SkPngCodec::IsPng(const void* buf, size_t bytesRead) {
     return !png_sig_cmp((png_bytep) buf, (png_size_t)0, bytesRead);
 }
 
+static uint32_t read_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+bool SkPngCodec::Probe(const uint8_t* data, size_t length, ProbeResult* result) {
+    result->fFormat = SkEncodedImageFormat::kPNG;
+
+    // Each chunk is a 4-byte length, a 4-byte type, the data, and a 4-byte CRC.
+    constexpr size_t kSignatureSize = 8,
+                     kChunkHeaderSize = 8,
+                     kCRCSize = 4,
+                     kIHDRSize = 13;
+    size_t offset = kSignatureSize;
+    if (length < offset + kChunkHeaderSize + kIHDRSize ||
+            memcmp(data + offset + 4, "IHDR", 4) ||
+            read_be32(data + offset) != kIHDRSize) {
+        return false;
+    }
+    const uint32_t width  = read_be32(data + offset + kChunkHeaderSize),
+                   height = read_be32(data + offset + kChunkHeaderSize + 4);
+    // libpng rejects dimensions that do not fit in a signed 32-bit int.
+    if (width == 0 || height == 0 || width > PNG_UINT_31_MAX || height > PNG_UINT_31_MAX) {
+        return false;
+    }
+    result->fDimensions = { (int)width, (int)height };
+
+    // Color information must come before the image data, so stop at the first IDAT.
+    offset += kChunkHeaderSize + kIHDRSize + kCRCSize;
+    while (offset + kChunkHeaderSize <= length) {
+        const uint8_t* chunk = data + offset;
+        const uint32_t chunkSize = read_be32(chunk);
+        if (!memcmp(chunk + 4, "IDAT", 4)) {
+            break;
+        }
+        if (!memcmp(chunk + 4, "iCCP", 4) || !memcmp(chunk + 4, "sRGB", 4)) {
+            // iCCP is zlib-compressed, so fICCProfile is left unset.
+            result->fHasColorProfile = true;
+            break;
+        }
+        if (chunkSize > length - offset - kChunkHeaderSize) {
+            break;
+        }
+        offset += kChunkHeaderSize + chunkSize + kCRCSize;
+    }
+    return true;
+}
+
 #if (PNG_LIBPNG_VER_MAJOR > 1) || (PNG_LIBPNG_VER_MAJOR == 1 && PNG_LIBPNG_VER_MINOR >= 6)
 
 static float png_fixed_point_to_float(png_fixed_point x) {
@@ -28,6 +28,10 @@ class SkPngCodec : public SkCodec {
 public:
     static bool IsPng(const void*, size_t);
 
+    // Assume IsPng was called and returned true. Reads IHDR and scans the chunks before the
+    // first IDAT without involving libpng. See SkCodec::ProbeInfo.
+    static bool Probe(const uint8_t*, size_t, ProbeResult*);
+
     // Assume IsPng was called and returned true.
     static std::unique_ptr<SkCodec> MakeFromStream(std::unique_ptr<SkStream>, Result*,
                                                    SkPngChunkReader* = nullptr);
@@ -17,6 +17,10 @@
 #include "src/codec/SkSampler.h"
 #include "src/core/SkMathPriv.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
 SkSampledCodec::SkSampledCodec(SkCodec* codec)
     : INHERITED(codec)
 {}
@@ -77,6 +81,11 @@ SkISize SkSampledCodec::onGetSampledDimensions(int sampleSize) const {
 
 SkCodec::Result SkSampledCodec::onGetAndroidPixels(const SkImageInfo& info, void* pixels,
         size_t rowBytes, const AndroidOptions& options) {
+    if (options.fDownsample == AndroidOptions::Downsample::kAreaAverage &&
+            info.dimensions() != this->codec()->dimensions()) {
+        return this->areaAverageDecode(info, pixels, rowBytes, options);
+    }
+
     const SkIRect* subset = options.fSubset;
     if (!subset || subset->size() == this->codec()->dimensions()) {
         if (this->codec()->dimensionsSupported(info.dimensions())) {
@@ -351,3 +360,117 @@ SkCodec::Result SkSampledCodec::sampledDecode(const SkImageInfo& info, void* pix
             return SkCodec::kUnimplemented;
     }
 }
+
+SkCodec::Result SkSampledCodec::areaAverageDecode(const SkImageInfo& info, void* pixels,
+        size_t rowBytes, const AndroidOptions& options) {
+    if (options.fSubset) {
+        return SkCodec::kUnimplemented;
+    }
+
+    int channels;
+    switch (info.colorType()) {
+        case kRGBA_8888_SkColorType:
+        case kBGRA_8888_SkColorType:
+            channels = 4;
+            break;
+        case kGray_8_SkColorType:
+            channels = 1;
+            break;
+        default:
+            return SkCodec::kUnimplemented;
+    }
+    if (info.alphaType() == kUnpremul_SkAlphaType &&
+            this->codec()->getInfo().alphaType() != kOpaque_SkAlphaType) {
+        // Averaging unpremultiplied colors would bleed the color of transparent pixels.
+        return SkCodec::kUnimplemented;
+    }
+
+    const SkISize srcSize = this->codec()->dimensions();
+    const int dstWidth  = info.width(),
+              dstHeight = info.height();
+    if (dstWidth <= 0 || dstHeight <= 0 ||
+            dstWidth > srcSize.width() || dstHeight > srcSize.height()) {
+        return SkCodec::kInvalidScale;
+    }
+
+    // Let fCodec do as much of the reduction as it can natively, as long as it stays at least
+    // as large as the destination.
+    SkISize nativeSize = srcSize;
+    int sampleSize = std::min(srcSize.width() / dstWidth, srcSize.height() / dstHeight);
+    if (sampleSize > 1) {
+        nativeSize = this->accountForNativeScaling(&sampleSize);
+        if (nativeSize.width() < dstWidth || nativeSize.height() < dstHeight) {
+            nativeSize = srcSize;
+        }
+    }
+    const int srcWidth  = nativeSize.width(),
+              srcHeight = nativeSize.height();
+
+    // Each accumulator holds the sum of up to (maxSpanX * maxSpanY) 8-bit values.
+    const int64_t maxSpanX = (srcWidth  + dstWidth  - 1) / dstWidth  + 1,
+                  maxSpanY = (srcHeight + dstHeight - 1) / dstHeight + 1;
+    if (maxSpanX * maxSpanY > (int64_t)(UINT32_MAX / 255)) {
+        return SkCodec::kInvalidScale;
+    }
+
+    const SkImageInfo nativeInfo = info.makeDimensions(nativeSize);
+    AndroidOptions nativeOptions = options;
+    nativeOptions.fDownsample = AndroidOptions::Downsample::kPoint;
+    SkCodec::Result result = this->codec()->startScanlineDecode(nativeInfo, &nativeOptions);
+    if (SkCodec::kIncompleteInput == result || SkCodec::kErrorInInput == result) {
+        return SkCodec::kInvalidInput;
+    } else if (SkCodec::kSuccess != result) {
+        return result;
+    }
+    if (this->codec()->getScanlineOrder() != SkCodec::kTopDown_SkScanlineOrder) {
+        return SkCodec::kUnimplemented;
+    }
+
+    // Source column span [srcX[x], srcX[x+1]) contributes to destination column x.
+    SkAutoTMalloc<int> srcX(dstWidth + 1);
+    for (int x = 0; x <= dstWidth; x++) {
+        srcX[x] = (int)((int64_t)x * srcWidth / dstWidth);
+    }
+
+    SkAutoTMalloc<uint8_t>  row(nativeInfo.minRowBytes());
+    SkAutoTMalloc<uint32_t> sums(dstWidth * channels);
+
+    int srcY = 0;
+    for (int y = 0; y < dstHeight; y++) {
+        const int srcBottom = (int)((int64_t)(y + 1) * srcHeight / dstHeight);
+        const int spanY = srcBottom - srcY;
+
+        memset(sums.get(), 0, dstWidth * channels * sizeof(uint32_t));
+        for (; srcY < srcBottom; srcY++) {
+            if (1 != this->codec()->getScanlines(row.get(), 1, 0)) {
+                this->codec()->fillIncompleteImage(info, pixels, rowBytes,
+                        options.fZeroInitialized, dstHeight, y);
+                return SkCodec::kIncompleteInput;
+            }
+
+            uint32_t* sum = sums.get();
+            for (int x = 0; x < dstWidth; x++) {
+                const uint8_t* src = row.get() + srcX[x] * channels;
+                const uint8_t* end = row.get() + srcX[x + 1] * channels;
+                for (; src < end; src += channels) {
+                    for (int c = 0; c < channels; c++) {
+                        sum[c] += src[c];
+                    }
+                }
+                sum += channels;
+            }
+        }
+
+        uint8_t* dst = SkTAddOffset<uint8_t>(pixels, y * rowBytes);
+        const uint32_t* sum = sums.get();
+        for (int x = 0; x < dstWidth; x++) {
+            const uint32_t area = (uint32_t)((srcX[x + 1] - srcX[x]) * spanY);
+            for (int c = 0; c < channels; c++) {
+                dst[c] = (uint8_t)((sum[c] + area / 2) / area);
+            }
+            dst += channels;
+            sum += channels;
+        }
+    }
+    return SkCodec::kSuccess;
+}
@@ -60,6 +60,16 @@ private:
     SkCodec::Result sampledDecode(const SkImageInfo& info, void* pixels, size_t rowBytes,
             const AndroidOptions& options);
 
+    /**
+     *  This fulfills the same contract as onGetAndroidPixels() for
+     *  AndroidOptions::Downsample::kAreaAverage.
+     *
+     *  Each destination row is accumulated from the native rows it covers,
+     *  using one native row and one accumulator row of scratch memory.
+     */
+    SkCodec::Result areaAverageDecode(const SkImageInfo& info, void* pixels, size_t rowBytes,
+            const AndroidOptions& options);
+
     using INHERITED = SkAndroidCodec;
 };
 #endif // SkSampledCodec_DEFINED
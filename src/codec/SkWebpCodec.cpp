@@ -53,6 +53,49 @@ bool SkWebpCodec::IsWebp(const void* buf, size_t bytesRead) {
     return bytesRead >= 14 && !memcmp(bytes, "RIFF", 4) && !memcmp(&bytes[8], "WEBPVP", 6);
 }
 
+static uint32_t read_le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool SkWebpCodec::Probe(const uint8_t* data, size_t length, ProbeResult* result) {
+    result->fFormat = SkEncodedImageFormat::kWEBP;
+
+    // For extended (VP8X) files this reports the canvas size.
+    WebPBitstreamFeatures features;
+    if (VP8_STATUS_OK != WebPGetFeatures(data, length, &features)) {
+        return false;
+    }
+    result->fDimensions = { features.width, features.height };
+
+    // Only extended files can carry ICCP and EXIF chunks. EXIF usually follows the image data,
+    // so walk every chunk; this only touches the 8-byte chunk headers.
+    constexpr size_t kRiffHeaderSize = 12,
+                     kChunkHeaderSize = 8;
+    size_t offset = kRiffHeaderSize;
+    if (length < offset + kChunkHeaderSize || memcmp(data + offset, "VP8X", 4)) {
+        return true;
+    }
+    while (offset + kChunkHeaderSize <= length) {
+        const uint8_t* chunk = data + offset;
+        const size_t chunkSize = read_le32(chunk + 4);
+        if (chunkSize > length - offset - kChunkHeaderSize) {
+            // Truncated; report what we found so far.
+            break;
+        }
+        const uint8_t* payload = chunk + kChunkHeaderSize;
+        if (!memcmp(chunk, "ICCP", 4)) {
+            result->fHasColorProfile = true;
+            result->fICCProfile = payload;
+            result->fICCProfileSize = chunkSize;
+        } else if (!memcmp(chunk, "EXIF", 4)) {
+            SkParseEncodedOrigin(payload, chunkSize, &result->fOrigin);
+        }
+        // Chunks are padded to an even size.
+        offset += kChunkHeaderSize + chunkSize + (chunkSize & 1);
+    }
+    return true;
+}
+
 // Parse headers of RIFF container, and check for valid Webp (VP8) content.
 // Returns an SkWebpCodec on success
 std::unique_ptr<SkCodec> SkWebpCodec::MakeFromStream(std::unique_ptr<SkStream> stream,
@@ -37,6 +37,9 @@ public:
     // Assumes IsWebp was called and returned true.
     static std::unique_ptr<SkCodec> MakeFromStream(std::unique_ptr<SkStream>, Result*);
     static bool IsWebp(const void*, size_t);
+    // Assumes IsWebp was called and returned true. Walks the RIFF chunks without creating a
+    // demuxer. See SkCodec::ProbeInfo.
+    static bool Probe(const uint8_t*, size_t, ProbeResult*);
 protected:
     Result onGetPixels(const SkImageInfo&, void*, size_t, const Options&, int*) override;
     SkEncodedImageFormat onGetEncodedFormat() const override { return SkEncodedImageFormat::kWEBP; }
@@ -22,6 +22,7 @@
 #include "src/core/SkGeometry.h"
 #include "src/core/SkImageFilter_Base.h"
 #include "src/core/SkOpts.h"
+#include "src/core/SkPersistentGlyphCache.h"
 #include "src/core/SkResourceCache.h"
 #include "src/core/SkScalerContext.h"
 #include "src/core/SkStrikeCache.h"
@@ -126,6 +127,18 @@ void SkGraphics::PurgeFontCache() {
     SkTypefaceCache::PurgeAll();
 }
 
+bool SkGraphics::SetPersistentFontCache(const char directory[], size_t byteBudget) {
+    sk_sp<SkPersistentGlyphCache> cache;
+    if (directory != nullptr) {
+        cache = SkPersistentGlyphCache::Make(directory, byteBudget);
+        if (cache == nullptr) {
+            return false;
+        }
+    }
+    SkStrikeCache::GlobalStrikeCache()->setPersistentGlyphCache(std::move(cache));
+    return true;
+}
+
 static SkGraphics::OpenTypeSVGDecoderFactory gSVGDecoderFactory = nullptr;
 
 SkGraphics::OpenTypeSVGDecoderFactory
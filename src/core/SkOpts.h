@@ -94,6 +94,9 @@ namespace SkOpts {
                            grayA_to_RGBA,   // i.e. expand to color channels
                            grayA_to_rgbA;   // i.e. expand to color channels and premultiply
 
+    // Expand 8-bit palette indices into 8888 pixels by looking each one up in a 256-entry table.
+    extern void (*index_to_8888)(uint32_t*, const uint8_t*, int, const uint32_t ctable[]);
+
     extern void (*memset16)(uint16_t[], uint16_t, int);
     extern void SK_SPI(*memset32)(uint32_t[], uint32_t, int);
     extern void (*memset64)(uint64_t[], uint64_t, int);
@@ -0,0 +1,475 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkPersistentGlyphCache.h"
+
+#include "include/core/SkStream.h"
+#include "include/core/SkTime.h"
+#include "include/core/SkTypeface.h"
+#include "include/private/base/SkAlign.h"
+#include "include/private/base/SkTo.h"
+#include "src/core/SkAutoMalloc.h"
+#include "src/core/SkDescriptor.h"
+#include "src/core/SkOSFile.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkScalerContext.h"
+#include "src/utils/SkOSPath.h"
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+namespace {
+constexpr uint32_t kMagic = SkSetFourByteTag('s', 'k', 'g', 'c');
+constexpr char kSuffix[] = ".glyphs";
+// A strike file is written under a temporary name first (see Strike::flush).
+constexpr char kTmpSuffix[] = ".tmp";
+
+// Startup eviction leaves this much of the budget free for the glyphs of the new process.
+constexpr size_t kStartupFreeFraction = 4;
+
+// Temporary files this old were left behind by a process that died while writing them.
+constexpr int64_t kStaleTmpSeconds = 60 * 60;
+
+// How often to list the directory again while the budget is used up. Only startup eviction
+// frees space, so there is no point in listing it on every flush.
+constexpr double kFullScanIntervalMs = 10 * 1000;
+
+struct FileHeader {
+    uint32_t fMagic;
+    uint32_t fVersion;
+    uint32_t fKeyLength;  // followed by the key, padded to 4 bytes
+};
+
+struct RecordHeader {
+    uint32_t fPackedID;
+    uint16_t fWidth;
+    uint16_t fHeight;
+    int16_t  fLeft;
+    int16_t  fTop;
+    uint8_t  fFormat;
+    uint8_t  fPad[3];
+    uint32_t fImageSize;  // followed by the image, padded to 4 bytes
+    uint32_t fChecksum;   // of the fields above and the image
+};
+static_assert(sizeof(RecordHeader) == 24, "RecordHeader must be packed");
+
+uint32_t record_checksum(const RecordHeader& record, const void* image) {
+    RecordHeader fields = record;
+    fields.fChecksum = 0;
+    uint32_t seed = SkOpts::hash_fn(&fields, sizeof(fields), 0);
+    return SkOpts::hash_fn(image, record.fImageSize, seed);
+}
+
+bool file_size_and_time(const char path[], size_t* size, int64_t* mtime) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    *size = SkToSizeT(st.st_size);
+    *mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+}
+
+struct File {
+    SkString fPath;
+    size_t fSize;
+    int64_t fMTime;
+    bool fTemporary;
+};
+
+// The strike files and the temporary files being written, which count against the budget too.
+std::vector<File> list_files(const char directory[], size_t* totalSize) {
+    std::vector<File> files;
+    *totalSize = 0;
+    for (const char* suffix : {kSuffix, kTmpSuffix}) {
+        SkOSFile::Iter iter(directory, suffix);
+        for (SkString name; iter.next(&name);) {
+            File file{SkOSPath::Join(directory, name.c_str()), 0, 0, suffix == kTmpSuffix};
+            if (file_size_and_time(file.fPath.c_str(), &file.fSize, &file.fMTime)) {
+                *totalSize += file.fSize;
+                files.push_back(std::move(file));
+            }
+        }
+    }
+    return files;
+}
+
+// Identifies the font the glyphs come from in every process: a hash of all of its data, the
+// collection index and the variation position. Names and tables like 'head' are not enough;
+// different builds of a font can share them, and variable instances share all of them.
+sk_sp<SkData> make_font_identity(const SkTypeface& typeface) {
+    int ttcIndex = 0;
+    std::unique_ptr<SkStreamAsset> stream = typeface.openStream(&ttcIndex);
+    if (stream == nullptr || !stream->hasLength()) {
+        return nullptr;
+    }
+
+    const size_t length = stream->getLength();
+    uint32_t hashes[2] = {0, 1};
+    if (const void* base = stream->getMemoryBase()) {
+        hashes[0] = SkOpts::hash_fn(base, length, hashes[0]);
+        hashes[1] = SkOpts::hash_fn(base, length, hashes[1]);
+    } else {
+        constexpr size_t kChunkSize = 64 * 1024;
+        SkAutoMalloc chunk(kChunkSize);
+        size_t hashed = 0;
+        while (size_t read = stream->read(chunk.get(), kChunkSize)) {
+            hashes[0] = SkOpts::hash_fn(chunk.get(), read, hashes[0]);
+            hashes[1] = SkOpts::hash_fn(chunk.get(), read, hashes[1]);
+            hashed += read;
+        }
+        if (hashed != length) {
+            return nullptr;
+        }
+    }
+
+    SkDynamicMemoryWStream identity;
+    identity.write(hashes, sizeof(hashes));
+    const uint64_t length64 = length;
+    identity.write(&length64, sizeof(length64));
+    identity.write32(SkToU32(ttcIndex));
+
+    const int axisCount = typeface.getVariationDesignPosition(nullptr, 0);
+    if (axisCount > 0) {
+        std::vector<SkFontArguments::VariationPosition::Coordinate> position(axisCount);
+        if (typeface.getVariationDesignPosition(position.data(), axisCount) != axisCount) {
+            return nullptr;
+        }
+        identity.write32(SkToU32(axisCount));
+        for (const auto& coordinate : position) {
+            identity.write32(coordinate.axis);
+            identity.writeScalar(coordinate.value);
+        }
+    } else {
+        identity.write32(0);
+    }
+    return identity.detachAsData();
+}
+}  // namespace
+
+sk_sp<SkPersistentGlyphCache> SkPersistentGlyphCache::Make(const char directory[],
+                                                           size_t byteBudget) {
+    if (directory == nullptr || !sk_mkdir(directory)) {
+        return nullptr;
+    }
+
+    size_t bytesUsed;
+    std::vector<File> files = list_files(directory, &bytesUsed);
+    const int64_t now = static_cast<int64_t>(std::time(nullptr));
+    for (File& file : files) {
+        if (file.fTemporary && now - file.fMTime > kStaleTmpSeconds &&
+            std::remove(file.fPath.c_str()) == 0) {
+            bytesUsed -= file.fSize;
+            file.fSize = 0;
+        }
+    }
+    if (bytesUsed > byteBudget) {
+        // Deleting only unlinks the files, so processes that have them mapped are not affected.
+        std::sort(files.begin(), files.end(), [](const File& a, const File& b) {
+            return a.fMTime < b.fMTime;
+        });
+        const size_t target = byteBudget - byteBudget / kStartupFreeFraction;
+        for (const File& file : files) {
+            if (bytesUsed <= target) {
+                break;
+            }
+            if (file.fSize > 0 && std::remove(file.fPath.c_str()) == 0) {
+                bytesUsed -= file.fSize;
+            }
+        }
+    }
+
+    return sk_sp<SkPersistentGlyphCache>(
+            new SkPersistentGlyphCache(SkString(directory), byteBudget, bytesUsed));
+}
+
+SkPersistentGlyphCache::SkPersistentGlyphCache(SkString directory,
+                                               size_t byteBudget,
+                                               size_t bytesUsed)
+        : fDirectory{std::move(directory)}
+        , fByteBudget{byteBudget}
+        , fBytesUsed{bytesUsed}
+        , fRoomAtLastScan{byteBudget - std::min(bytesUsed, byteBudget)} {}
+
+size_t SkPersistentGlyphCache::bytesUsed() const {
+    size_t bytesUsed;
+    (void)list_files(fDirectory.c_str(), &bytesUsed);
+    return bytesUsed;
+}
+
+bool SkPersistentGlyphCache::reserve(size_t bytes) {
+    if (bytes > fByteBudget) {
+        return false;
+    }
+    SkAutoMutexExclusive lock{fUsageMutex};
+    // The count only sees what this process writes, so list the directory again to catch up
+    // with the other processes once this one has written half of the room left at the last
+    // listing. Processes writing at the same moment can still overshoot the budget a little.
+    const bool full = fBytesUsed > fByteBudget - bytes;
+    bool scan = fWrittenSinceScan + bytes > fRoomAtLastScan / 2;
+    if (full) {
+        scan = SkTime::GetMSecs() >= fNextFullScanMs;
+    }
+    if (scan) {
+        fBytesUsed = this->bytesUsed();
+        fRoomAtLastScan = fByteBudget - std::min(fBytesUsed, fByteBudget);
+        fWrittenSinceScan = 0;
+    }
+    if (fBytesUsed > fByteBudget - bytes) {
+        fNextFullScanMs = SkTime::GetMSecs() + kFullScanIntervalMs;
+        return false;
+    }
+    fBytesUsed += bytes;
+    fWrittenSinceScan += bytes;
+    return true;
+}
+
+void SkPersistentGlyphCache::release(size_t bytes) {
+    SkAutoMutexExclusive lock{fUsageMutex};
+    fBytesUsed -= std::min(bytes, fBytesUsed);
+    fWrittenSinceScan -= std::min(bytes, fWrittenSinceScan);
+}
+
+sk_sp<SkData> SkPersistentGlyphCache::makeKey(const SkDescriptor& desc,
+                                              const SkTypeface& typeface) {
+    sk_sp<SkData> identity;
+    bool found = false;
+    {
+        SkAutoMutexExclusive lock{fIdentitiesMutex};
+        if (sk_sp<SkData>* cached = fIdentities.find(typeface.uniqueID())) {
+            identity = *cached;
+            found = true;
+        }
+    }
+    if (!found) {
+        // Hash outside the lock; strikes of other typefaces should not wait for it.
+        identity = make_font_identity(typeface);
+        SkAutoMutexExclusive lock{fIdentitiesMutex};
+        fIdentities.set(typeface.uniqueID(), identity);
+    }
+    if (identity == nullptr) {
+        return nullptr;
+    }
+
+    // The typeface ID in the descriptor is only unique within a process.
+    std::unique_ptr<SkDescriptor> copy = desc.copy();
+    auto rec = static_cast<const SkScalerContextRec*>(
+            copy->findEntry(kRec_SkDescriptorTag, nullptr));
+    if (rec != nullptr) {
+        const_cast<SkScalerContextRec*>(rec)->fTypefaceID = 0;
+    }
+    copy->computeChecksum();
+
+    SkDynamicMemoryWStream key;
+    key.write(copy.get(), copy->getLength());
+    key.write(identity->data(), identity->size());
+    return key.detachAsData();
+}
+
+sk_sp<SkPersistentGlyphCache::Strike> SkPersistentGlyphCache::openStrike(
+        const SkDescriptor& desc, const SkTypeface& typeface) {
+    return sk_sp<Strike>(new Strike(sk_ref_sp(this), desc, typeface));
+}
+
+SkPersistentGlyphCache::Strike::Strike(sk_sp<SkPersistentGlyphCache> cache,
+                                       const SkDescriptor& desc,
+                                       const SkTypeface& typeface)
+        : fCache{std::move(cache)}
+        , fDesc{desc.copy()}
+        , fTypeface{sk_ref_sp(&typeface)} {}
+
+void SkPersistentGlyphCache::Strike::open() {
+    if (fOpened) {
+        return;
+    }
+    fOpened = true;
+    fKey = fCache->makeKey(*fDesc, *fTypeface);
+    fDesc = nullptr;
+    fTypeface = nullptr;
+    if (fKey == nullptr) {
+        return;
+    }
+
+    SkString name = SkStringPrintf("%08x%08x%s",
+                                   SkOpts::hash_fn(fKey->data(), fKey->size(), 0),
+                                   SkOpts::hash_fn(fKey->data(), fKey->size(), 1),
+                                   kSuffix);
+    fPath = SkOSPath::Join(fCache->fDirectory.c_str(), name.c_str());
+    this->readFile();
+
+    SkAutoMutexExclusive lock{fPendingMutex};
+    fFileExists = fData != nullptr;
+}
+
+int SkPersistentGlyphCache::Strike::count() {
+    this->open();
+    return fIndex.count();
+}
+
+void SkPersistentGlyphCache::Strike::readFile() {
+    fIndex.reset();
+    fData = SkData::MakeFromFileName(fPath.c_str());
+    if (fData == nullptr) {
+        return;
+    }
+
+    const uint8_t* bytes = fData->bytes();
+    const size_t size = fData->size();
+    FileHeader header;
+    const size_t keySize = fKey->size();
+    if (size < sizeof(header) + SkAlign4(keySize)) {
+        fData = nullptr;
+        return;
+    }
+    memcpy(&header, bytes, sizeof(header));
+    if (header.fMagic != kMagic || header.fVersion != kVersion ||
+        header.fKeyLength != keySize || memcmp(bytes + sizeof(header), fKey->data(), keySize) != 0)
+    {
+        fData = nullptr;
+        return;
+    }
+
+    // Stop at the first record that does not check out; whatever follows it is not trusted.
+    size_t offset = sizeof(header) + SkAlign4(keySize);
+    while (size - offset >= sizeof(RecordHeader)) {
+        RecordHeader record;
+        memcpy(&record, bytes + offset, sizeof(record));
+        const size_t recordSize = sizeof(record) + SkAlign4(record.fImageSize);
+        if (record.fImageSize > size - offset - sizeof(record) ||
+            record_checksum(record, bytes + offset + sizeof(record)) != record.fChecksum)
+        {
+            break;
+        }
+        SkPackedGlyphID packedID{record.fPackedID};
+        if (fIndex.find(packedID) == nullptr) {
+            fIndex.set(packedID, offset);
+        }
+        if (recordSize > size - offset) {
+            break;
+        }
+        offset += recordSize;
+    }
+}
+
+const void* SkPersistentGlyphCache::Strike::findImage(const SkGlyph& glyph) {
+    this->open();
+    const size_t* offset = fIndex.find(glyph.getPackedID());
+    if (offset == nullptr) {
+        return nullptr;
+    }
+
+    RecordHeader record;
+    memcpy(&record, fData->bytes() + *offset, sizeof(record));
+    if (record.fWidth != glyph.width() || record.fHeight != glyph.height() ||
+        record.fLeft != glyph.left() || record.fTop != glyph.top() ||
+        record.fFormat != glyph.maskFormat() || record.fImageSize != glyph.imageSize())
+    {
+        return nullptr;
+    }
+    return fData->bytes() + *offset + sizeof(record);
+}
+
+void SkPersistentGlyphCache::Strike::addImages(SkSpan<SkGlyph* const> glyphs) {
+    this->open();
+    if (fKey == nullptr) {
+        return;
+    }
+
+    SkAutoMutexExclusive lock{fPendingMutex};
+    for (const SkGlyph* glyph : glyphs) {
+        const SkPackedGlyphID packedID = glyph->getPackedID();
+        if (glyph->image() == nullptr ||
+            fIndex.find(packedID) != nullptr || fAdded.contains(packedID)) {
+            continue;
+        }
+        fAdded.add(packedID);
+
+        RecordHeader record = {};
+        record.fPackedID = packedID.value();
+        record.fWidth = SkToU16(glyph->width());
+        record.fHeight = SkToU16(glyph->height());
+        record.fLeft = SkToS16(glyph->left());
+        record.fTop = SkToS16(glyph->top());
+        record.fFormat = SkToU8(glyph->maskFormat());
+        record.fImageSize = SkToU32(glyph->imageSize());
+        record.fChecksum = record_checksum(record, glyph->image());
+        fPending.write(&record, sizeof(record));
+        fPending.write(glyph->image(), record.fImageSize);
+        fPending.padToAlign4();
+    }
+}
+
+void SkPersistentGlyphCache::Strike::flush() {
+    SkAutoMutexExclusive lock{fPendingMutex};
+    if (fPending.bytesWritten() == 0) {
+        return;
+    }
+    // fKey and fPath were set by open before anything was queued.
+    sk_sp<SkData> records = fPending.detachAsData();
+
+    if (fFileExists) {
+        // Appends are written with a single unbuffered write, so appends from several processes
+        // do not interleave.
+        if (!fCache->reserve(records->size())) {
+            return;
+        }
+        FILE* file = std::fopen(fPath.c_str(), "ab");
+        if (file == nullptr) {
+            fCache->release(records->size());
+            return;
+        }
+        std::setvbuf(file, nullptr, _IONBF, 0);
+        if (sk_fwrite(records->data(), records->size(), file) != records->size()) {
+            fCache->release(records->size());
+        }
+        sk_fclose(file);
+        return;
+    }
+
+    // There is no usable file yet. Write a complete one next to it, then move it into place, so
+    // other processes never see a file without its header.
+    FileHeader header{kMagic, kVersion, SkToU32(fKey->size())};
+    SkDynamicMemoryWStream file;
+    file.write(&header, sizeof(header));
+    file.write(fKey->data(), fKey->size());
+    file.padToAlign4();
+    file.write(records->data(), records->size());
+    if (!fCache->reserve(file.bytesWritten())) {
+        return;
+    }
+
+    SkString tmpPath = SkStringPrintf("%s.%p.%llx.tmp", fPath.c_str(), this,
+                                      static_cast<unsigned long long>(SkTime::GetNSecs()));
+    bool written;
+    {
+        SkFILEWStream tmp(tmpPath.c_str());
+        written = tmp.isValid() && file.writeToStream(&tmp);
+    }
+    if (!written) {
+        std::remove(tmpPath.c_str());
+        fCache->release(file.bytesWritten());
+        return;
+    }
+    // rename does not replace existing files on all platforms. The file being replaced is
+    // unusable (another version's, or truncated), and no longer counts against the budget.
+    size_t replacedSize;
+    int64_t replacedMTime;
+    if (file_size_and_time(fPath.c_str(), &replacedSize, &replacedMTime) &&
+        std::remove(fPath.c_str()) == 0) {
+        fCache->release(replacedSize);
+    }
+    if (std::rename(tmpPath.c_str(), fPath.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        fCache->release(file.bytesWritten());
+        return;
+    }
+    fFileExists = true;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2023 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPersistentGlyphCache_DEFINED
+#define SkPersistentGlyphCache_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSpan.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkString.h"
+#include "include/core/SkTypeface.h"
+#include "include/private/base/SkMutex.h"
+#include "src/core/SkDescriptor.h"
+#include "src/core/SkGlyph.h"
+#include "src/core/SkTHash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// A glyph image store on disk, which processes rendering the same text can share so that they
+// do not all have to rasterize the same glyphs again.
+//
+// Each strike has one file in the directory. The file starts with the strike's key, which is its
+// SkDescriptor with the process specific typeface ID replaced by a hash of the font's data and
+// its variation position, and is followed by an append only log of glyph images. Fonts whose
+// data cannot be read have no stable identity, and their glyphs are not stored. Files are mapped
+// into memory when a strike is first used, and are checked entry by entry, so a file that is
+// truncated, written by another version or racing with another process only loses glyphs.
+class SkPersistentGlyphCache : public SkNVRefCnt<SkPersistentGlyphCache> {
+public:
+    static constexpr uint32_t kVersion = 2;
+
+    // Store the glyph images in directory, which is created if needed. When the files already in
+    // the directory exceed byteBudget, the least recently written ones are deleted, and new
+    // images are not stored once the files in the directory use up the budget.
+    static sk_sp<SkPersistentGlyphCache> Make(const char directory[], size_t byteBudget);
+
+    // The stored images of one strike. findImage and addImages must be called under the lock of
+    // the strike that owns this; flush may be called without it.
+    class Strike : public SkNVRefCnt<Strike> {
+    public:
+        // Return the stored image of glyph, or nullptr if there is none with glyph's bounds and
+        // format.
+        const void* findImage(const SkGlyph& glyph);
+
+        // Queue the images of glyphs that are not yet stored to be written by flush.
+        void addImages(SkSpan<SkGlyph* const> glyphs);
+
+        // Append the queued images to the strike's file, if they fit in the budget.
+        void flush() SK_EXCLUDES(fPendingMutex);
+
+        // The number of images in the file when it was mapped.
+        int count();
+
+    private:
+        friend class SkPersistentGlyphCache;
+        Strike(sk_sp<SkPersistentGlyphCache> cache, const SkDescriptor& desc,
+               const SkTypeface& typeface);
+
+        // Find and map the strike's file. Making the key reads all of the font's data, so this
+        // waits until a glyph is looked up instead of happening when the strike is created.
+        void open();
+        void readFile();
+
+        const sk_sp<SkPersistentGlyphCache> fCache;
+        // What the key is made from, until the strike is opened.
+        std::unique_ptr<SkDescriptor> fDesc;
+        sk_sp<SkTypeface> fTypeface;
+        bool fOpened = false;
+        // The key is nullptr if the font has no stable identity; then nothing is stored.
+        sk_sp<SkData> fKey;
+        SkString fPath;
+        // The mapped file, and the offsets of the images in it.
+        sk_sp<SkData> fData;
+        SkTHashMap<SkPackedGlyphID, size_t, SkPackedGlyphID::Hash> fIndex;
+        // Glyphs this process queued after the file was mapped.
+        SkTHashSet<SkPackedGlyphID, SkPackedGlyphID::Hash> fAdded;
+
+        SkMutex fPendingMutex;
+        SkDynamicMemoryWStream fPending SK_GUARDED_BY(fPendingMutex);
+        bool fFileExists SK_GUARDED_BY(fPendingMutex) = false;
+    };
+
+    // Make a strike for the stored images of desc. Nothing is read until it is used.
+    sk_sp<Strike> openStrike(const SkDescriptor& desc, const SkTypeface& typeface);
+
+    // The size of all the files in the directory, including those written by other processes.
+    // This lists the directory; the budget checks use a count kept in memory instead.
+    size_t bytesUsed() const;
+    size_t byteBudget() const { return fByteBudget; }
+
+private:
+    SkPersistentGlyphCache(SkString directory, size_t byteBudget, size_t bytesUsed);
+
+    // Return the strike's key, or nullptr if the typeface has no stable identity.
+    sk_sp<SkData> makeKey(const SkDescriptor& desc, const SkTypeface& typeface)
+            SK_EXCLUDES(fIdentitiesMutex);
+
+    // Check that bytes more fit in the budget, counting what every process has written, and
+    // count them as used if they do.
+    bool reserve(size_t bytes) SK_EXCLUDES(fUsageMutex);
+    // Stop counting bytes that were reserved but not written, or that were deleted.
+    void release(size_t bytes) SK_EXCLUDES(fUsageMutex);
+
+    const SkString fDirectory;
+    const size_t fByteBudget;
+    // The size of the files at the last time the directory was listed, plus what this process
+    // wrote since then.
+    SkMutex fUsageMutex;
+    size_t fBytesUsed SK_GUARDED_BY(fUsageMutex);
+    size_t fRoomAtLastScan SK_GUARDED_BY(fUsageMutex);
+    size_t fWrittenSinceScan SK_GUARDED_BY(fUsageMutex) = 0;
+    double fNextFullScanMs SK_GUARDED_BY(fUsageMutex) = 0;
+    // Hashes of the font data of the typefaces seen so far, or nullptr if they have none.
+    SkMutex fIdentitiesMutex;
+    SkTHashMap<SkTypefaceID, sk_sp<SkData>> fIdentities SK_GUARDED_BY(fIdentitiesMutex);
+};
+
+#endif  // SkPersistentGlyphCache_DEFINED
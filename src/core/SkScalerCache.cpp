@@ -11,10 +11,13 @@
 #include "include/core/SkGraphics.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkTypeface.h"
+#include "include/core/SkExecutor.h"
+#include "include/private/base/SkTArray.h"
 #include "src/core/SkDistanceFieldGen.h"
 #include "src/core/SkEnumerate.h"
 #include "src/core/SkGlyphBuffer.h"
 #include "src/core/SkScalerContext.h"
+#include "src/core/SkTHash.h"
 #include "src/text/StrikeForGPU.h"
 
 static SkFontMetrics use_or_generate_metrics(
@@ -30,11 +33,13 @@ static SkFontMetrics use_or_generate_metrics(
 
 SkScalerCache::SkScalerCache(
     std::unique_ptr<SkScalerContext> scaler,
-    const SkFontMetrics* fontMetrics)
+    const SkFontMetrics* fontMetrics,
+    sk_sp<SkPersistentGlyphCache::Strike> persistentStrike)
         : fScalerContext{std::move(scaler)}
         , fFontMetrics{use_or_generate_metrics(fontMetrics, fScalerContext.get())}
         , fRoundingSpec{fScalerContext->isSubpixel(),
-                        fScalerContext->computeAxisAlignmentForHText()} {
+                        fScalerContext->computeAxisAlignmentForHText()}
+        , fPersistentStrike{std::move(persistentStrike)} {
     SkASSERT(fScalerContext != nullptr);
 }
 
@@ -136,6 +141,80 @@ std::tuple<const void*, size_t> SkScalerCache::prepareImage(SkGlyph* glyph) {
     return {glyph->image(), delta};
 }
 
+size_t SkScalerCache::generateImages(SkSpan<SkGlyph* const> glyphs) {
+    size_t delta = 0;
+    SkSTArray<64, const SkGlyph*, true> fromPath;
+    SkTHashSet<const SkGlyph*> seen;
+    for (SkGlyph* glyph : glyphs) {
+        if (glyph->setImageHasBeenCalled()) {
+            continue;
+        }
+        if (!fScalerContext->imageIsFromPath(*glyph)) {
+            auto [_, imageSize] = this->prepareImage(glyph);
+            delta += imageSize;
+        } else if (!seen.contains(glyph)) {
+            seen.add(glyph);
+            fromPath.push_back(glyph);
+        }
+    }
+    if (fromPath.empty()) {
+        return delta;
+    }
+
+    // Rasterize into scratch memory so no other thread sees a glyph with a partial image.
+    SkArenaAlloc scratch{4096};
+    SkSTArray<64, SkMask, true> masks;
+    for (const SkGlyph* glyph : fromPath) {
+        SkMask& mask = masks.push_back(glyph->mask());
+        mask.fImage = static_cast<uint8_t*>(
+                scratch.makeBytesAlignedTo(glyph->imageSize(), glyph->formatAlignment()));
+    }
+
+    // Drawing the paths only reads the glyphs and the scaler context, so other threads can use
+    // this strike in the meantime.
+    fMu.release();
+    fScalerContext->getImagesFromPaths(fromPath, masks, SkExecutor::GetDefault());
+    fMu.acquire();
+
+    for (int i = 0; i < fromPath.size(); ++i) {
+        // Another thread may have set the image while fMu was released.
+        SkGlyph* glyph = const_cast<SkGlyph*>(fromPath[i]);
+        if (glyph->setImage(&fAlloc, masks[i].fImage)) {
+            delta += glyph->imageSize();
+        }
+    }
+    return delta;
+}
+
+void SkScalerCache::flushPersistentImages() {
+    if (fPersistentStrike != nullptr) {
+        fPersistentStrike->flush();
+    }
+}
+
+size_t SkScalerCache::prepareImageBatch(SkSpan<SkGlyph* const> glyphs) {
+    if (fPersistentStrike == nullptr) {
+        return this->generateImages(glyphs);
+    }
+
+    size_t delta = 0;
+    SkSTArray<64, SkGlyph*, true> missing;
+    for (SkGlyph* glyph : glyphs) {
+        if (glyph->setImageHasBeenCalled()) {
+            continue;
+        }
+        if (const void* image = fPersistentStrike->findImage(*glyph)) {
+            glyph->setImage(&fAlloc, image);
+            delta += glyph->imageSize();
+        } else {
+            missing.push_back(glyph);
+        }
+    }
+    delta += this->generateImages(missing);
+    fPersistentStrike->addImages(missing);
+    return delta;
+}
+
 std::tuple<SkGlyph*, size_t> SkScalerCache::mergeGlyphAndImage(
         SkPackedGlyphID toID, const SkGlyph& from) {
     SkAutoMutexExclusive lock{fMu};
@@ -190,14 +269,19 @@ size_t SkScalerCache::glyphIDsToPaths(SkSpan<sktext::IDOrPath> idsOrPaths) {
 std::tuple<SkSpan<const SkGlyph*>, size_t> SkScalerCache::prepareImages(
         SkSpan<const SkPackedGlyphID> glyphIDs, const SkGlyph* results[]) {
     const SkGlyph** cursor = results;
-    SkAutoMutexExclusive lock{fMu};
     size_t delta = 0;
-    for (auto glyphID : glyphIDs) {
-        auto[glyph, glyphSize] = this->glyph(glyphID);
-        auto[_, imageSize] = this->prepareImage(glyph);
-        delta += glyphSize + imageSize;
-        *cursor++ = glyph;
+    {
+        SkAutoMutexExclusive lock{fMu};
+        SkSTArray<64, SkGlyph*, true> glyphs;
+        for (auto glyphID : glyphIDs) {
+            auto[glyph, glyphSize] = this->glyph(glyphID);
+            delta += glyphSize;
+            glyphs.push_back(glyph);
+            *cursor++ = glyph;
+        }
+        delta += this->prepareImageBatch(glyphs);
     }
+    this->flushPersistentImages();
 
     return {{results, glyphIDs.size()}, delta};
 }
@@ -259,20 +343,30 @@ size_t SkScalerCache::commonFilterLoop(SkDrawableGlyphBuffer* accepted, Fn&& fn)
 }
 
 size_t SkScalerCache::prepareForDrawingMasksCPU(SkDrawableGlyphBuffer* accepted) {
-    SkAutoMutexExclusive lock{fMu};
-    size_t imageDelta = 0;
-    size_t delta = this->commonFilterLoop(accepted,
-        [&](size_t i, SkGlyphDigest digest, SkPoint pos) SK_REQUIRES(fMu) {
+    size_t delta;
+    {
+        SkAutoMutexExclusive lock{fMu};
+        SkSTArray<64, SkGlyph*, true> glyphs;
+        SkSTArray<64, size_t, true> indices;
+        delta = this->commonFilterLoop(accepted,
+            [&](size_t i, SkGlyphDigest digest, SkPoint pos) SK_REQUIRES(fMu) {
+                glyphs.push_back(fGlyphForIndex[digest.index()]);
+                indices.push_back(i);
+            });
+
+        // Generate all the missing images at once, then accept the glyphs in their original
+        // order.
+        delta += this->prepareImageBatch(glyphs);
+        for (int j = 0; j < glyphs.size(); ++j) {
             // If the glyph is too large, then no image is created.
-            SkGlyph* glyph = fGlyphForIndex[digest.index()];
-            auto [image, imageSize] = this->prepareImage(glyph);
-            if (image != nullptr) {
-                accepted->accept(glyph, i);
-                imageDelta += imageSize;
+            if (glyphs[j]->image() != nullptr) {
+                accepted->accept(glyphs[j], indices[j]);
             }
-        });
+        }
+    }
+    this->flushPersistentImages();
 
-    return delta + imageDelta;
+    return delta;
 }
 
 // Note: this does not actually fill out the image. That happens at atlas building time.
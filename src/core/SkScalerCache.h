@@ -15,6 +15,7 @@
 #include "src/core/SkDescriptor.h"
 #include "src/core/SkGlyph.h"
 #include "src/core/SkGlyphRunPainter.h"
+#include "src/core/SkPersistentGlyphCache.h"
 #include "src/core/SkTHash.h"
 
 #include <memory>
@@ -29,8 +30,11 @@ union IDOrDrawable;
 // holds the glyphs for that strike.
 class SkScalerCache {
 public:
+    // If persistentStrike is not null, glyph images are looked up in it before being generated,
+    // and the generated ones are added to it.
     SkScalerCache(std::unique_ptr<SkScalerContext> scaler,
-                  const SkFontMetrics* metrics = nullptr);
+                  const SkFontMetrics* metrics = nullptr,
+                  sk_sp<SkPersistentGlyphCache::Strike> persistentStrike = nullptr);
 
     // Lookup (or create if needed) the toGlyph using toID. If that glyph is not initialized with
     // an image, then use the information in from to initialize the width, height top, left,
@@ -123,6 +127,17 @@ private:
 
     std::tuple<const void*, size_t> prepareImage(SkGlyph* glyph) SK_REQUIRES(fMu);
 
+    // Make sure all the glyphs have images, generating the missing ones as one batch. Return the
+    // number of bytes allocated.
+    size_t prepareImageBatch(SkSpan<SkGlyph* const> glyphs) SK_REQUIRES(fMu);
+
+    // Write the images added to the persistent strike to disk.
+    void flushPersistentImages() SK_EXCLUDES(fMu);
+
+    // Generate the missing images of the glyphs with the scaler context. Images drawn from paths
+    // are rasterized together with fMu released. Return the number of bytes allocated.
+    size_t generateImages(SkSpan<SkGlyph* const> glyphs) SK_REQUIRES(fMu);
+
     // If the path has never been set, then use the scaler context to add the glyph.
     size_t preparePath(SkGlyph*) SK_REQUIRES(fMu);
 
@@ -161,6 +176,10 @@ private:
     inline static constexpr size_t kMinAllocAmount = kMinGlyphImageSize * kMinGlyphCount;
 
     SkArenaAlloc            fAlloc SK_GUARDED_BY(fMu) {kMinAllocAmount};
+
+    // Glyph images shared with other processes through the disk, if enabled. It is searched and
+    // added to with fMu held, and flushed to disk after fMu is released.
+    const sk_sp<SkPersistentGlyphCache::Strike> fPersistentStrike;
 };
 
 #endif  // SkStrike_DEFINED
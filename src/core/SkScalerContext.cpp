@@ -30,9 +30,11 @@
 #include "src/core/SkRectPriv.h"
 #include "src/core/SkStroke.h"
 #include "src/core/SkSurfacePriv.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/core/SkTextFormatParams.h"
 #include "src/core/SkWriteBuffer.h"
 #include "src/utils/SkMatrix22.h"
+#include <algorithm>
 #include <new>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -556,6 +558,17 @@ void SkScalerContext::GenerateImageFromPath(
     }
 }
 
+void SkScalerContext::imageFromPath(const SkGlyph& glyph, const SkMask& mask) const {
+    SkASSERT(glyph.path() != nullptr);
+    SkASSERT(SkMask::kARGB32_Format != glyph.fMaskFormat);
+    SkASSERT(SkMask::kARGB32_Format != mask.fFormat);
+    const bool doBGR = SkToBool(fRec.fFlags & SkScalerContext::kLCD_BGROrder_Flag);
+    const bool doVert = SkToBool(fRec.fFlags & SkScalerContext::kLCD_Vertical_Flag);
+    const bool a8LCD = SkToBool(fRec.fFlags & SkScalerContext::kGenA8FromLCD_Flag);
+    const bool hairline = glyph.pathIsHairline();
+    GenerateImageFromPath(mask, *glyph.path(), fPreBlend, doBGR, doVert, a8LCD, hairline);
+}
+
 void SkScalerContext::getImage(const SkGlyph& origGlyph) {
     SkASSERT(origGlyph.fAdvancesBoundsFormatAndInitialPathDone);
 
@@ -592,14 +605,7 @@ void SkScalerContext::getImage(const SkGlyph& origGlyph) {
         if (!devPath) {
             generateImage(*unfilteredGlyph);
         } else {
-            SkMask mask = unfilteredGlyph->mask();
-            SkASSERT(SkMask::kARGB32_Format != origGlyph.fMaskFormat);
-            SkASSERT(SkMask::kARGB32_Format != mask.fFormat);
-            const bool doBGR = SkToBool(fRec.fFlags & SkScalerContext::kLCD_BGROrder_Flag);
-            const bool doVert = SkToBool(fRec.fFlags & SkScalerContext::kLCD_Vertical_Flag);
-            const bool a8LCD = SkToBool(fRec.fFlags & SkScalerContext::kGenA8FromLCD_Flag);
-            const bool hairline = origGlyph.pathIsHairline();
-            GenerateImageFromPath(mask, *devPath, fPreBlend, doBGR, doVert, a8LCD, hairline);
+            this->imageFromPath(origGlyph, unfilteredGlyph->mask());
         }
     }
 
@@ -699,6 +705,40 @@ void SkScalerContext::getImage(const SkGlyph& origGlyph) {
     }
 }
 
+bool SkScalerContext::imageIsFromPath(const SkGlyph& glyph) const {
+    SkASSERT(glyph.fAdvancesBoundsFormatAndInitialPathDone);
+    return fGenerateImageFromPath && !fMaskFilter && glyph.path() != nullptr;
+}
+
+void SkScalerContext::getImagesFromPaths(SkSpan<const SkGlyph* const> glyphs,
+                                         SkSpan<const SkMask> masks,
+                                         SkExecutor& executor) const {
+    SkASSERT(glyphs.size() == masks.size());
+    // Below this many glyphs, handing the work to other threads costs more than it saves.
+    static constexpr size_t kMinParallelCount = 32;
+    static constexpr size_t kGlyphsPerTask = 16;
+
+    if (glyphs.size() < kMinParallelCount) {
+        for (size_t i = 0; i < glyphs.size(); ++i) {
+            SkASSERT(this->imageIsFromPath(*glyphs[i]));
+            this->imageFromPath(*glyphs[i], masks[i]);
+        }
+        return;
+    }
+
+    // Each mask has its own memory, so the tasks write to disjoint memory.
+    const int taskCount = SkToInt((glyphs.size() + kGlyphsPerTask - 1) / kGlyphsPerTask);
+    SkTaskGroup tasks(executor);
+    tasks.batch(taskCount, [&](int task) {
+        const size_t end = std::min(glyphs.size(), (task + 1) * kGlyphsPerTask);
+        for (size_t i = task * kGlyphsPerTask; i < end; ++i) {
+            SkASSERT(this->imageIsFromPath(*glyphs[i]));
+            this->imageFromPath(*glyphs[i], masks[i]);
+        }
+    });
+    tasks.wait();
+}
+
 void SkScalerContext::getPath(SkGlyph& glyph, SkArenaAlloc* alloc) {
     this->internalGetPath(glyph, alloc);
 }
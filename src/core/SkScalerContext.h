@@ -10,11 +10,13 @@
 
 #include <memory>
 
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkFontTypes.h"
 #include "include/core/SkMaskFilter.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
+#include "include/core/SkSpan.h"
 #include "include/core/SkTypeface.h"
 #include "include/private/SkMacros.h"
 #include "src/core/SkGlyph.h"
@@ -288,6 +290,14 @@ public:
 
     SkGlyph     makeGlyph(SkPackedGlyphID, SkArenaAlloc*);
     void        getImage(const SkGlyph&);
+    // True if getImage would only rasterize the path of the glyph, which getImagesFromPaths can
+    // do without changing the state of this scaler context.
+    bool        imageIsFromPath(const SkGlyph&) const;
+    // Same as getImage for glyphs where imageIsFromPath, but drawing into the given masks. This
+    // only reads this scaler context, so it may run while another thread uses it. Large batches
+    // are rasterized in parallel on the executor.
+    void        getImagesFromPaths(SkSpan<const SkGlyph* const>, SkSpan<const SkMask>,
+                                   SkExecutor&) const;
     void        getPath(SkGlyph&, SkArenaAlloc*);
     sk_sp<SkDrawable> getDrawable(SkGlyph&);
     void        getFontMetrics(SkFontMetrics*);
@@ -434,6 +444,9 @@ private:
     bool fGenerateImageFromPath;
 
     void internalGetPath(SkGlyph&, SkArenaAlloc*);
+    // Rasterize the path of the glyph into mask. Only reads the state of this scaler context,
+    // so it can be called from several threads at once.
+    void imageFromPath(const SkGlyph&, const SkMask& mask) const;
     SkGlyph internalMakeGlyph(SkPackedGlyphID, SkMask::Format, SkArenaAlloc*);
 
 protected:
@@ -161,8 +161,15 @@ auto SkStrikeCache::internalCreateStrike(
         SkFontMetrics* maybeMetrics,
         std::unique_ptr<SkStrikePinner> pinner) -> sk_sp<SkStrike> {
     std::unique_ptr<SkScalerContext> scaler = strikeSpec.createScalerContext();
-    auto strike =
-        sk_make_sp<SkStrike>(this, strikeSpec, std::move(scaler), maybeMetrics, std::move(pinner));
+    sk_sp<SkPersistentGlyphCache::Strike> persistentStrike;
+    if (fPersistentGlyphCache != nullptr) {
+        // This only copies the descriptor. The file is found on the first glyph lookup, under
+        // the new strike's lock instead of fLock.
+        persistentStrike = fPersistentGlyphCache->openStrike(strikeSpec.descriptor(),
+                                                             strikeSpec.typeface());
+    }
+    auto strike = sk_make_sp<SkStrike>(this, strikeSpec, std::move(scaler), maybeMetrics,
+                                       std::move(pinner), std::move(persistentStrike));
     this->internalAttachToHead(strike);
     return strike;
 }
@@ -172,6 +179,11 @@ void SkStrikeCache::purgeAll() {
     this->internalPurge(fTotalMemoryUsed);
 }
 
+void SkStrikeCache::setPersistentGlyphCache(sk_sp<SkPersistentGlyphCache> cache) {
+    SkAutoMutexExclusive ac(fLock);
+    fPersistentGlyphCache = std::move(cache);
+}
+
 size_t SkStrikeCache::getTotalMemoryUsed() const {
     SkAutoMutexExclusive ac(fLock);
     return fTotalMemoryUsed;
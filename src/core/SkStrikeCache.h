@@ -45,10 +45,11 @@ public:
              const SkStrikeSpec& strikeSpec,
              std::unique_ptr<SkScalerContext> scaler,
              const SkFontMetrics* metrics,
-             std::unique_ptr<SkStrikePinner> pinner)
+             std::unique_ptr<SkStrikePinner> pinner,
+             sk_sp<SkPersistentGlyphCache::Strike> persistentStrike = nullptr)
         : fStrikeSpec(strikeSpec)
         , fStrikeCache{strikeCache}
-        , fScalerCache{std::move(scaler), metrics}
+        , fScalerCache{std::move(scaler), metrics, std::move(persistentStrike)}
         , fPinner{std::move(pinner)} {}
 
     SkGlyph* mergeGlyphAndImage(SkPackedGlyphID toID, const SkGlyph& from) {
@@ -242,6 +243,10 @@ public:
     size_t setCacheSizeLimit(size_t limit) SK_EXCLUDES(fLock);
     size_t getTotalMemoryUsed() const SK_EXCLUDES(fLock);
 
+    // New strikes read and add glyph images to cache; nullptr turns this off. Strikes that
+    // already exist are not affected.
+    void setPersistentGlyphCache(sk_sp<SkPersistentGlyphCache> cache) SK_EXCLUDES(fLock);
+
 private:
     friend class SkStrike;  // for SkStrike::updateDelta
     sk_sp<SkStrike> internalFindStrikeOrNull(const SkDescriptor& desc) SK_REQUIRES(fLock);
@@ -281,6 +286,7 @@ private:
     size_t  fTotalMemoryUsed SK_GUARDED_BY(fLock) {0};
     int32_t fCacheCountLimit{SK_DEFAULT_FONT_CACHE_COUNT_LIMIT};
     int32_t fCacheCount SK_GUARDED_BY(fLock) {0};
+    sk_sp<SkPersistentGlyphCache> fPersistentGlyphCache SK_GUARDED_BY(fLock);
 };
 
 #endif  // SkStrikeCache_DEFINED
@@ -5,12 +5,37 @@
  * found in the LICENSE file.
  */
 
+#include "include/private/SkChecksum.h"
 #include "include/private/base/SkMutex.h"
+#include "src/core/SkOpts.h"
 #include "src/core/SkTypefaceCache.h"
 #include <atomic>
 
 #define TYPEFACE_CACHE_LIMIT    1024
 
+bool SkTypefaceCache::Key::operator==(const Key& that) const {
+    if (fIndex != that.fIndex || fAxes.size() != that.fAxes.size() ||
+        fIdentity != that.fIdentity) {
+        return false;
+    }
+    for (int i = 0; i < fAxes.size(); ++i) {
+        if (fAxes[i].axis != that.fAxes[i].axis || fAxes[i].value != that.fAxes[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t SkTypefaceCache::Key::Hash::operator()(const Key& key) const {
+    uint32_t hash = SkGoodHash()(key.fIdentity);
+    hash = SkOpts::hash_fn(&key.fIndex, sizeof(key.fIndex), hash);
+    for (const auto& coordinate : key.fAxes) {
+        hash = SkOpts::hash_fn(&coordinate.axis, sizeof(coordinate.axis), hash);
+        hash = SkOpts::hash_fn(&coordinate.value, sizeof(coordinate.value), hash);
+    }
+    return hash;
+}
+
 SkTypefaceCache::SkTypefaceCache() {}
 
 void SkTypefaceCache::add(sk_sp<SkTypeface> face) {
@@ -21,6 +46,17 @@ void SkTypefaceCache::add(sk_sp<SkTypeface> face) {
     fTypefaces.emplace_back(std::move(face));
 }
 
+void SkTypefaceCache::add(sk_sp<SkTypeface> face, Key key) {
+    SkTypeface* typeface = face.get();
+    this->add(std::move(face));
+
+    if (auto* typefaces = fIndex.find(key)) {
+        typefaces->push_back(typeface);
+    } else {
+        fIndex.set(std::move(key), {typeface});
+    }
+}
+
 sk_sp<SkTypeface> SkTypefaceCache::findByProcAndRef(FindProc proc, void* ctx) const {
     for (const sk_sp<SkTypeface>& typeface : fTypefaces) {
         if (proc(typeface.get(), ctx)) {
@@ -30,20 +66,51 @@ sk_sp<SkTypeface> SkTypefaceCache::findByProcAndRef(FindProc proc, void* ctx) co
     return nullptr;
 }
 
+sk_sp<SkTypeface> SkTypefaceCache::findByKeyAndRef(const Key& key, FindProc proc,
+                                                   void* ctx) const {
+    if (const auto* typefaces = fIndex.find(key)) {
+        for (SkTypeface* typeface : *typefaces) {
+            if (!proc || proc(typeface, ctx)) {
+                return sk_ref_sp(typeface);
+            }
+        }
+    }
+    return nullptr;
+}
+
 void SkTypefaceCache::purge(int numToPurge) {
+    // Typefaces are only compared against the index, never used, after being freed.
+    SkTHashSet<SkTypeface*> purged;
     int count = fTypefaces.size();
     int i = 0;
-    while (i < count) {
+    while (i < count && numToPurge > 0) {
         if (fTypefaces[i]->unique()) {
+            purged.add(fTypefaces[i].get());
             fTypefaces.removeShuffle(i);
             --count;
-            if (--numToPurge == 0) {
-                return;
-            }
+            --numToPurge;
         } else {
             ++i;
         }
     }
+
+    if (purged.count() == 0 || fIndex.empty()) {
+        return;
+    }
+    SkTArray<Key> emptied;
+    fIndex.foreach([&](const Key& key, SkSTArray<1, SkTypeface*>* typefaces) {
+        for (int j = typefaces->size(); j-- > 0;) {
+            if (purged.contains((*typefaces)[j])) {
+                typefaces->removeShuffle(j);
+            }
+        }
+        if (typefaces->empty()) {
+            emptied.push_back(key);
+        }
+    });
+    for (const Key& key : emptied) {
+        fIndex.remove(key);
+    }
 }
 
 void SkTypefaceCache::purgeAll() {
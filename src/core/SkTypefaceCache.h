@@ -10,9 +10,12 @@
 #ifndef SkTypefaceCache_DEFINED
 #define SkTypefaceCache_DEFINED
 
+#include "include/core/SkFontArguments.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkString.h"
 #include "include/core/SkTypeface.h"
 #include "include/private/base/SkTArray.h"
+#include "src/core/SkTHash.h"
 
 class SkTypefaceCache {
 public:
@@ -25,12 +28,33 @@ public:
      */
     typedef bool(*FindProc)(SkTypeface*, void* context);
 
+    /**
+     *  Identifies a typeface by the font data it was made from, for findByKeyAndRef: where the
+     *  data lives (a file path, or the address of font data in memory which the cached typeface
+     *  keeps alive), the index of the font in a collection, and the variation position.
+     */
+    struct Key {
+        SkString fIdentity;
+        int fIndex = 0;
+        SkSTArray<4, SkFontArguments::VariationPosition::Coordinate, true> fAxes;
+
+        bool operator==(const Key&) const;
+        struct Hash {
+            uint32_t operator()(const Key&) const;
+        };
+    };
+
     /**
      *  Add a typeface to the cache. Later, if we need to purge the cache,
      *  typefaces uniquely owned by the cache will be unref()ed.
      */
     void add(sk_sp<SkTypeface>);
 
+    /**
+     *  Add a typeface which findByKeyAndRef will find under the given key.
+     */
+    void add(sk_sp<SkTypeface>, Key);
+
     /**
      *  Iterate through the cache, calling proc(typeface, ctx) for each typeface.
      *  If proc returns true, then return that typeface.
@@ -38,6 +62,15 @@ public:
      */
     sk_sp<SkTypeface> findByProcAndRef(FindProc proc, void* ctx) const;
 
+    /**
+     *  Return a typeface added with an equal key, without visiting the rest of the cache.
+     *  If several were added with the key, return the first one for which proc(typeface, ctx)
+     *  returns true, or the first one if proc is nullptr.
+     *  If there is none, return nullptr.
+     */
+    sk_sp<SkTypeface> findByKeyAndRef(const Key&, FindProc proc = nullptr,
+                                      void* ctx = nullptr) const;
+
     /**
      *  This will unref all of the typefaces in the cache for which the cache
      *  is the only owner. Normally this is handled automatically as needed.
@@ -69,6 +102,8 @@ private:
     void purge(int count);
 
     SkTArray<sk_sp<SkTypeface>> fTypefaces;
+    // The typefaces added with a key, by key. Owned by fTypefaces.
+    SkTHashMap<Key, SkSTArray<1, SkTypeface*>, Key::Hash> fIndex;
 };
 
 #endif
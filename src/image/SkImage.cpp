@@ -127,6 +127,10 @@ bool SkImage::scalePixels(const SkPixmap& dst, const SkSamplingOptions& sampling
     // Idea: If/when SkImageGenerator supports a native-scaling API (where the generator itself
     //       can scale more efficiently) we should take advantage of it here.
     //
+    if (as_IB(this)->onScalePixels(dst, sampling, chint)) {
+        return true;
+    }
+
     SkBitmap bm;
     if (as_IB(this)->getROPixels(dContext, &bm, chint)) {
         SkPixmap pmap;
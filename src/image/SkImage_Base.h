@@ -75,6 +75,13 @@ public:
                               int srcY,
                               CachingHint) const = 0;
 
+    // Called by SkImage::scalePixels() before falling back to scaling the result of
+    // getROPixels(). Images that can produce a downscaled result without first materializing
+    // full-size RGBA pixels override this; returning false selects the default path.
+    virtual bool onScalePixels(const SkPixmap&, const SkSamplingOptions&, CachingHint) const {
+        return false;
+    }
+
     virtual bool onHasMipmaps() const = 0;
 
     virtual SkMipmap* onPeekMips() const { return nullptr; }
@@ -11,16 +11,21 @@
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkData.h"
 #include "include/core/SkImageGenerator.h"
+#include "include/core/SkSamplingOptions.h"
+#include "src/core/SkAutoPixmapStorage.h"
 #include "src/core/SkBitmapCache.h"
 #include "src/core/SkCachedData.h"
+#include "src/core/SkColorSpaceXformSteps.h"
 #include "src/core/SkImagePriv.h"
 #include "src/core/SkNextID.h"
+#include "src/core/SkRasterPipeline.h"
+#include "src/core/SkResourceCache.h"
+#include "src/core/SkYUVMath.h"
+#include "src/core/SkYUVPlanesCache.h"
 
 #if SK_SUPPORT_GPU
 #include "include/gpu/GrDirectContext.h"
 #include "include/gpu/GrRecordingContext.h"
-#include "src/core/SkResourceCache.h"
-#include "src/core/SkYUVPlanesCache.h"
 #include "src/gpu/ResourceKey.h"
 #include "src/gpu/ganesh/GrCaps.h"
 #include "src/gpu/ganesh/GrColorSpaceXform.h"
@@ -205,6 +210,122 @@ bool SkImage_Lazy::readPixelsProxy(GrDirectContext* ctx, const SkPixmap& pixmap)
 #endif // SK_SUPPORT_GPU
 }
 
+bool SkImage_Lazy::onScalePixels(const SkPixmap& dst, const SkSamplingOptions& sampling,
+                                 CachingHint chint) const {
+    if (dst.width() >= this->width() || dst.height() >= this->height()) {
+        return false;
+    }
+    // The planes are in the generator's color space; images made by
+    // onMakeColorTypeAndColorSpace/onReinterpretColorSpace take the usual path.
+    if (!SkColorSpace::Equals(this->colorSpace(), fSharedGenerator->getInfo().colorSpace())) {
+        return false;
+    }
+    // If full-size pixels are already cached, scaling those is cheaper than decoding again.
+    if (SkBitmap cached; SkBitmapCache::Find(SkBitmapCacheDesc::Make(this), &cached)) {
+        return false;
+    }
+
+    // Only three-plane, 8-bit, unrotated YUV (what SkJpegCodec produces) is handled here.
+    SkYUVAPixmapInfo::SupportedDataTypes supportedDataTypes;
+    supportedDataTypes.enableDataType(SkYUVAPixmapInfo::DataType::kUnorm8, 1);
+    SkYUVAPixmaps planes;
+    sk_sp<SkCachedData> planeData = this->getPlanes(supportedDataTypes, &planes, chint);
+    if (!planeData) {
+        return false;
+    }
+    const SkYUVAInfo& yuvaInfo = planes.yuvaInfo();
+    if (yuvaInfo.planeConfig() != SkYUVAInfo::PlaneConfig::kY_U_V ||
+        yuvaInfo.origin() != kTopLeft_SkEncodedOrigin) {
+        return false;
+    }
+
+    // Scale each plane straight to the destination size, so that neither full-size RGBA nor
+    // full-size chroma is ever produced. The planes are treated as A8 so that the existing
+    // raster scaler can filter them.
+    SkAutoPixmapStorage scaled[3];
+    for (int i = 0; i < 3; ++i) {
+        const SkPixmap& plane = planes.plane(i);
+        SkPixmap planeA8(plane.info().makeColorType(kAlpha_8_SkColorType), plane.addr(),
+                         plane.rowBytes());
+        if (!scaled[i].tryAlloc(SkImageInfo::MakeA8(dst.dimensions())) ||
+            !planeA8.scalePixels(scaled[i], sampling)) {
+            return false;
+        }
+    }
+
+    // Interleave the scaled planes as Y,U,V,1 so one raster pipeline can convert them.
+    SkAutoPixmapStorage yuvx;
+    if (!yuvx.tryAlloc(SkImageInfo::Make(dst.dimensions(), kRGBA_8888_SkColorType,
+                                         kOpaque_SkAlphaType))) {
+        return false;
+    }
+    for (int y = 0; y < dst.height(); ++y) {
+        const uint8_t* Y = scaled[0].addr8(0, y);
+        const uint8_t* U = scaled[1].addr8(0, y);
+        const uint8_t* V = scaled[2].addr8(0, y);
+        uint8_t* px = static_cast<uint8_t*>(yuvx.writable_addr(0, y));
+        for (int x = 0; x < dst.width(); ++x) {
+            px[4*x + 0] = Y[x];
+            px[4*x + 1] = U[x];
+            px[4*x + 2] = V[x];
+            px[4*x + 3] = 0xFF;
+        }
+    }
+
+    // YUV->RGB, the color space transform and the store to dst's color type all happen in one
+    // pass over the destination-sized buffer.
+    float yuvToRGB[20];
+    SkColorMatrix_YUV2RGB(yuvaInfo.yuvColorSpace(), yuvToRGB);
+    SkColorSpaceXformSteps steps(this->colorSpace(), kOpaque_SkAlphaType,
+                                 dst.colorSpace(),   dst.alphaType());
+
+    SkRasterPipeline_MemoryCtx srcCtx = { yuvx.writable_addr(), yuvx.rowBytesAsPixels() },
+                               dstCtx = { dst.writable_addr(), dst.rowBytesAsPixels() };
+    SkRasterPipeline_<256> pipeline;
+    pipeline.append_load(kRGBA_8888_SkColorType, &srcCtx);
+    pipeline.append(SkRasterPipelineOp::matrix_4x5, yuvToRGB);
+    pipeline.append(SkRasterPipelineOp::clamp_01);
+    steps.apply(&pipeline);
+    pipeline.append_store(dst.colorType(), &dstCtx);
+    pipeline.run(0, 0, dst.width(), dst.height());
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+sk_sp<SkCachedData> SkImage_Lazy::getPlanes(
+        const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
+        SkYUVAPixmaps* yuvaPixmaps,
+        CachingHint chint) const {
+    ScopedGenerator generator(fSharedGenerator);
+
+    sk_sp<SkCachedData> data(SkYUVPlanesCache::FindAndRef(generator->uniqueID(), yuvaPixmaps));
+
+    if (data) {
+        SkASSERT(yuvaPixmaps->isValid());
+        SkASSERT(yuvaPixmaps->yuvaInfo().dimensions() == this->dimensions());
+        return data;
+    }
+    SkYUVAPixmapInfo yuvaPixmapInfo;
+    if (!generator->queryYUVAInfo(supportedDataTypes, &yuvaPixmapInfo) ||
+        yuvaPixmapInfo.yuvaInfo().dimensions() != this->dimensions()) {
+        return nullptr;
+    }
+    data.reset(SkResourceCache::NewCachedData(yuvaPixmapInfo.computeTotalBytes()));
+    SkYUVAPixmaps tempPixmaps = SkYUVAPixmaps::FromExternalMemory(yuvaPixmapInfo,
+                                                                  data->writable_data());
+    SkASSERT(tempPixmaps.isValid());
+    if (!generator->getYUVAPlanes(tempPixmaps)) {
+        return nullptr;
+    }
+    // Decoding is done, cache the resulting YUV planes
+    *yuvaPixmaps = tempPixmaps;
+    if (chint == kAllow_CachingHint) {
+        SkYUVPlanesCache::Add(this->uniqueID(), data.get(), *yuvaPixmaps);
+    }
+    return data;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool SkImage_Lazy::onReadPixels(GrDirectContext* dContext,
@@ -433,36 +554,6 @@ GrSurfaceProxyView SkImage_Lazy::textureProxyViewFromPlanes(GrRecordingContext*
     return sfc->readSurfaceView();
 }
 
-sk_sp<SkCachedData> SkImage_Lazy::getPlanes(
-        const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
-        SkYUVAPixmaps* yuvaPixmaps) const {
-    ScopedGenerator generator(fSharedGenerator);
-
-    sk_sp<SkCachedData> data(SkYUVPlanesCache::FindAndRef(generator->uniqueID(), yuvaPixmaps));
-
-    if (data) {
-        SkASSERT(yuvaPixmaps->isValid());
-        SkASSERT(yuvaPixmaps->yuvaInfo().dimensions() == this->dimensions());
-        return data;
-    }
-    SkYUVAPixmapInfo yuvaPixmapInfo;
-    if (!generator->queryYUVAInfo(supportedDataTypes, &yuvaPixmapInfo) ||
-        yuvaPixmapInfo.yuvaInfo().dimensions() != this->dimensions()) {
-        return nullptr;
-    }
-    data.reset(SkResourceCache::NewCachedData(yuvaPixmapInfo.computeTotalBytes()));
-    SkYUVAPixmaps tempPixmaps = SkYUVAPixmaps::FromExternalMemory(yuvaPixmapInfo,
-                                                                  data->writable_data());
-    SkASSERT(tempPixmaps.isValid());
-    if (!generator->getYUVAPlanes(tempPixmaps)) {
-        return nullptr;
-    }
-    // Decoding is done, cache the resulting YUV planes
-    *yuvaPixmaps = tempPixmaps;
-    SkYUVPlanesCache::Add(this->uniqueID(), data.get(), *yuvaPixmaps);
-    return data;
-}
-
 /*
  *  We have 4 ways to try to return a texture (in sorted order)
  *
@@ -12,8 +12,9 @@
 #include "include/private/base/SkMutex.h"
 #include "src/image/SkImage_Base.h"
 
-#if SK_SUPPORT_GPU
 #include "include/core/SkYUVAPixmaps.h"
+
+#if SK_SUPPORT_GPU
 class GrCaps;
 #endif
 
@@ -49,6 +50,7 @@ public:
                                 RequiredImageProperties) const override;
 #endif
     bool getROPixels(GrDirectContext*, SkBitmap*, CachingHint) const override;
+    bool onScalePixels(const SkPixmap&, const SkSamplingOptions&, CachingHint) const override;
     bool onIsLazyGenerated() const override { return true; }
     sk_sp<SkImage> onMakeColorTypeAndColorSpace(SkColorType, sk_sp<SkColorSpace>,
                                                 GrDirectContext*) const override;
@@ -85,9 +87,11 @@ private:
                                                                const SkRect*) const override;
 
     GrSurfaceProxyView textureProxyViewFromPlanes(GrRecordingContext*, skgpu::Budgeted) const;
-    sk_sp<SkCachedData> getPlanes(const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
-                                  SkYUVAPixmaps* pixmaps) const;
 #endif
+    // The decoded planes are added to SkYUVPlanesCache unless chint is kDisallow_CachingHint.
+    sk_sp<SkCachedData> getPlanes(const SkYUVAPixmapInfo::SupportedDataTypes& supportedDataTypes,
+                                  SkYUVAPixmaps* pixmaps,
+                                  CachingHint chint = kAllow_CachingHint) const;
 
 #ifdef SK_GRAPHITE_ENABLED
     sk_sp<SkImage> onMakeTextureImage(skgpu::graphite::Recorder*,
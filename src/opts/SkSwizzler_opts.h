@@ -1384,6 +1384,45 @@ static void RGB_to_BGR1_portable(uint32_t dst[], const uint8_t* src, int count)
     }
 #endif
 
+static void index_to_8888_portable(uint32_t dst[], const uint8_t* src, int count,
+                                   const uint32_t ctable[]) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = ctable[src[i]];
+    }
+}
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    /*not static*/ inline void index_to_8888(uint32_t dst[], const uint8_t* src, int count,
+                                             const uint32_t ctable[]) {
+        while (count >= 16) {
+            // Load 16 indices and widen each group of 8 to 32-bit lanes.
+            __m128i idx = _mm_loadu_si128((const __m128i*) src);
+            __m256i lo = _mm256_cvtepu8_epi32(idx),
+                    hi = _mm256_cvtepu8_epi32(_mm_srli_si128(idx, 8));
+
+            // Look up 16 colors.
+            lo = _mm256_i32gather_epi32((const int*) ctable, lo, 4);
+            hi = _mm256_i32gather_epi32((const int*) ctable, hi, 4);
+
+            // Store 16 pixels.
+            _mm256_storeu_si256((__m256i*) (dst + 0), lo);
+            _mm256_storeu_si256((__m256i*) (dst + 8), hi);
+            src += 16;
+            dst += 16;
+            count -= 16;
+        }
+
+        // Call portable code to finish up the tail of [0,16) pixels.
+        index_to_8888_portable(dst, src, count, ctable);
+    }
+#else
+    // SSSE3 and NEON have no gather, and a table this size doesn't fit in byte shuffles.
+    /*not static*/ inline void index_to_8888(uint32_t dst[], const uint8_t* src, int count,
+                                             const uint32_t ctable[]) {
+        index_to_8888_portable(dst, src, count, ctable);
+    }
+#endif
+
 }  // namespace SK_OPTS_NS
 
 #endif // SkSwizzler_opts_DEFINED
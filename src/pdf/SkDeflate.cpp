@@ -28,39 +28,48 @@ void skia_free_func(void*, void* address) { sk_free(address); }
 
 }  // namespace
 
-#define SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE 4096
-#define SKDEFLATEWSTREAM_OUTPUT_BUFFER_SIZE 4224  // 4096 + 128, usually big
-                                                  // enough to always do a
-                                                  // single loop.
+// Each call into zlib has a fixed overhead, and the PDF backend writes content streams and
+// image rows in small pieces, so gather at least this much input before deflating.
+#define SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE 65536
+#define SKDEFLATEWSTREAM_OUTPUT_BUFFER_SIZE 65664  // 65536 + 128, usually big
+                                                   // enough to always do a
+                                                   // single loop.
+// Writes at least this large skip fInBuffer and are deflated straight from the caller's
+// memory, in pieces no larger than zlib's 32-bit avail_in can describe.
+#define SKDEFLATEWSTREAM_MAX_DIRECT_INPUT_SIZE (1u << 30)
 
 // called by both write() and finalize()
 static void do_deflate(int flush,
                        z_stream* zStream,
                        SkWStream* out,
-                       unsigned char* inBuffer,
-                       size_t inBufferSize) {
-    zStream->next_in = inBuffer;
-    zStream->avail_in = SkToInt(inBufferSize);
-    unsigned char outBuffer[SKDEFLATEWSTREAM_OUTPUT_BUFFER_SIZE];
+                       const unsigned char* inBuffer,
+                       size_t inBufferSize,
+                       unsigned char* outBuffer,
+                       size_t outBufferSize) {
+    // zlib never writes through next_in, but some versions declare it non-const.
+    zStream->next_in = const_cast<unsigned char*>(inBuffer);
+    zStream->avail_in = SkToUInt(inBufferSize);
     SkDEBUGCODE(int returnValue;)
     do {
         zStream->next_out = outBuffer;
-        zStream->avail_out = sizeof(outBuffer);
+        zStream->avail_out = SkToUInt(outBufferSize);
         SkDEBUGCODE(returnValue =) deflate(zStream, flush);
         SkASSERT(!zStream->msg);
 
-        out->write(outBuffer, sizeof(outBuffer) - zStream->avail_out);
+        out->write(outBuffer, outBufferSize - zStream->avail_out);
     } while (zStream->avail_in || !zStream->avail_out);
     SkASSERT(flush == Z_FINISH
                  ? returnValue == Z_STREAM_END
                  : returnValue == Z_OK);
 }
 
-// Hide all zlib impl details.
+// Hide all zlib impl details.  The buffers are too large for the stacks of executor threads,
+// so they live here, on the heap.
 struct SkDeflateWStream::Impl {
     SkWStream* fOut;
     unsigned char fInBuffer[SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE];
     size_t fInBufferIndex;
+    unsigned char fOutBuffer[SKDEFLATEWSTREAM_OUTPUT_BUFFER_SIZE];
     z_stream fZStream;
 };
 
@@ -99,7 +108,7 @@ void SkDeflateWStream::finalize() {
         return;
     }
     do_deflate(Z_FINISH, &fImpl->fZStream, fImpl->fOut, fImpl->fInBuffer,
-               fImpl->fInBufferIndex);
+               fImpl->fInBufferIndex, fImpl->fOutBuffer, sizeof(fImpl->fOutBuffer));
     (void)deflateEnd(&fImpl->fZStream);
     fImpl->fOut = nullptr;
 }
@@ -109,8 +118,16 @@ bool SkDeflateWStream::write(const void* void_buffer, size_t len) {
     if (!fImpl->fOut) {
         return false;
     }
-    const char* buffer = (const char*)void_buffer;
+    const unsigned char* buffer = (const unsigned char*)void_buffer;
     while (len > 0) {
+        if (0 == fImpl->fInBufferIndex && len >= sizeof(fImpl->fInBuffer)) {
+            size_t direct = std::min<size_t>(len, SKDEFLATEWSTREAM_MAX_DIRECT_INPUT_SIZE);
+            do_deflate(Z_NO_FLUSH, &fImpl->fZStream, fImpl->fOut, buffer, direct,
+                       fImpl->fOutBuffer, sizeof(fImpl->fOutBuffer));
+            len -= direct;
+            buffer += direct;
+            continue;
+        }
         size_t tocopy =
                 std::min(len, sizeof(fImpl->fInBuffer) - fImpl->fInBufferIndex);
         memcpy(fImpl->fInBuffer + fImpl->fInBufferIndex, buffer, tocopy);
@@ -122,7 +139,8 @@ bool SkDeflateWStream::write(const void* void_buffer, size_t len) {
         // if the buffer isn't filled, don't call into zlib yet.
         if (sizeof(fImpl->fInBuffer) == fImpl->fInBufferIndex) {
             do_deflate(Z_NO_FLUSH, &fImpl->fZStream, fImpl->fOut,
-                       fImpl->fInBuffer, fImpl->fInBufferIndex);
+                       fImpl->fInBuffer, fImpl->fInBufferIndex,
+                       fImpl->fOutBuffer, sizeof(fImpl->fOutBuffer));
             fImpl->fInBufferIndex = 0;
         }
     }
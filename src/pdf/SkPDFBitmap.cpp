@@ -11,6 +11,7 @@
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
 #include "include/core/SkExecutor.h"
+#include "include/core/SkColorSpace.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkStream.h"
 #include "include/private/SkColorData.h"
@@ -327,3 +328,28 @@ SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
     serialize_image(img, encodingQuality, doc, ref);
     return ref;
 }
+
+bool SkPDFImageDigest(const SkImage* img, const SkIRect& subset, SkMD5::Digest* digest) {
+    SkASSERT(img);
+    SkMD5 md5;
+    const SkImageInfo& info = img->imageInfo();
+    const int32_t header[] = {info.width(), info.height(), info.colorType(), info.alphaType()};
+    md5.write(header, sizeof(header));
+    uint64_t colorSpaceHash = info.colorSpace() ? info.colorSpace()->hash() : 0;
+    md5.write(&colorSpaceHash, sizeof(colorSpaceHash));
+    if (sk_sp<SkData> data = img->refEncodedData()) {
+        // Subsets of a lazy image share its encoded data.
+        md5.write(&subset, sizeof(subset));
+        md5.write(data->data(), data->size());
+    } else {
+        SkPixmap pm;
+        if (!img->peekPixels(&pm)) {
+            return false;
+        }
+        for (int y = 0; y < pm.height(); ++y) {
+            md5.write(pm.addr(0, y), pm.info().minRowBytes());
+        }
+    }
+    *digest = md5.finish();
+    return true;
+}
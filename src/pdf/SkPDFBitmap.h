@@ -7,8 +7,11 @@
 #ifndef SkPDFBitmap_DEFINED
 #define SkPDFBitmap_DEFINED
 
+#include "src/core/SkMD5.h"
+
 class SkImage;
 class SkPDFDocument;
+struct SkIRect;
 struct SkPDFIndirectReference;
 
 /**
@@ -19,4 +22,10 @@ SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
                                            SkPDFDocument* doc,
                                            int encodingQuality = 101);
 
+/**
+ * Digest of the content of img, which is the given subset of its original image, taken from
+ * its encoded data or raster pixels.  Returns false if neither is available without decoding.
+ */
+bool SkPDFImageDigest(const SkImage* img, const SkIRect& subset, SkMD5::Digest* digest);
+
 #endif  // SkPDFBitmap_DEFINED
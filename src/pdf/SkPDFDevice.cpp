@@ -17,6 +17,7 @@
 #include "include/core/SkString.h"
 #include "include/core/SkSurface.h"
 #include "include/core/SkTextBlob.h"
+#include "include/core/SkTime.h"
 #include "include/docs/SkPDFDocument.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/pathops/SkPathOps.h"
@@ -237,7 +238,8 @@ public:
                        const SkClipStack* clipStack,
                        const SkMatrix& matrix,
                        const SkPaint& paint,
-                       SkScalar textScale = 0)
+                       SkScalar textScale = 0,
+                       SkPDFDevice::PendingOp continuable = SkPDFDevice::PendingOp::kNone)
         : fDevice(device)
         , fBlendMode(SkBlendMode::kSrcOver)
         , fClipStack(clipStack)
@@ -247,11 +249,19 @@ public:
             return;
         }
         fBlendMode = paint.getBlendMode_or(SkBlendMode::kSrcOver);
-        fContentStream =
-            fDevice->setUpContentEntry(clipStack, matrix, paint, textScale, &fDstFormXObject);
+        fContentStream = fDevice->setUpContentEntry(clipStack, matrix, paint, textScale,
+                                                    &fDstFormXObject, continuable);
+        // setUpContentEntry() only leaves the previous drawing open if this one may extend it.
+        if (fContentStream && fDevice->fPendingOp != SkPDFDevice::PendingOp::kNone) {
+            SkASSERT(fDevice->fPendingOp == continuable);
+            fDevice->fPendingOp = SkPDFDevice::PendingOp::kNone;
+            fContinuesPrevious = true;
+        }
     }
-    ScopedContentEntry(SkPDFDevice* dev, const SkPaint& paint, SkScalar textScale = 0)
-        : ScopedContentEntry(dev, &dev->cs(), dev->localToDevice(), paint, textScale) {}
+    ScopedContentEntry(SkPDFDevice* dev, const SkPaint& paint, SkScalar textScale = 0,
+                       SkPDFDevice::PendingOp continuable = SkPDFDevice::PendingOp::kNone)
+        : ScopedContentEntry(dev, &dev->cs(), dev->localToDevice(), paint, textScale,
+                             continuable) {}
 
     ~ScopedContentEntry() {
         if (fContentStream) {
@@ -266,6 +276,22 @@ public:
     explicit operator bool() const { return fContentStream != nullptr; }
     SkDynamicMemoryWStream* stream() { return fContentStream; }
 
+    /* True if the previous drawing was left open and this one should add to it
+     * rather than begin its own path or text object.
+     */
+    bool continuesPrevious() const { return fContinuesPrevious; }
+
+    /* Ends this drawing with the closing operator for op.  The operator is
+     * held back when the next drawing could extend this one.
+     */
+    void closeWith(SkPDFDevice::PendingOp op) {
+        fDevice->fPendingOp = op;
+        if (fContentStream != &fDevice->fContent) {
+            // Blend modes drawn through fContentBuffer are finished right away.
+            fDevice->flushPendingOp();
+        }
+    }
+
     /* Returns true when we explicitly need the shape of the drawing. */
     bool needShape() {
         switch (fBlendMode) {
@@ -307,6 +333,7 @@ private:
     SkPDFIndirectReference fDstFormXObject;
     SkPath fShape;
     const SkClipStack* fClipStack;
+    bool fContinuesPrevious = false;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -330,6 +357,7 @@ void SkPDFDevice::reset() {
     fFontResources.reset();
     fContent.reset();
     fActiveStackState = SkPDFGraphicStackState();
+    fPendingOp = PendingOp::kNone;
 }
 
 void SkPDFDevice::drawAnnotation(const SkRect& rect, const char key[], SkData* value) {
@@ -560,6 +588,21 @@ void SkPDFDevice::clearMaskOnGraphicState(SkDynamicMemoryWStream* contentStream)
     this->setGraphicState(noSMaskGS, contentStream);
 }
 
+// True if the path is emitted as a single 're' and painting it twice is the same
+// as painting it once.
+static bool is_opaque_rect_fill(const SkPath& path, const SkPaint& paint) {
+    bool isClosed;
+    SkPathDirection direction;
+    return paint.getStyle() == SkPaint::kFill_Style &&
+           paint.isSrcOver() &&
+           paint.getAlpha() == 0xFF &&
+           !paint.getShader() &&
+           path.getFillType() == SkPathFillType::kWinding &&
+           path.isRect(nullptr, &isClosed, &direction) &&
+           isClosed &&
+           direction == SkPathDirection::kCW;
+}
+
 void SkPDFDevice::internalDrawPath(const SkClipStack& clipStack,
                                    const SkMatrix& ctm,
                                    const SkPath& origPath,
@@ -615,7 +658,11 @@ void SkPDFDevice::internalDrawPath(const SkClipStack& clipStack,
         matrix = SkMatrix::I();
     }
 
-    ScopedContentEntry content(this, &clipStack, matrix, *paint);
+    // Opaque rects filled in the same graphic state can be painted together:
+    // 're' always winds the same way, so the union is what each fill paints.
+    bool coalescable = is_opaque_rect_fill(*pathPtr, *paint);
+    ScopedContentEntry content(this, &clipStack, matrix, *paint, 0,
+                               coalescable ? PendingOp::kFill : PendingOp::kNone);
     if (!content) {
         return;
     }
@@ -628,6 +675,10 @@ void SkPDFDevice::internalDrawPath(const SkClipStack& clipStack,
             paint->getStrokeCap() != SkPaint::kSquare_Cap);
     SkPDFUtils::EmitPath(*pathPtr, paint->getStyle(), consumeDegeratePathSegments, content.stream(),
                          tolerance);
+    if (coalescable) {
+        content.closeWith(PendingOp::kFill);
+        return;
+    }
     SkPDFUtils::PaintPath(paint->getStyle(), pathPtr->getFillType(), content.stream());
 }
 
@@ -862,14 +913,18 @@ void SkPDFDevice::internalDrawGlyphRun(
     SkRect clipStackBounds = this->cs().bounds(this->bounds());
 
     SkTCopyOnFirstWrite<SkPaint> paint(clean_paint(runPaint));
-    ScopedContentEntry content(this, *paint, glyphRunFont.getScaleX());
+    ScopedContentEntry content(this, *paint, glyphRunFont.getScaleX(), PendingOp::kText);
     if (!content) {
         return;
     }
     SkDynamicMemoryWStream* out = content.stream();
 
-    out->writeText("BT\n");
-    SK_AT_SCOPE_EXIT(out->writeText("ET\n"));
+    // Each run sets its own font and an absolute text matrix, so a run in the
+    // same graphic state as the previous one can share its text object.
+    if (!content.continuesPrevious()) {
+        out->writeText("BT\n");
+    }
+    SK_AT_SCOPE_EXIT(content.closeWith(PendingOp::kText));
 
     ScopedOutputMarkedContentTags mark(fNodeId, fDocument, out);
 
@@ -1011,6 +1066,7 @@ std::unique_ptr<SkPDFDict> SkPDFDevice::makeResourceDict() {
 }
 
 std::unique_ptr<SkStreamAsset> SkPDFDevice::content() {
+    this->flushPendingOp();
     if (fActiveStackState.fContentStream) {
         fActiveStackState.drainStack();
         fActiveStackState = SkPDFGraphicStackState();
@@ -1228,7 +1284,8 @@ SkDynamicMemoryWStream* SkPDFDevice::setUpContentEntry(const SkClipStack* clipSt
                                                        const SkMatrix& matrix,
                                                        const SkPaint& paint,
                                                        SkScalar textScale,
-                                                       SkPDFIndirectReference* dst) {
+                                                       SkPDFIndirectReference* dst,
+                                                       PendingOp continuable) {
     SkASSERT(!*dst);
     SkBlendMode blendMode = paint.getBlendMode_or(SkBlendMode::kSrcOver);
 
@@ -1236,6 +1293,9 @@ SkDynamicMemoryWStream* SkPDFDevice::setUpContentEntry(const SkClipStack* clipSt
     if (blendMode == SkBlendMode::kDst) {
         return nullptr;
     }
+    if (fPendingOp != continuable || !treat_as_regular_pdf_blend_mode(blendMode)) {
+        this->flushPendingOp();
+    }
 
     // For the following modes, we want to handle source and destination
     // separately, so make an object of what's already there.
@@ -1280,6 +1340,9 @@ SkDynamicMemoryWStream* SkPDFDevice::setUpContentEntry(const SkClipStack* clipSt
             &entry,
             &fShaderResources,
             &fGraphicStateResources);
+    if (fPendingOp != PendingOp::kNone && !fActiveStackState.isCurrent(clipStack, entry)) {
+        this->flushPendingOp();
+    }
     fActiveStackState.updateClip(clipStack, this->bounds());
     fActiveStackState.updateMatrix(entry.fMatrix);
     fActiveStackState.updateDrawingState(entry);
@@ -1428,6 +1491,21 @@ bool SkPDFDevice::isContentEmpty() {
     return fContent.bytesWritten() == 0 && fContentBuffer.bytesWritten() == 0;
 }
 
+void SkPDFDevice::flushPendingOp() {
+    switch (fPendingOp) {
+        case PendingOp::kNone:
+            return;
+        case PendingOp::kFill:
+            SkPDFUtils::PaintPath(SkPaint::kFill_Style, SkPathFillType::kWinding,
+                                  fActiveStackState.fContentStream);
+            break;
+        case PendingOp::kText:
+            fActiveStackState.fContentStream->writeText("ET\n");
+            break;
+    }
+    fPendingOp = PendingOp::kNone;
+}
+
 static SkSize rect_to_size(const SkRect& r) { return {r.width(), r.height()}; }
 
 static sk_sp<SkImage> color_filter(const SkImage* image,
@@ -1456,6 +1534,19 @@ static bool is_integral(const SkRect& r) {
            is_integer(r.bottom());
 }
 
+// Raster fallbacks (image filter results, images drawn with perspective) may cover the
+// whole page at the raster DPI.  Those are drawn as a grid of image XObjects, so that the
+// tiles are encoded concurrently on the document's executor and each is written out as
+// soon as it is done rather than all at once.  Other blend modes and alpha masks work
+// on the whole image, so those keep a single image.
+static bool needs_raster_tiles(const SkBitmap& bitmap, const SkPaint& paint) {
+    return (bitmap.width() > SkPDFDevice::kRasterTileSize ||
+            bitmap.height() > SkPDFDevice::kRasterTileSize) &&
+           bitmap.colorType() != kAlpha_8_SkColorType &&
+           paint.isSrcOver() &&
+           !paint.getMaskFilter();
+}
+
 void SkPDFDevice::internalDrawImageRect(SkKeyedImage imageSubset,
                                         const SkRect* src,
                                         const SkRect& dst,
@@ -1612,12 +1703,11 @@ void SkPDFDevice::internalDrawImageRect(SkKeyedImage imageSubset,
 
         SkISize wh = rect_to_size(physicalBounds).toCeil();
 
-        auto surface = SkSurface::MakeRaster(SkImageInfo::MakeN32Premul(wh));
-        if (!surface) {
+        SkBitmap bitmap;
+        if (!bitmap.tryAllocPixels(SkImageInfo::MakeN32Premul(wh))) {
             return;
         }
-        SkCanvas* canvas = surface->getCanvas();
-        canvas->clear(SK_ColorTRANSPARENT);
+        bitmap.eraseColor(SK_ColorTRANSPARENT);
 
         SkScalar deltaX = outlineBounds.left();
         SkScalar deltaY = outlineBounds.top();
@@ -1628,17 +1718,23 @@ void SkPDFDevice::internalDrawImageRect(SkKeyedImage imageSubset,
 
         // Translate the draw in the new canvas, so we perfectly fit the
         // shape in the bitmap.
-        canvas->setMatrix(offsetMatrix);
-        canvas->drawImage(imageSubset.image(), 0, 0);
-        // Make sure the final bits are in the bitmap.
-        surface->flushAndSubmit();
+        sk_sp<SkImage> perspectiveImage = imageSubset.image();
+        SkPDFUtils::DrawTiled(fDocument->executor(), bitmap.pixmap(), [&](SkCanvas* canvas) {
+            canvas->concat(offsetMatrix);
+            canvas->drawImage(perspectiveImage, 0, 0);
+        });
+        bitmap.setImmutable();
 
         // In the new space, we use the identity matrix translated
         // and scaled to reflect DPI.
         matrix.setScale(1 / scaleX, 1 / scaleY);
         matrix.postTranslate(deltaX, deltaY);
 
-        imageSubset = SkKeyedImage(surface->makeImageSnapshot());
+        if (needs_raster_tiles(bitmap, *paint)) {
+            this->drawRasterTiles(bitmap, sampling, *paint, matrix);
+            return;
+        }
+        imageSubset = SkKeyedImage(bitmap);
         if (!imageSubset) {
             return;
         }
@@ -1680,8 +1776,23 @@ void SkPDFDevice::internalDrawImageRect(SkKeyedImage imageSubset,
     SkPDFIndirectReference pdfimage = pdfimagePtr ? *pdfimagePtr : SkPDFIndirectReference();
     if (!pdfimagePtr) {
         SkASSERT(imageSubset);
-        pdfimage = SkPDFSerializeImage(imageSubset.image().get(), fDocument,
-                                       fDocument->metadata().fEncodingQuality);
+        // Distinct SkImages (e.g. the same file decoded for every page) can still share
+        // one image XObject if their content matches.
+        SkMD5::Digest digest;
+        double hashStart = SkTime::GetMSecs();
+        bool hasDigest = SkPDFImageDigest(imageSubset.image().get(), key.fSubset, &digest);
+        fDocument->noteHashingTime(SkTime::GetMSecs() - hashStart);
+        if (SkPDFIndirectReference* found =
+                    hasDigest ? fDocument->fImageDigestMap.find(digest) : nullptr) {
+            pdfimage = *found;
+            fDocument->noteDuplicateImage(pdfimage);
+        } else {
+            pdfimage = SkPDFSerializeImage(imageSubset.image().get(), fDocument,
+                                           fDocument->metadata().fEncodingQuality);
+            if (hasDigest) {
+                fDocument->fImageDigestMap.set(digest, pdfimage);
+            }
+        }
         SkASSERT((key != SkBitmapKey{{0, 0, 0, 0}, 0}));
         fDocument->fPDFBitmapMap.set(key, pdfimage);
     }
@@ -1739,12 +1850,37 @@ void SkPDFDevice::drawSpecial(SkSpecialImage* srcImg, const SkMatrix& localToDev
 
     SkBitmap resultBM;
     if (srcImg->getROPixels(&resultBM)) {
+        if (needs_raster_tiles(resultBM, paint) &&
+            !localToDevice.hasPerspective()) {
+            this->drawRasterTiles(resultBM, sampling, paint, localToDevice);
+            return;
+        }
         auto r = SkRect::MakeWH(resultBM.width(), resultBM.height());
         this->internalDrawImageRect(SkKeyedImage(resultBM), nullptr, r, sampling, paint,
                                     localToDevice);
     }
 }
 
+void SkPDFDevice::drawRasterTiles(const SkBitmap& bitmap,
+                                  const SkSamplingOptions& sampling,
+                                  const SkPaint& paint,
+                                  const SkMatrix& ctm) {
+    for (int y = 0; y < bitmap.height(); y += kRasterTileSize) {
+        for (int x = 0; x < bitmap.width(); x += kRasterTileSize) {
+            SkIRect tile = SkIRect::MakeXYWH(x, y, kRasterTileSize, kRasterTileSize);
+            if (!tile.intersect(bitmap.bounds())) {
+                continue;
+            }
+            SkBitmap tileBitmap;
+            if (!bitmap.extractSubset(&tileBitmap, tile)) {
+                continue;
+            }
+            this->internalDrawImageRect(SkKeyedImage(tileBitmap), nullptr, SkRect::Make(tile),
+                                        sampling, paint, ctm);
+        }
+    }
+}
+
 sk_sp<SkSpecialImage> SkPDFDevice::makeSpecial(const SkBitmap& bitmap) {
     return SkSpecialImage::MakeFromRaster(bitmap.bounds(), bitmap, this->surfaceProps());
 }
@@ -113,6 +113,9 @@ public:
 
     const SkMatrix& initialTransform() const { return fInitialTransform; }
 
+    /** Raster fallback images larger than this, in either dimension, are split into tiles. */
+    inline static constexpr int kRasterTileSize = 1024;
+
 protected:
     sk_sp<SkSurface> makeSurface(const SkImageInfo&, const SkSurfaceProps&) override;
 
@@ -143,6 +146,11 @@ private:
     SkDynamicMemoryWStream fContentBuffer;
     bool fNeedsExtraSave = false;
     SkPDFGraphicStackState fActiveStackState;
+    // The closing operator of the last drawing in fContent is held back so that
+    // a following drawing in the same graphic state can extend it: opaque rect
+    // fills share one 'f' and consecutive glyph runs share one BT/ET.
+    enum class PendingOp { kNone, kFill, kText };
+    PendingOp fPendingOp = PendingOp::kNone;
     SkPDFDocument* fDocument;
 
     ////////////////////////////////////////////////////////////////////////////
@@ -166,15 +174,22 @@ private:
                                               const SkMatrix& matrix,
                                               const SkPaint& paint,
                                               SkScalar,
-                                              SkPDFIndirectReference* dst);
+                                              SkPDFIndirectReference* dst,
+                                              PendingOp continuable = PendingOp::kNone);
     void finishContentEntry(const SkClipStack*, SkBlendMode, SkPDFIndirectReference, SkPath*);
     bool isContentEmpty();
+    void flushPendingOp();
 
     void internalDrawGlyphRun(
             const sktext::GlyphRun& glyphRun, SkPoint offset, const SkPaint& runPaint);
     void drawGlyphRunAsPath(
             const sktext::GlyphRun& glyphRun, SkPoint offset, const SkPaint& runPaint);
 
+    void drawRasterTiles(const SkBitmap&,
+                         const SkSamplingOptions&,
+                         const SkPaint&,
+                         const SkMatrix& ctm);
+
     void internalDrawImageRect(SkKeyedImage,
                                const SkRect* src,
                                const SkRect& dst,
@@ -8,9 +8,13 @@
 #include "include/docs/SkPDFDocument.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
 
+#include "include/core/SkExecutor.h"
+#include "include/core/SkPictureRecorder.h"
 #include "include/core/SkStream.h"
 #include "include/docs/SkPDFDocument.h"
+#include "include/private/base/SkSemaphore.h"
 #include "include/private/base/SkTo.h"
+#include "src/pdf/SkDeflate.h"
 #include "src/pdf/SkPDFDevice.h"
 #include "src/pdf/SkPDFFont.h"
 #include "src/pdf/SkPDFGradientShader.h"
@@ -20,6 +24,7 @@
 #include "src/pdf/SkPDFUtils.h"
 #include "src/utils/SkUTF.h"
 
+#include <algorithm>
 #include <utility>
 
 // For use in SkCanvas::drawAnnotation
@@ -67,6 +72,16 @@ void SkPDFOffsetMap::markStartOfObject(int referenceNumber, const SkWStream* s)
     fOffsets[index] = SkToInt(difference(s->bytesWritten(), fBaseOffset));
 }
 
+void SkPDFOffsetMap::markObjectInStream(int referenceNumber,
+                                        int objectStreamNumber,
+                                        int index) {
+    SkASSERT(referenceNumber > 0);
+    size_t size = std::max(fOffsets.size(), SkToSizeT(referenceNumber));
+    fOffsets.resize(size);
+    fObjectStreamEntries.resize(size);
+    fObjectStreamEntries[SkToSizeT(referenceNumber - 1)] = {objectStreamNumber, index};
+}
+
 int SkPDFOffsetMap::objectCount() const {
     return SkToInt(fOffsets.size() + 1); // Include the special zeroth object in the count.
 }
@@ -83,6 +98,53 @@ int SkPDFOffsetMap::emitCrossReferenceTable(SkWStream* s) const {
     }
     return xRefFileOffset;
 }
+
+static void write_big_endian(SkWStream* s, uint32_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        s->write8(SkToU8(value >> (8 * i)));
+    }
+}
+
+void SkPDFOffsetMap::emitCrossReferenceStreamData(SkWStream* s) const {
+    // The special zeroth object is free, and heads the (empty) list of free objects.
+    s->write8(0);
+    write_big_endian(s, 0, 4);
+    write_big_endian(s, 65535, 2);
+    for (size_t i = 0; i < fOffsets.size(); ++i) {
+        if (fOffsets[i] > 0) {
+            s->write8(1);
+            write_big_endian(s, SkToU32(fOffsets[i]), 4);
+            write_big_endian(s, 0, 2);  // Generation number.
+        } else if (i < fObjectStreamEntries.size() && fObjectStreamEntries[i].first > 0) {
+            s->write8(2);
+            write_big_endian(s, SkToU32(fObjectStreamEntries[i].first), 4);
+            write_big_endian(s, SkToU32(fObjectStreamEntries[i].second), 2);
+        } else {
+            // Reserved but never written, so it is free.
+            s->write8(0);
+            write_big_endian(s, 0, 4);
+            write_big_endian(s, 0, 2);
+        }
+    }
+}
+
+size_t SkPDFOffsetMap::objectBytes(const std::vector<int>& referenceNumbers,
+                                   const SkWStream* s) const {
+    if (referenceNumbers.empty()) {
+        return 0;
+    }
+    // Objects are written whole, so each one ends where the next one in the file begins.
+    std::vector<int> sorted = fOffsets;
+    std::sort(sorted.begin(), sorted.end());
+    int end = SkToInt(difference(s->bytesWritten(), fBaseOffset));
+    size_t total = 0;
+    for (int referenceNumber : referenceNumbers) {
+        int offset = fOffsets[SkToSizeT(referenceNumber - 1)];
+        auto next = std::upper_bound(sorted.begin(), sorted.end(), offset);
+        total += SkToSizeT((next == sorted.end() ? end : *next) - offset);
+    }
+    return total;
+}
 //
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -93,9 +155,10 @@ static_assert((SKPDF_MAGIC[1] & 0x7F) == "Skia"[1], "");
 static_assert((SKPDF_MAGIC[2] & 0x7F) == "Skia"[2], "");
 static_assert((SKPDF_MAGIC[3] & 0x7F) == "Skia"[3], "");
 #endif
-static void serializeHeader(SkPDFOffsetMap* offsetMap, SkWStream* wStream) {
+static void serializeHeader(SkPDFOffsetMap* offsetMap, SkWStream* wStream, bool pdf15) {
     offsetMap->markStartOfDocument(wStream);
-    wStream->writeText("%PDF-1.4\n%" SKPDF_MAGIC "\n");
+    // Object and cross-reference streams were introduced in PDF 1.5.
+    wStream->writeText(pdf15 ? "%PDF-1.5\n%" SKPDF_MAGIC "\n" : "%PDF-1.4\n%" SKPDF_MAGIC "\n");
     // The PDF spec recommends including a comment with four
     // bytes, all with their high bits set.  "\xD3\xEB\xE9\xE1" is
     // "Skia" with the high bits set.
@@ -135,13 +198,85 @@ static void serialize_footer(const SkPDFOffsetMap& offsetMap,
     wStream->writeText("\n%%EOF");
 }
 
+// Compresses the data of a stream object written while holding the document's lock, so it
+// cannot go through SkPDFStreamOut().
+static sk_sp<SkData> compress_stream_data(SkPDFDict* dict,
+                                          sk_sp<SkData> data,
+                                          SkPDF::Metadata::CompressionLevel level) {
+    if (level != SkPDF::Metadata::CompressionLevel::None) {
+        SkDynamicMemoryWStream compressed;
+        {
+            SkDeflateWStream deflate(&compressed, SkToInt(level));
+            deflate.write(data->data(), data->size());
+        }
+        dict->insertName("Filter", "FlateDecode");
+        data = compressed.detachAsData();
+    }
+    dict->insertInt("Length", SkToInt(data->size()));
+    return data;
+}
+
+static void write_stream_object(SkPDFOffsetMap* offsetMap,
+                                SkWStream* s,
+                                SkPDFIndirectReference ref,
+                                const SkPDFDict& dict,
+                                const SkData& data) {
+    begin_indirect_object(offsetMap, ref, s);
+    dict.emitObject(s);
+    s->writeText(" stream\n");
+    s->write(data.data(), data.size());
+    s->writeText("\nendstream");
+    end_indirect_object(s);
+}
+
+// Cross-reference stream and footer, for PDF 1.5 documents using object streams.  The
+// cross-reference stream is written as object |xRef|, which must be the last object.
+static void serialize_xref_stream_footer(SkPDFOffsetMap* offsetMap,
+                                         SkWStream* wStream,
+                                         SkPDFIndirectReference xRef,
+                                         SkPDFIndirectReference infoDict,
+                                         SkPDFIndirectReference docCatalog,
+                                         SkUUID uuid,
+                                         SkPDF::Metadata::CompressionLevel level) {
+    // The stream lists its own offset, so mark it before building the entries.
+    offsetMap->markStartOfObject(xRef.fValue, wStream);
+    int xRefFileOffset = offsetMap->offsetOf(xRef.fValue);
+    SkDynamicMemoryWStream entries;
+    offsetMap->emitCrossReferenceStreamData(&entries);
+
+    SkPDFDict xRefDict("XRef");
+    xRefDict.insertInt("Size", offsetMap->objectCount());
+    xRefDict.insertObject("W", SkPDFMakeArray(1, 4, 2));
+    SkASSERT(docCatalog != SkPDFIndirectReference());
+    xRefDict.insertRef("Root", docCatalog);
+    SkASSERT(infoDict != SkPDFIndirectReference());
+    xRefDict.insertRef("Info", infoDict);
+    if (SkUUID() != uuid) {
+        xRefDict.insertObject("ID", SkPDFMetadata::MakePdfId(uuid, uuid));
+    }
+    sk_sp<SkData> data = compress_stream_data(&xRefDict, entries.detachAsData(), level);
+
+    wStream->writeDecAsText(xRef.fValue);
+    wStream->writeText(" 0 obj\n");
+    xRefDict.emitObject(wStream);
+    wStream->writeText(" stream\n");
+    wStream->write(data->data(), data->size());
+    wStream->writeText("\nendstream");
+    end_indirect_object(wStream);
+    wStream->writeText("startxref\n");
+    wStream->writeBigDecAsText(xRefFileOffset);
+    wStream->writeText("\n%%EOF");
+}
+
+// PDF wants a tree describing all the pages in the document.  We arbitrary
+// choose 8 (kMaxPageTreeNodeSize) as the number of allowed children.
+static constexpr size_t kMaxPageTreeNodeSize = 8;
+
 static SkPDFIndirectReference generate_page_tree(
         SkPDFDocument* doc,
         std::vector<std::unique_ptr<SkPDFDict>> pages,
         const std::vector<SkPDFIndirectReference>& pageRefs) {
-    // PDF wants a tree describing all the pages in the document.  We arbitrary
-    // choose 8 (kNodeSize) as the number of allowed children.  The internal
-    // nodes have type "Pages" with an array of children, a parent pointer, and
+    // The internal nodes have type "Pages" with an array of children, a parent pointer, and
     // the number of leaves below the node as "Count."  The leaves are passed
     // into the method, have type "Page" and need a parent pointer. This method
     // builds the tree bottom up, skipping internal nodes that would have only
@@ -154,10 +289,9 @@ static SkPDFIndirectReference generate_page_tree(
 
         static std::vector<PageTreeNode> Layer(std::vector<PageTreeNode> vec, SkPDFDocument* doc) {
             std::vector<PageTreeNode> result;
-            static constexpr size_t kMaxNodeSize = 8;
             const size_t n = vec.size();
             SkASSERT(n >= 1);
-            const size_t result_len = (n - 1) / kMaxNodeSize + 1;
+            const size_t result_len = (n - 1) / kMaxPageTreeNodeSize + 1;
             SkASSERT(result_len >= 1);
             SkASSERT(n == 1 || result_len < n);
             result.reserve(result_len);
@@ -170,7 +304,7 @@ static SkPDFIndirectReference generate_page_tree(
                 SkPDFIndirectReference parent = doc->reserveRef();
                 auto kids_list = SkPDFMakeArray();
                 int descendantCount = 0;
-                for (size_t j = 0; j < kMaxNodeSize && index < n; ++j) {
+                for (size_t j = 0; j < kMaxPageTreeNodeSize && index < n; ++j) {
                     PageTreeNode& node = vec[index++];
                     node.fNode->insertRef("Parent", parent);
                     kids_list->appendRef(doc->emit(*node.fNode, node.fReservedRef));
@@ -220,6 +354,10 @@ SkPDFDocument::SkPDFDocument(SkWStream* stream,
         fTagTree.init(fMetadata.fStructureElementTreeRoot);
     }
     fExecutor = fMetadata.fExecutor;
+    // PDF/A-1 is based on PDF 1.4, which has no object streams.
+    if (fMetadata.fPDFA) {
+        fMetadata.fUseObjectStreams = false;
+    }
 }
 
 SkPDFDocument::~SkPDFDocument() {
@@ -229,11 +367,55 @@ SkPDFDocument::~SkPDFDocument() {
 
 SkPDFIndirectReference SkPDFDocument::emit(const SkPDFObject& object, SkPDFIndirectReference ref){
     SkAutoMutexExclusive lock(fMutex);
+    if (fMetadata.fUseObjectStreams) {
+        this->packObject(object, ref);
+        return ref;
+    }
     object.emitObject(this->beginObject(ref));
     this->endObject();
     return ref;
 }
 
+// Objects per object stream.  Larger streams compress better, but a reader has to
+// decompress a whole stream to get at any one object in it.
+static constexpr size_t kMaxObjectsPerObjectStream = 100;
+
+void SkPDFDocument::packObject(const SkPDFObject& object, SkPDFIndirectReference ref)
+        SK_REQUIRES(fMutex) {
+    fPackedObjects.emplace_back(ref.fValue, SkToInt(fPackedObjectData.bytesWritten()));
+    object.emitObject(&fPackedObjectData);
+    fPackedObjectData.writeText("\n");
+    if (fPackedObjects.size() == kMaxObjectsPerObjectStream) {
+        this->flushObjectStream();
+    }
+}
+
+void SkPDFDocument::flushObjectStream() SK_REQUIRES(fMutex) {
+    if (fPackedObjects.empty()) {
+        return;
+    }
+    SkPDFIndirectReference objectStream = this->reserveRef();
+    // An object stream starts with pairs of object numbers and offsets of the objects
+    // following them.
+    SkDynamicMemoryWStream content;
+    for (size_t i = 0; i < fPackedObjects.size(); ++i) {
+        const auto& [objectNumber, offset] = fPackedObjects[i];
+        fOffsetMap.markObjectInStream(objectNumber, objectStream.fValue, SkToInt(i));
+        content.writeDecAsText(objectNumber);
+        content.writeText(" ");
+        content.writeDecAsText(offset);
+        content.writeText("\n");
+    }
+    SkPDFDict dict("ObjStm");
+    dict.insertInt("N", SkToInt(fPackedObjects.size()));
+    dict.insertInt("First", SkToInt(content.bytesWritten()));
+    fPackedObjectData.writeToAndReset(&content);
+    fPackedObjects.clear();
+    sk_sp<SkData> data = compress_stream_data(&dict, content.detachAsData(),
+                                              fMetadata.fCompressionLevel);
+    write_stream_object(&fOffsetMap, this->getStream(), objectStream, dict, *data);
+}
+
 SkWStream* SkPDFDocument::beginObject(SkPDFIndirectReference ref) SK_REQUIRES(fMutex) {
     begin_indirect_object(&fOffsetMap, ref, this->getStream());
     return this->getStream();
@@ -248,11 +430,11 @@ static SkSize operator*(SkSize u, SkScalar s) { return SkSize{u.width() * s, u.h
 
 SkCanvas* SkPDFDocument::onBeginPage(SkScalar width, SkScalar height) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         // if this is the first page if the document.
         {
             SkAutoMutexExclusive autoMutexAcquire(fMutex);
-            serializeHeader(&fOffsetMap, this->getStream());
+            serializeHeader(&fOffsetMap, this->getStream(), fMetadata.fUseObjectStreams);
 
         }
 
@@ -376,9 +558,64 @@ void SkPDFDocument::onEndPage() {
     // The StructParents unique identifier for each page is just its
     // 0-based page index.
     page->insertInt("StructParents", SkToInt(this->currentPageIndex()));
+    if (fMetadata.fStreamPages) {
+        SkPDFIndirectReference pageRef = fPageRefs.back();
+        page->insertRef("Parent", this->openPageTreeNode(0));
+        this->emit(*page, pageRef);
+        PageTreeNode& parent = fOpenPageTreeNodes[0];
+        parent.fKids->appendRef(pageRef);
+        parent.fPageCount += 1;
+        SkAutoMutexExclusive autoMutexAcquire(fMutex);
+        // Write the page's packed objects now too, rather than when the object stream fills.
+        if (fMetadata.fUseObjectStreams) {
+            this->flushObjectStream();
+        }
+        this->getStream()->flush();
+        return;
+    }
     fPages.emplace_back(std::move(page));
 }
 
+// Returns the page tree node at |level| that the next kid should be added to.  A node is
+// only written once it is full and another kid arrives, so its parent is known by then.
+SkPDFIndirectReference SkPDFDocument::openPageTreeNode(size_t level) {
+    if (level == fOpenPageTreeNodes.size()) {
+        fOpenPageTreeNodes.push_back({this->reserveRef(), SkPDFMakeArray(), 0});
+    } else if (fOpenPageTreeNodes[level].fKids->size() == kMaxPageTreeNodeSize) {
+        this->closePageTreeNode(level);
+        fOpenPageTreeNodes[level] = {this->reserveRef(), SkPDFMakeArray(), 0};
+    }
+    return fOpenPageTreeNodes[level].fRef;
+}
+
+void SkPDFDocument::closePageTreeNode(size_t level) {
+    // May grow fOpenPageTreeNodes, so look up the nodes afterwards.
+    SkPDFIndirectReference parentRef = this->openPageTreeNode(level + 1);
+    PageTreeNode& node = fOpenPageTreeNodes[level];
+    SkPDFDict dict("Pages");
+    dict.insertInt("Count", node.fPageCount);
+    dict.insertObject("Kids", std::move(node.fKids));
+    dict.insertRef("Parent", parentRef);
+    this->emit(dict, node.fRef);
+    PageTreeNode& parent = fOpenPageTreeNodes[level + 1];
+    parent.fKids->appendRef(node.fRef);
+    parent.fPageCount += node.fPageCount;
+}
+
+SkPDFIndirectReference SkPDFDocument::finishPageTree() {
+    SkASSERT(!fOpenPageTreeNodes.empty());
+    for (size_t level = 0; level + 1 < fOpenPageTreeNodes.size(); ++level) {
+        this->closePageTreeNode(level);
+    }
+    PageTreeNode& root = fOpenPageTreeNodes.back();
+    SkPDFDict dict("Pages");
+    dict.insertInt("Count", root.fPageCount);
+    dict.insertObject("Kids", std::move(root.fKids));
+    SkPDFIndirectReference rootRef = this->emit(dict, root.fRef);
+    fOpenPageTreeNodes.clear();
+    return rootRef;
+}
+
 void SkPDFDocument::onAbort() {
     this->waitForJobs();
 }
@@ -567,7 +804,7 @@ SkString SkPDFDocument::nextFontSubsetTag() {
 
 void SkPDFDocument::onClose(SkWStream* stream) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    if (fPageRefs.empty()) {
         this->waitForJobs();
         return;
     }
@@ -580,7 +817,9 @@ void SkPDFDocument::onClose(SkWStream* stream) {
         docCatalog->insertObject("OutputIntents", make_srgb_output_intents(this));
     }
 
-    docCatalog->insertRef("Pages", generate_page_tree(this, std::move(fPages), fPageRefs));
+    docCatalog->insertRef("Pages", fMetadata.fStreamPages
+                                   ? this->finishPageTree()
+                                   : generate_page_tree(this, std::move(fPages), fPageRefs));
 
     if (!fNamedDestinations.empty()) {
         docCatalog->insertRef("Dests", append_destinations(this, fNamedDestinations));
@@ -605,10 +844,34 @@ void SkPDFDocument::onClose(SkWStream* stream) {
     this->waitForJobs();
     {
         SkAutoMutexExclusive autoMutexAcquire(fMutex);
-        serialize_footer(fOffsetMap, this->getStream(), fInfoDict, docCatalogRef, fUUID);
+        if (fMetadata.fUseObjectStreams) {
+            this->flushObjectStream();
+        }
+        if (fMetadata.fDedupStats) {
+            fDedupStats.fBytesSaved = fOffsetMap.objectBytes(fDuplicatedObjects,
+                                                             this->getStream());
+            *fMetadata.fDedupStats = fDedupStats;
+        }
+        if (fMetadata.fUseObjectStreams) {
+            serialize_xref_stream_footer(&fOffsetMap, this->getStream(), this->reserveRef(),
+                                         fInfoDict, docCatalogRef, fUUID,
+                                         fMetadata.fCompressionLevel);
+        } else {
+            serialize_footer(fOffsetMap, this->getStream(), fInfoDict, docCatalogRef, fUUID);
+        }
     }
 }
 
+void SkPDFDocument::noteDuplicateImage(SkPDFIndirectReference original) {
+    fDedupStats.fImagesDeduplicated++;
+    fDuplicatedObjects.push_back(original.fValue);
+}
+
+void SkPDFDocument::noteDuplicateFormXObject(SkPDFIndirectReference original) {
+    fDedupStats.fFormXObjectsDeduplicated++;
+    fDuplicatedObjects.push_back(original.fValue);
+}
+
 void SkPDFDocument::incrementJobCount() { fJobCount++; }
 
 void SkPDFDocument::signalJobComplete() { fSemaphore.signal(); }
@@ -629,6 +892,56 @@ void SkPDF::SetNodeId(SkCanvas* canvas, int nodeID) {
     canvas->drawAnnotation({0, 0, 0, 0}, key, payload.get());
 }
 
+void SkPDF::DrawPages(SkDocument* document, SkSpan<const Page> pages, SkExecutor* executor) {
+    if (!document) {
+        return;
+    }
+    auto record = [](const Page& page) {
+        SkPictureRecorder recorder;
+        page.fDraw(recorder.beginRecording(SkRect::MakeSize(page.fSize)));
+        return recorder.finishRecordingAsPicture();
+    };
+    auto needsRecording = [](const Page& page) { return !page.fPicture && page.fDraw; };
+
+    // SkPDFDevice names resources by object number, so pages have to reach the document in
+    // order for the output to be reproducible.  Only the callbacks run concurrently, at most
+    // kMaxPagesInFlight ahead of the page being emitted to bound the pictures held at once.
+    constexpr size_t kMaxPagesInFlight = 16;
+    std::vector<sk_sp<SkPicture>> recorded(executor ? pages.size() : 0);
+    std::unique_ptr<SkSemaphore[]> recordedReady(executor ? new SkSemaphore[pages.size()]
+                                                          : nullptr);
+    size_t scheduled = 0;
+
+    for (size_t i = 0; i < pages.size(); ++i) {
+        if (executor) {
+            for (; scheduled < std::min(i + kMaxPagesInFlight, pages.size()); ++scheduled) {
+                if (needsRecording(pages[scheduled])) {
+                    executor->add([&, index = scheduled]() {
+                        recorded[index] = record(pages[index]);
+                        recordedReady[index].signal();
+                    });
+                }
+            }
+        }
+        const Page& page = pages[i];
+        sk_sp<SkPicture> picture = page.fPicture;
+        if (needsRecording(page)) {
+            if (executor) {
+                recordedReady[i].wait();
+                picture = std::move(recorded[i]);
+            } else {
+                picture = record(page);
+            }
+        }
+        if (SkCanvas* canvas = document->beginPage(page.fSize.width(), page.fSize.height())) {
+            if (picture) {
+                picture->playback(canvas);
+            }
+            document->endPage();
+        }
+    }
+}
+
 sk_sp<SkDocument> SkPDF::MakeDocument(SkWStream* stream, const SkPDF::Metadata& metadata) {
     SkPDF::Metadata meta = metadata;
     if (meta.fRasterDPI <= 0) {
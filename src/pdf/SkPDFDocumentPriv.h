@@ -11,6 +11,7 @@
 #include "include/core/SkStream.h"
 #include "include/docs/SkPDFDocument.h"
 #include "include/private/base/SkMutex.h"
+#include "src/core/SkMD5.h"
 #include "src/core/SkTHash.h"
 #include "src/pdf/SkPDFMetadata.h"
 #include "src/pdf/SkPDFTag.h"
@@ -18,6 +19,7 @@
 #include <atomic>
 #include <vector>
 #include <memory>
+#include <utility>
 
 class SkExecutor;
 class SkPDFDevice;
@@ -40,10 +42,20 @@ class SkPDFOffsetMap {
 public:
     void markStartOfDocument(const SkWStream*);
     void markStartOfObject(int referenceNumber, const SkWStream*);
+    // Records that an object was packed into an object stream instead of written directly.
+    void markObjectInStream(int referenceNumber, int objectStreamNumber, int index);
     int objectCount() const;
     int emitCrossReferenceTable(SkWStream* s) const;
+    // Writes the binary entries of a cross-reference stream, using field widths [1 4 2].
+    void emitCrossReferenceStreamData(SkWStream* s) const;
+    int offsetOf(int referenceNumber) const { return fOffsets[referenceNumber - 1]; }
+    // Total bytes written for the given (already emitted) objects, counting repeats.
+    size_t objectBytes(const std::vector<int>& referenceNumbers, const SkWStream* s) const;
 private:
-    std::vector<int> fOffsets;
+    std::vector<int> fOffsets;  // Zero for objects in an object stream.
+    // Object stream number and index of packed objects, by object number.  Only sized once
+    // an object is packed.
+    std::vector<std::pair<int, int>> fObjectStreamEntries;
     size_t fBaseOffset = SIZE_MAX;
 };
 
@@ -135,11 +147,14 @@ public:
     SkExecutor* executor() const { return fExecutor; }
     void incrementJobCount();
     void signalJobComplete();
-    size_t currentPageIndex() { return fPages.size(); }
+    size_t currentPageIndex() { return SkASSERT(!fPageRefs.empty()), fPageRefs.size() - 1; }
     size_t pageCount() { return fPageRefs.size(); }
 
     const SkMatrix& currentPageTransform() const;
 
+    // Number of finished pages whose dictionaries are still held in memory.
+    size_t retainedPageCount() const { return fPages.size(); }
+
     // Canonicalized objects
     SkTHashMap<SkPDFImageShaderKey, SkPDFIndirectReference> fImageShaderMap;
     SkTHashMap<SkPDFGradientShader::Key, SkPDFIndirectReference, SkPDFGradientShader::KeyHash>
@@ -151,6 +166,8 @@ public:
     SkTHashMap<uint32_t, SkPDFIndirectReference> fFontDescriptors;
     SkTHashMap<uint32_t, SkPDFIndirectReference> fType3FontDescriptors;
     SkTHashMap<uint64_t, SkPDFFont> fFontMap;
+    SkTHashMap<SkMD5::Digest, SkPDFIndirectReference> fImageDigestMap;
+    SkTHashMap<SkMD5::Digest, SkPDFIndirectReference> fFormXObjectDigestMap;
     SkTHashMap<SkPDFStrokeGraphicState, SkPDFIndirectReference> fStrokeGSMap;
     SkTHashMap<SkPDFFillGraphicState, SkPDFIndirectReference> fFillGSMap;
     SkPDFIndirectReference fInvertFunction;
@@ -158,6 +175,11 @@ public:
     std::vector<std::unique_ptr<SkPDFLink>> fCurrentPageLinks;
     std::vector<SkPDFNamedDestination> fNamedDestinations;
 
+    // Content-hash deduplication bookkeeping, reported through SkPDF::Metadata::fDedupStats.
+    void noteDuplicateImage(SkPDFIndirectReference original);
+    void noteDuplicateFormXObject(SkPDFIndirectReference original);
+    void noteHashingTime(double ms) { fDedupStats.fHashingMs += ms; }
+
 private:
     SkPDFOffsetMap fOffsetMap;
     SkCanvas fCanvas;
@@ -165,6 +187,15 @@ private:
     std::vector<SkPDFIndirectReference> fPageRefs;
 
     sk_sp<SkPDFDevice> fPageDevice;
+
+    // With SkPDF::Metadata::fStreamPages, the page tree node at each level that is
+    // still accepting kids.  Level 0 holds the pages themselves.
+    struct PageTreeNode {
+        SkPDFIndirectReference fRef;
+        std::unique_ptr<SkPDFArray> fKids;
+        int fPageCount;
+    };
+    std::vector<PageTreeNode> fOpenPageTreeNodes;
     std::atomic<int> fNextObjectNumber = {1};
     std::atomic<int> fJobCount = {0};
     uint32_t fNextFontSubsetTag = {0};
@@ -179,12 +210,25 @@ private:
     // For tagged PDFs.
     SkPDFTagTree fTagTree;
 
+    SkPDF::DedupStats fDedupStats;
+    std::vector<int> fDuplicatedObjects;  // One entry per duplicate found.
+
     SkMutex fMutex;
     SkSemaphore fSemaphore;
 
+    // With SkPDF::Metadata::fUseObjectStreams, the serialized objects waiting to be packed
+    // into the next object stream, as object numbers and offsets into fPackedObjectData.
+    std::vector<std::pair<int, int>> fPackedObjects SK_GUARDED_BY(fMutex);
+    SkDynamicMemoryWStream fPackedObjectData SK_GUARDED_BY(fMutex);
+
     void waitForJobs();
+    SkPDFIndirectReference openPageTreeNode(size_t level);
+    void closePageTreeNode(size_t level);
+    SkPDFIndirectReference finishPageTree();
     SkWStream* beginObject(SkPDFIndirectReference);
     void endObject();
+    void packObject(const SkPDFObject&, SkPDFIndirectReference);
+    void flushObjectStream();
 };
 
 #endif  // SkPDFDocumentPriv_DEFINED
@@ -7,6 +7,7 @@
 
 #include "include/core/SkBitmap.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkFont.h"
 #include "include/core/SkFontMetrics.h"
 #include "include/core/SkFontTypes.h"
@@ -294,6 +295,47 @@ static sk_sp<SkData> stream_to_data(std::unique_ptr<SkStreamAsset> stream) {
     return SkData::MakeFromStream(stream.get(), size);
 }
 
+// Adds the subset of a TrueType font to its font descriptor, or the whole font if subsetting
+// fails.  May run on the document's executor.
+static void add_subset_font_file(SkPDFDict* descriptor,
+                                 SkTypeface* face,
+                                 std::unique_ptr<SkStreamAsset> fontAsset,
+                                 int ttcIndex,
+                                 const SkPDFGlyphUse& glyphUsage,
+                                 const char* fontName,
+                                 SkPDFDocument* doc) {
+    const size_t fontSize = fontAsset->getLength();
+    const SkPDF::Metadata& metadata = doc->metadata();
+    sk_sp<SkData> subsetFontData;
+    if (metadata.fCacheFontSubsets) {
+        subsetFontData = SkPDFSubsetFontCached(
+                face->uniqueID(), [&fontAsset]() { return stream_to_data(std::move(fontAsset)); },
+                glyphUsage, metadata.fSubsetter, fontName, ttcIndex);
+    } else {
+        subsetFontData = SkPDFSubsetFont(stream_to_data(std::move(fontAsset)), glyphUsage,
+                                         metadata.fSubsetter, fontName, ttcIndex);
+    }
+    if (subsetFontData) {
+        std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
+        tmp->insertInt("Length1", SkToInt(subsetFontData->size()));
+        descriptor->insertRef("FontFile2",
+                              SkPDFStreamOut(std::move(tmp),
+                                             SkMemoryStream::Make(std::move(subsetFontData)),
+                                             doc, SkPDFSteamCompressionEnabled::Yes));
+        return;
+    }
+    // If subsetting fails, fall back to original font data.
+    fontAsset = face->openStream(&ttcIndex);
+    SkASSERT(fontAsset);
+    SkASSERT(fontAsset->getLength() == fontSize);
+    if (!fontAsset || fontAsset->getLength() == 0) { return; }
+    std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
+    tmp->insertInt("Length1", fontSize);
+    descriptor->insertRef("FontFile2",
+                          SkPDFStreamOut(std::move(tmp), std::move(fontAsset),
+                                         doc, SkPDFSteamCompressionEnabled::Yes));
+}
+
 static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     const SkAdvancedTypefaceMetrics* metricsPtr =
         SkPDFFont::GetMetrics(font.typeface(), doc);
@@ -309,6 +351,7 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     uint16_t emSize = SkToU16(font.typeface()->getUnitsPerEm());
     SkPDFFont::PopulateCommonFontDescriptor(descriptor.get(), metrics, emSize, 0);
 
+    SkPDFIndirectReference descriptorRef;  // Set if the descriptor is emitted by a job.
     int ttcIndex;
     std::unique_ptr<SkStreamAsset> fontAsset = face->openStream(&ttcIndex);
     size_t fontSize = fontAsset ? fontAsset->getLength() : 0;
@@ -322,25 +365,31 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
                 if (!SkToBool(metrics.fFlags &
                               SkAdvancedTypefaceMetrics::kNotSubsettable_FontFlag)) {
                     SkASSERT(font.firstGlyphID() == 1);
-                    sk_sp<SkData> subsetFontData = SkPDFSubsetFont(
-                            stream_to_data(std::move(fontAsset)), font.glyphUsage(),
-                            doc->metadata().fSubsetter,
-                            metrics.fFontName.c_str(), ttcIndex);
-                    if (subsetFontData) {
-                        std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
-                        tmp->insertInt("Length1", SkToInt(subsetFontData->size()));
-                        descriptor->insertRef(
-                                "FontFile2",
-                                SkPDFStreamOut(std::move(tmp),
-                                               SkMemoryStream::Make(std::move(subsetFontData)),
-                                               doc, SkPDFSteamCompressionEnabled::Yes));
+                    SkExecutor* executor = doc->executor();
+                    if (!executor) {
+                        add_subset_font_file(descriptor.get(), face, std::move(fontAsset),
+                                             ttcIndex, font.glyphUsage(),
+                                             metrics.fFontName.c_str(), doc);
                         break;
                     }
-                    // If subsetting fails, fall back to original font data.
-                    fontAsset = face->openStream(&ttcIndex);
-                    SkASSERT(fontAsset);
-                    SkASSERT(fontAsset->getLength() == fontSize);
-                    if (!fontAsset || fontAsset->getLength() == 0) { break; }
+                    // Subsetting dominates the cost of emitting a font, so subset each font
+                    // concurrently and emit its descriptor once the font file is added.
+                    descriptorRef = doc->reserveRef();
+                    SkPDFDict* descriptorPtr = descriptor.release();
+                    SkStreamAsset* fontAssetPtr = fontAsset.release();
+                    const SkPDFGlyphUse* glyphUsage = &font.glyphUsage();
+                    doc->incrementJobCount();
+                    executor->add([descriptorPtr, fontAssetPtr, face = sk_ref_sp(face), ttcIndex,
+                                   glyphUsage, fontName = metrics.fFontName, doc,
+                                   descriptorRef]() {
+                        std::unique_ptr<SkPDFDict> descriptor(descriptorPtr);
+                        add_subset_font_file(descriptor.get(), face.get(),
+                                             std::unique_ptr<SkStreamAsset>(fontAssetPtr),
+                                             ttcIndex, *glyphUsage, fontName.c_str(), doc);
+                        doc->emit(*descriptor, descriptorRef);
+                        doc->signalJobComplete();
+                    });
+                    break;
                 }
                 std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
                 tmp->insertInt("Length1", fontSize);
@@ -363,7 +412,7 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     }
 
     auto newCIDFont = SkPDFMakeDict("Font");
-    newCIDFont->insertRef("FontDescriptor", doc->emit(*descriptor));
+    newCIDFont->insertRef("FontDescriptor", descriptor ? doc->emit(*descriptor) : descriptorRef);
     newCIDFont->insertName("BaseFont", metrics.fPostScriptName);
 
     switch (type) {
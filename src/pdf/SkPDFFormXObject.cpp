@@ -7,6 +7,10 @@
 
 
 #include "src/pdf/SkPDFFormXObject.h"
+
+#include "include/core/SkTime.h"
+#include "src/core/SkMD5.h"
+#include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/pdf/SkPDFUtils.h"
 
 SkPDFIndirectReference SkPDFMakeFormXObject(SkPDFDocument* doc,
@@ -35,5 +39,21 @@ SkPDFIndirectReference SkPDFMakeFormXObject(SkPDFDocument* doc,
     }
     group->insertBool("I", true);  // Isolated.
     dict->insertObject("Group", std::move(group));
-    return SkPDFStreamOut(std::move(dict), std::move(content), doc);
+
+    // Layers drawn the same way on several pages (e.g. a repeated picture drawn with
+    // alpha) produce identical forms; share a single object between them.
+    double hashStart = SkTime::GetMSecs();
+    SkMD5 md5;
+    dict->emitObject(&md5);
+    SkAssertResult(md5.writeStream(content.get(), content->getLength()));
+    SkAssertResult(content->rewind());
+    SkMD5::Digest digest = md5.finish();
+    doc->noteHashingTime(SkTime::GetMSecs() - hashStart);
+    if (SkPDFIndirectReference* found = doc->fFormXObjectDigestMap.find(digest)) {
+        doc->noteDuplicateFormXObject(*found);
+        return *found;
+    }
+    SkPDFIndirectReference ref = SkPDFStreamOut(std::move(dict), std::move(content), doc);
+    doc->fFormXObjectDigestMap.set(digest, ref);
+    return ref;
 }
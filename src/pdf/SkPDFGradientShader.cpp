@@ -8,6 +8,8 @@
 #include "src/pdf/SkPDFGradientShader.h"
 
 #include "include/docs/SkPDFDocument.h"
+#include "include/private/base/SkMutex.h"
+#include "src/core/SkLRUCache.h"
 #include "src/core/SkOpts.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/pdf/SkPDFFormXObject.h"
@@ -16,6 +18,9 @@
 #include "src/pdf/SkPDFTypes.h"
 #include "src/pdf/SkPDFUtils.h"
 
+#include <atomic>
+#include <vector>
+
 static uint32_t hash(const SkShaderBase::GradientInfo& v) {
     uint32_t buffer[] = {
         (uint32_t)v.fColorCount,
@@ -674,8 +679,58 @@ static SkPDFIndirectReference make_ps_function(std::unique_ptr<SkStreamAsset> ps
     return SkPDFStreamOut(std::move(dict), std::move(psCode), doc);
 }
 
-static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
-                                                   const SkPDFGradientShader::Key& state) {
+// warning: does not set fHash on new key.  (Both callers need to change fields.)
+static SkPDFGradientShader::Key clone_key(const SkPDFGradientShader::Key& k) {
+    SkPDFGradientShader::Key clone = {
+        k.fType,
+        k.fInfo,  // change pointers later.
+        std::unique_ptr<SkColor[]>(new SkColor[k.fInfo.fColorCount]),
+        std::unique_ptr<SkScalar[]>(new SkScalar[k.fInfo.fColorCount]),
+        k.fCanvasTransform,
+        k.fShaderTransform,
+        k.fBBox, 0};
+    clone.fInfo.fColors = clone.fColors.get();
+    clone.fInfo.fColorOffsets = clone.fStops.get();
+    for (int i = 0; i < clone.fInfo.fColorCount; i++) {
+        clone.fInfo.fColorOffsets[i] = k.fInfo.fColorOffsets[i];
+        clone.fInfo.fColors[i] = k.fInfo.fColors[i];
+    }
+    return clone;
+}
+
+namespace {
+// Everything make_function_shader() writes for a key, kept apart from any
+// document so that documents drawing the same gradients can share it.
+struct FunctionShader {
+    bool fValid = false;
+    bool fPostScript = false;
+    int32_t fShadingType = 1;
+    SkMatrix fMatrix;
+    std::vector<SkScalar> fCoords;  // Coords when stitched, Domain for PostScript.
+    sk_sp<SkData> fFunction;        // Function dictionary when stitched, PostScript code.
+};
+
+// An object already serialized by SkPDFObject::emitObject().
+class SkPDFSerializedObject final : public SkPDFObject {
+public:
+    explicit SkPDFSerializedObject(sk_sp<SkData> data) : fData(std::move(data)) {}
+    void emitObject(SkWStream* stream) const override {
+        stream->write(fData->data(), fData->size());
+    }
+
+private:
+    sk_sp<SkData> fData;
+};
+}  // namespace
+
+static sk_sp<SkData> serialize(const SkPDFObject& object) {
+    SkDynamicMemoryWStream buffer;
+    object.emitObject(&buffer);
+    return buffer.detachAsData();
+}
+
+static FunctionShader compute_function_shader(const SkPDFGradientShader::Key& state) {
+    FunctionShader result;
     SkPoint transformPoints[2];
     const SkShaderBase::GradientInfo& info = state.fInfo;
     SkMatrix finalMatrix = state.fCanvasTransform;
@@ -687,23 +742,14 @@ static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
                              (SkTileMode)info.fTileMode == SkTileMode::kClamp &&
                              !finalMatrix.hasPerspective();
 
-    int32_t shadingType = 1;
-    auto pdfShader = SkPDFMakeDict();
     // The two point radial gradient further references
     // state.fInfo
     // in translating from x, y coordinates to the t parameter. So, we have
     // to transform the points and radii according to the calculated matrix.
     if (doStitchFunctions) {
-        pdfShader->insertObject("Function", gradientStitchCode(info));
-        shadingType = (state.fType == SkShaderBase::GradientType::kLinear) ? 2 : 3;
-
-        auto extend = SkPDFMakeArray();
-        extend->reserve(2);
-        extend->appendBool(true);
-        extend->appendBool(true);
-        pdfShader->insertObject("Extend", std::move(extend));
+        result.fFunction = serialize(*gradientStitchCode(info));
+        result.fShadingType = (state.fType == SkShaderBase::GradientType::kLinear) ? 2 : 3;
 
-        std::unique_ptr<SkPDFArray> coords;
         if (state.fType == SkShaderBase::GradientType::kConical) {
             SkScalar r1 = info.fRadius[0];
             SkScalar r2 = info.fRadius[1];
@@ -711,30 +757,15 @@ static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
             SkPoint pt2 = info.fPoint[1];
             FixUpRadius(pt1, r1, pt2, r2);
 
-            coords = SkPDFMakeArray(pt1.x(),
-                                    pt1.y(),
-                                    r1,
-                                    pt2.x(),
-                                    pt2.y(),
-                                    r2);
+            result.fCoords = {pt1.x(), pt1.y(), r1, pt2.x(), pt2.y(), r2};
         } else if (state.fType == SkShaderBase::GradientType::kRadial) {
             const SkPoint& pt1 = info.fPoint[0];
-            coords = SkPDFMakeArray(pt1.x(),
-                                    pt1.y(),
-                                    0,
-                                    pt1.x(),
-                                    pt1.y(),
-                                    info.fRadius[0]);
+            result.fCoords = {pt1.x(), pt1.y(), 0, pt1.x(), pt1.y(), info.fRadius[0]};
         } else {
             const SkPoint& pt1 = info.fPoint[0];
             const SkPoint& pt2 = info.fPoint[1];
-            coords = SkPDFMakeArray(pt1.x(),
-                                    pt1.y(),
-                                    pt2.x(),
-                                    pt2.y());
+            result.fCoords = {pt1.x(), pt1.y(), pt2.x(), pt2.y()};
         }
-
-        pdfShader->insertObject("Coords", std::move(coords));
     } else {
         // Depending on the type of the gradient, we want to transform the
         // coordinate space in different ways.
@@ -759,7 +790,7 @@ static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
             case SkShaderBase::GradientType::kColor:
             case SkShaderBase::GradientType::kNone:
             default:
-                return SkPDFIndirectReference();
+                return result;
         }
 
         // Move any scaling (assuming a unit gradient) or translation
@@ -780,14 +811,14 @@ static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
         if (finalMatrix.hasPerspective()) {
             if (!split_perspective(finalMatrix,
                                    &finalMatrix, &perspectiveInverseOnly)) {
-                return SkPDFIndirectReference();
+                return result;
             }
         }
 
         SkRect bbox;
         bbox.set(state.fBBox);
         if (!SkPDFUtils::InverseTransformBBox(finalMatrix, &bbox)) {
-            return SkPDFIndirectReference();
+            return result;
         }
         SkDynamicMemoryWStream functionCode;
 
@@ -796,7 +827,7 @@ static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
         if (state.fType == SkShaderBase::GradientType::kConical) {
             SkMatrix inverseMapperMatrix;
             if (!mapperMatrix.invert(&inverseMapperMatrix)) {
-                return SkPDFIndirectReference();
+                return result;
             }
             inverseMapperMatrix.mapPoints(infoCopy.fPoint, 2);
             infoCopy.fRadius[0] = inverseMapperMatrix.mapRadius(info.fRadius[0]);
@@ -818,26 +849,118 @@ static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
             default:
                 SkASSERT(false);
         }
-        pdfShader->insertObject(
-                "Domain", SkPDFMakeArray(bbox.left(), bbox.right(), bbox.top(), bbox.bottom()));
+        result.fPostScript = true;
+        result.fCoords = {bbox.left(), bbox.right(), bbox.top(), bbox.bottom()};
+        result.fFunction = functionCode.detachAsData();
+    }
+    result.fMatrix = finalMatrix;
+    result.fValid = true;
+    return result;
+}
+
+static std::unique_ptr<SkPDFArray> make_scalar_array(const std::vector<SkScalar>& values) {
+    auto array = SkPDFMakeArray();
+    array->reserve(SkToInt(values.size()));
+    for (SkScalar value : values) {
+        array->appendScalar(value);
+    }
+    return array;
+}
+
+static SkPDFIndirectReference emit_function_shader(SkPDFDocument* doc,
+                                                   const FunctionShader& shader) {
+    if (!shader.fValid) {
+        return SkPDFIndirectReference();
+    }
+    auto pdfShader = SkPDFMakeDict();
+    if (!shader.fPostScript) {
+        pdfShader->insertObject("Function",
+                                std::make_unique<SkPDFSerializedObject>(shader.fFunction));
+
+        auto extend = SkPDFMakeArray();
+        extend->reserve(2);
+        extend->appendBool(true);
+        extend->appendBool(true);
+        pdfShader->insertObject("Extend", std::move(extend));
+
+        pdfShader->insertObject("Coords", make_scalar_array(shader.fCoords));
+    } else {
+        pdfShader->insertObject("Domain", make_scalar_array(shader.fCoords));
 
-        auto domain = SkPDFMakeArray(bbox.left(), bbox.right(), bbox.top(), bbox.bottom());
         std::unique_ptr<SkPDFArray> rangeObject = SkPDFMakeArray(0, 1, 0, 1, 0, 1);
         pdfShader->insertRef("Function",
-                             make_ps_function(functionCode.detachAsStream(), std::move(domain),
+                             make_ps_function(SkMemoryStream::Make(shader.fFunction),
+                                              make_scalar_array(shader.fCoords),
                                               std::move(rangeObject), doc));
     }
 
-    pdfShader->insertInt("ShadingType", shadingType);
+    pdfShader->insertInt("ShadingType", shader.fShadingType);
     pdfShader->insertName("ColorSpace", "DeviceRGB");
 
     SkPDFDict pdfFunctionShader("Pattern");
     pdfFunctionShader.insertInt("PatternType", 2);
-    pdfFunctionShader.insertObject("Matrix", SkPDFUtils::MatrixToArray(finalMatrix));
+    pdfFunctionShader.insertObject("Matrix", SkPDFUtils::MatrixToArray(shader.fMatrix));
     pdfFunctionShader.insertObject("Shading", std::move(pdfShader));
     return doc->emit(pdfFunctionShader);
 }
 
+namespace {
+struct FunctionShaderCacheKey {
+    SkPDFGradientShader::Key fKey;
+
+    FunctionShaderCacheKey(SkPDFGradientShader::Key key) : fKey(std::move(key)) {}
+    FunctionShaderCacheKey(const FunctionShaderCacheKey& that) : fKey(clone_key(that.fKey)) {
+        fKey.fHash = that.fKey.fHash;
+    }
+    bool operator==(const FunctionShaderCacheKey& that) const { return fKey == that.fKey; }
+    struct Hash {
+        uint32_t operator()(const FunctionShaderCacheKey& k) const { return k.fKey.fHash; }
+    };
+};
+}  // namespace
+
+// The PostScript for sweep and perspective gradients is a few kilobytes at most.
+static constexpr int kMaxCachedFunctionShaders = 128;
+
+static SkMutex& function_shader_cache_mutex() {
+    static SkMutex& mutex = *(new SkMutex);
+    return mutex;
+}
+
+static std::atomic<int> gFunctionShaderCacheHits{0};
+static std::atomic<int> gFunctionShaderCacheMisses{0};
+
+static SkPDFIndirectReference make_function_shader(SkPDFDocument* doc,
+                                                   const SkPDFGradientShader::Key& state) {
+    static auto* cache = new SkLRUCache<FunctionShaderCacheKey, FunctionShader,
+                                        FunctionShaderCacheKey::Hash>(kMaxCachedFunctionShaders);
+    FunctionShaderCacheKey key(clone_key(state));
+    key.fKey.fHash = state.fHash;
+    FunctionShader cached;
+    {
+        SkAutoMutexExclusive lock(function_shader_cache_mutex());
+        if (const FunctionShader* found = cache->find(key)) {
+            cached = *found;
+        }
+    }
+    if (cached.fValid) {
+        gFunctionShaderCacheHits.fetch_add(1, std::memory_order_relaxed);
+        return emit_function_shader(doc, cached);
+    }
+    gFunctionShaderCacheMisses.fetch_add(1, std::memory_order_relaxed);
+    // Computed outside the lock; racing documents compute identical results.
+    FunctionShader shader = compute_function_shader(state);
+    SkPDFIndirectReference ref = emit_function_shader(doc, shader);
+    SkAutoMutexExclusive lock(function_shader_cache_mutex());
+    cache->insert_or_update(key, std::move(shader));
+    return ref;
+}
+
+SkPDFGradientShader::FunctionCacheStats SkPDFGradientShader::GetFunctionCacheStats() {
+    return {gFunctionShaderCacheHits.load(std::memory_order_relaxed),
+            gFunctionShaderCacheMisses.load(std::memory_order_relaxed)};
+}
+
 static SkPDFIndirectReference find_pdf_shader(SkPDFDocument* doc,
                                               SkPDFGradientShader::Key key,
                                               bool keyHasAlpha);
@@ -884,25 +1007,6 @@ static bool gradient_has_alpha(const SkPDFGradientShader::Key& key) {
     return false;
 }
 
-// warning: does not set fHash on new key.  (Both callers need to change fields.)
-static SkPDFGradientShader::Key clone_key(const SkPDFGradientShader::Key& k) {
-    SkPDFGradientShader::Key clone = {
-        k.fType,
-        k.fInfo,  // change pointers later.
-        std::unique_ptr<SkColor[]>(new SkColor[k.fInfo.fColorCount]),
-        std::unique_ptr<SkScalar[]>(new SkScalar[k.fInfo.fColorCount]),
-        k.fCanvasTransform,
-        k.fShaderTransform,
-        k.fBBox, 0};
-    clone.fInfo.fColors = clone.fColors.get();
-    clone.fInfo.fColorOffsets = clone.fStops.get();
-    for (int i = 0; i < clone.fInfo.fColorCount; i++) {
-        clone.fInfo.fColorOffsets[i] = k.fInfo.fColorOffsets[i];
-        clone.fInfo.fColors[i] = k.fInfo.fColors[i];
-    }
-    return clone;
-}
-
 static SkPDFIndirectReference create_smask_graphic_state(SkPDFDocument* doc,
                                                      const SkPDFGradientShader::Key& state) {
     SkASSERT(state.fType != SkShaderBase::GradientType::kNone);
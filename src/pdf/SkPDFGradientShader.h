@@ -23,6 +23,15 @@ SkPDFIndirectReference Make(SkPDFDocument* doc,
                             const SkMatrix& matrix,
                             const SkIRect& surfaceBBox);
 
+/** Pattern and function objects for a gradient are computed once per process and reused by
+    every document that draws the same gradient.  These count lookups since startup.
+*/
+struct FunctionCacheStats {
+    int fHits;
+    int fMisses;
+};
+FunctionCacheStats GetFunctionCacheStats();
+
 struct Key {
     SkShaderBase::GradientType fType;
     SkShaderBase::GradientInfo fInfo;
@@ -216,6 +216,25 @@ void SkPDFGraphicStackState::updateDrawingState(const SkPDFGraphicStackState::En
     }
 }
 
+bool SkPDFGraphicStackState::isCurrent(const SkClipStack* clipStack,
+                                       const SkPDFGraphicStackState::Entry& state) const {
+    const Entry& current = fEntries[fStackDepth];
+    uint32_t clipStackGenID = clipStack ? clipStack->getTopmostGenID()
+                                        : SkClipStack::kWideOpenGenID;
+    if (clipStackGenID != current.fClipStackGenID || state.fMatrix != current.fMatrix) {
+        return false;
+    }
+    if (state.fShaderIndex >= 0) {
+        if (state.fShaderIndex != current.fShaderIndex) {
+            return false;
+        }
+    } else if (state.fColor != current.fColor || current.fShaderIndex >= 0) {
+        return false;
+    }
+    return state.fGraphicStateIndex == current.fGraphicStateIndex &&
+           (!state.fTextScaleX || state.fTextScaleX == current.fTextScaleX);
+}
+
 void SkPDFGraphicStackState::push() {
     SkASSERT(fStackDepth < kMaxStackDepth);
     fContentStream->writeText("q\n");
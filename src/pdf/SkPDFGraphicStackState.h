@@ -31,6 +31,9 @@ struct SkPDFGraphicStackState {
     void updateClip(const SkClipStack* clipStack, const SkIRect& bounds);
     void updateMatrix(const SkMatrix& matrix);
     void updateDrawingState(const Entry& state);
+    // True if updateClip(), updateMatrix() and updateDrawingState() would not
+    // need to write anything to move to the given state.
+    bool isCurrent(const SkClipStack* clipStack, const Entry& state) const;
     void push();
     void pop();
     void drainStack();
@@ -7,11 +7,12 @@
 
 #include "src/pdf/SkPDFShader.h"
 
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
 #include "include/private/base/SkMath.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkStream.h"
-#include "include/core/SkSurface.h"
 #include "include/docs/SkPDFDocument.h"
 #include "include/private/SkTPin.h"
 #include "include/private/SkTemplates.h"
@@ -287,22 +288,28 @@ static SkPDFIndirectReference make_fallback_shader(SkPDFDocument* doc,
     SkSize scale = {SkIntToScalar(size.width()) / shaderRect.width(),
                     SkIntToScalar(size.height()) / shaderRect.height()};
 
-    auto surface = SkSurface::MakeRasterN32Premul(size.width(), size.height());
-    SkASSERT(surface);
-    SkCanvas* canvas = surface->getCanvas();
-    canvas->clear(SK_ColorTRANSPARENT);
+    SkBitmap bitmap;
+    if (!bitmap.tryAllocN32Pixels(size.width(), size.height())) {
+        return SkPDFIndirectReference();
+    }
+    bitmap.eraseColor(SK_ColorTRANSPARENT);
 
     SkPaint p(paintColor);
     p.setShader(sk_ref_sp(shader));
 
-    canvas->scale(scale.width(), scale.height());
-    canvas->translate(-shaderRect.x(), -shaderRect.y());
-    canvas->drawPaint(p);
+    // Runtime effects and other shaders that land here can be slow per pixel, so shade
+    // the tiles of the bitmap concurrently.
+    SkPDFUtils::DrawTiled(doc->executor(), bitmap.pixmap(), [&](SkCanvas* canvas) {
+        canvas->scale(scale.width(), scale.height());
+        canvas->translate(-shaderRect.x(), -shaderRect.y());
+        canvas->drawPaint(p);
+    });
 
     auto shaderTransform = SkMatrix::Translate(shaderRect.x(), shaderRect.y());
     shaderTransform.preScale(1 / scale.width(), 1 / scale.height());
 
-    sk_sp<SkImage> image = surface->makeImageSnapshot();
+    bitmap.setImmutable();
+    sk_sp<SkImage> image = bitmap.asImage();
     SkASSERT(image);
     return make_image_shader(doc,
                              SkMatrix::Concat(canvasTransform, shaderTransform),
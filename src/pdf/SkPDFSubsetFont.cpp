@@ -3,6 +3,13 @@
 
 #include "src/pdf/SkPDFSubsetFont.h"
 
+#include "include/private/SkChecksum.h"
+#include "include/private/base/SkMutex.h"
+#include "include/private/base/SkTo.h"
+#include "src/core/SkLRUCache.h"
+
+#include <vector>
+
 #if defined(SK_PDF_USE_HARFBUZZ_SUBSET)
 
 #include "include/private/SkTemplates.h"
@@ -201,3 +208,59 @@ sk_sp<SkData> SkPDFSubsetFont(sk_sp<SkData>, const SkPDFGlyphUse&, SkPDF::Metada
     return nullptr;
 }
 #endif  // defined(SK_PDF_USE_SFNTLY)
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+struct SubsetKey {
+    uint32_t fTypefaceID;
+    SkPDF::Metadata::Subsetter fSubsetter;
+    int fTTCIndex;
+    std::vector<SkGlyphID> fGlyphs;
+    uint32_t fHash;
+
+    bool operator==(const SubsetKey& that) const {
+        return fTypefaceID == that.fTypefaceID && fSubsetter == that.fSubsetter &&
+               fTTCIndex == that.fTTCIndex && fGlyphs == that.fGlyphs;
+    }
+    struct Hash {
+        uint32_t operator()(const SubsetKey& key) const { return key.fHash; }
+    };
+};
+}  // namespace
+
+// Subsets of CJK fonts can be megabytes, so only keep a few.
+static constexpr int kMaxCachedSubsets = 32;
+
+static SkMutex& subset_cache_mutex() {
+    static SkMutex& mutex = *(new SkMutex);
+    return mutex;
+}
+
+sk_sp<SkData> SkPDFSubsetFontCached(uint32_t typefaceID,
+                                    const std::function<sk_sp<SkData>()>& fontData,
+                                    const SkPDFGlyphUse& glyphUsage,
+                                    SkPDF::Metadata::Subsetter subsetter,
+                                    const char* fontName,
+                                    int ttcIndex) {
+    SubsetKey key{typefaceID, subsetter, ttcIndex, {}, 0};
+    glyphUsage.getSetValues([&key](unsigned gid) { key.fGlyphs.push_back(SkToU16(gid)); });
+    uint32_t header[] = {typefaceID, (uint32_t)subsetter, (uint32_t)ttcIndex};
+    key.fHash = SkOpts::hash_fn(key.fGlyphs.data(), key.fGlyphs.size() * sizeof(SkGlyphID),
+                                SkOpts::hash_fn(header, sizeof(header), 0));
+
+    static auto* cache = new SkLRUCache<SubsetKey, sk_sp<SkData>, SubsetKey::Hash>(
+            kMaxCachedSubsets);
+    {
+        SkAutoMutexExclusive lock(subset_cache_mutex());
+        if (sk_sp<SkData>* found = cache->find(key)) {
+            return *found;
+        }
+    }
+    // Subset outside the lock so that different fonts are subset concurrently.  A subset
+    // computed twice by racing documents is identical, so either one may be kept.
+    sk_sp<SkData> subset = SkPDFSubsetFont(fontData(), glyphUsage, subsetter, fontName, ttcIndex);
+    SkAutoMutexExclusive lock(subset_cache_mutex());
+    cache->insert_or_update(key, subset);
+    return subset;
+}
@@ -7,10 +7,23 @@
 #include "include/docs/SkPDFDocument.h"
 #include "src/pdf/SkPDFGlyphUse.h"
 
+#include <functional>
+
 sk_sp<SkData> SkPDFSubsetFont(sk_sp<SkData> fontData,
                               const SkPDFGlyphUse& glyphUsage,
                               SkPDF::Metadata::Subsetter subsetter,
                               const char* fontName,
                               int ttcIndex);
 
+/** Like SkPDFSubsetFont(), but reuses a subset made earlier, by any document, for the same
+    typeface ID, subsetter and glyph set.  fontData is only called if none is cached.
+    Thread safe.
+*/
+sk_sp<SkData> SkPDFSubsetFontCached(uint32_t typefaceID,
+                                    const std::function<sk_sp<SkData>()>& fontData,
+                                    const SkPDFGlyphUse& glyphUsage,
+                                    SkPDF::Metadata::Subsetter subsetter,
+                                    const char* fontName,
+                                    int ttcIndex);
+
 #endif  // SkPDFSubsetFont_DEFINED
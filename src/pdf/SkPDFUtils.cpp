@@ -8,16 +8,21 @@
 #include "src/pdf/SkPDFUtils.h"
 
 #include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/private/SkFixed.h"
+#include "include/private/base/SkSemaphore.h"
 #include "src/core/SkGeometry.h"
 #include "src/core/SkPathPriv.h"
 #include "src/image/SkImage_Base.h"
 #include "src/pdf/SkPDFResourceDict.h"
 #include "src/pdf/SkPDFTypes.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 
 const char* SkPDFUtils::BlendModeName(SkBlendMode mode) {
@@ -393,3 +398,60 @@ void SkPDFUtils::AppendTransform(const SkMatrix& matrix, SkWStream* content) {
     }
     content->writeText("cm\n");
 }
+
+namespace {
+// Shared with the executor jobs, which may start only after every tile is drawn and
+// DrawTiled() has returned.  Such late jobs find no tile left and touch nothing else.
+struct TiledDraw {
+    static constexpr int kTileSize = 256;  // A multiple of the dither matrix size.
+
+    SkPixmap fDst;
+    std::function<void(SkCanvas*)> fDraw;
+    int fColumns;
+    int fTileCount;
+    std::atomic<int> fNextTile{0};
+    std::atomic<int> fTilesDone{0};
+    SkSemaphore fAllDone;
+
+    void drawTiles() {
+        for (int i; (i = fNextTile.fetch_add(1, std::memory_order_relaxed)) < fTileCount;) {
+            SkIRect tile = SkIRect::MakeXYWH((i % fColumns) * kTileSize,
+                                             (i / fColumns) * kTileSize,
+                                             kTileSize, kTileSize);
+            SkPixmap pixmap;
+            if (fDst.extractSubset(&pixmap, tile)) {
+                std::unique_ptr<SkCanvas> canvas = SkCanvas::MakeRasterDirect(
+                        pixmap.info(), pixmap.writable_addr(), pixmap.rowBytes());
+                if (canvas) {
+                    canvas->translate(-tile.x(), -tile.y());
+                    fDraw(canvas.get());
+                }
+            }
+            if (fTilesDone.fetch_add(1, std::memory_order_acq_rel) + 1 == fTileCount) {
+                fAllDone.signal();
+            }
+        }
+    }
+};
+}  // namespace
+
+void SkPDFUtils::DrawTiled(SkExecutor* executor, const SkPixmap& dst,
+                           std::function<void(SkCanvas*)> draw) {
+    constexpr int kTileSize = TiledDraw::kTileSize;
+    constexpr int kMaxHelpers = 16;
+    auto state = std::make_shared<TiledDraw>();
+    state->fDst = dst;
+    state->fDraw = std::move(draw);
+    state->fColumns = (dst.width() + kTileSize - 1) / kTileSize;
+    state->fTileCount = state->fColumns * ((dst.height() + kTileSize - 1) / kTileSize);
+    if (state->fTileCount == 0) {
+        return;
+    }
+    if (executor) {
+        for (int i = std::min(state->fTileCount - 1, kMaxHelpers); i > 0; --i) {
+            executor->add([state]() { state->drawTiles(); });
+        }
+    }
+    state->drawTiles();
+    state->fAllDone.wait();
+}
@@ -17,8 +17,13 @@
 #include "src/utils/SkFloatToDecimal.h"
 #include "src/utils/SkUTF.h"
 
+#include <functional>
+
+class SkCanvas;
+class SkExecutor;
 class SkMatrix;
 class SkPDFArray;
+class SkPixmap;
 struct SkRect;
 
 template <typename T>
@@ -127,6 +132,12 @@ void PopulateTilingPatternDict(SkPDFDict* pattern,
 
 bool ToBitmap(const SkImage* img, SkBitmap* dst);
 
+// Rasterizes into dst one tile at a time, on the calling thread and, if there is one, on
+// the executor.  draw is called concurrently, each time with a canvas that covers one tile
+// but uses dst's coordinates.  Returns once every tile is drawn.
+void DrawTiled(SkExecutor* executor, const SkPixmap& dst,
+               std::function<void(SkCanvas*)> draw);
+
 #ifdef SK_PDF_BASE85_BINARY
 void Base85Encode(std::unique_ptr<SkStreamAsset> src, SkDynamicMemoryWStream* dst);
 #endif //  SK_PDF_BASE85_BINARY
@@ -14,6 +14,7 @@
 #include "include/core/SkGraphics.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRefCnt.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/private/SkColorData.h"
@@ -38,6 +39,7 @@
 #include "src/utils/SkCallableTraits.h"
 #include "src/utils/SkMatrix22.h"
 
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <tuple>
@@ -136,7 +138,7 @@ extern "C" {
 }
 FT_MemoryRec_ gFTMemory = { nullptr, sk_ft_alloc, sk_ft_free, sk_ft_realloc };
 
-class FreeTypeLibrary : SkNoncopyable {
+class FreeTypeLibrary : public SkNVRefCnt<FreeTypeLibrary> {
 public:
     FreeTypeLibrary() : fLibrary(nullptr) {
         if (FT_New_Library(&gFTMemory, &fLibrary)) {
@@ -166,8 +168,13 @@ public:
 
     FT_Library library() { return fLibrary; }
 
+    // Serializes creating and destroying faces and sizes in a per-thread library, which may
+    // happen on any thread that releases the last use of a face.
+    SkMutex& mutex() { return fMutex; }
+
 private:
     FT_Library fLibrary;
+    SkMutex fMutex;
 
     // FT_Library_SetLcdFilterWeights 2.4.0
     // FT_LOAD_COLOR 2.5.0
@@ -199,6 +206,26 @@ static SkMutex& f_t_mutex() {
 
 static FreeTypeLibrary* gFTLibrary;
 
+static std::atomic<bool> gPerThreadFaces{false};
+
+void SkTypeface_FreeType::SetPerThreadFaces(bool enabled) {
+    gPerThreadFaces.store(enabled, std::memory_order_relaxed);
+}
+
+bool SkTypeface_FreeType::GetPerThreadFaces() {
+    return gPerThreadFaces.load(std::memory_order_relaxed);
+}
+
+// The library faces opened by the calling thread are made in. The thread's reference is dropped
+// when it exits; faces still open keep their library alive.
+static sk_sp<FreeTypeLibrary> thread_ft_library() {
+    static thread_local sk_sp<FreeTypeLibrary> library;
+    if (!library) {
+        library = sk_make_sp<FreeTypeLibrary>();
+    }
+    return library;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 
 class SkTypeface_FreeType::FaceRec {
@@ -210,13 +237,23 @@ public:
     std::unique_ptr<SkColor[]> fSkPalette;
 
     static std::unique_ptr<FaceRec> Make(const SkTypeface_FreeType* typeface);
+    // Opens a face only the caller uses, in the calling thread's library.
+    static std::unique_ptr<FaceRec> MakeForCurrentThread(const SkTypeface_FreeType* typeface);
     ~FaceRec();
 
+    // The lock to hold while creating or destroying sizes of this face.
+    SkMutex& libraryMutex() { return fLibrary ? fLibrary->mutex() : f_t_mutex(); }
+
 private:
-    FaceRec(std::unique_ptr<SkStreamAsset> stream);
+    FaceRec(std::unique_ptr<SkStreamAsset> stream, sk_sp<FreeTypeLibrary> library);
+    static std::unique_ptr<FaceRec> Make(const SkTypeface_FreeType* typeface,
+                                         sk_sp<FreeTypeLibrary> library);
     void setupAxes(const SkFontData& data);
     void setupPalette(const SkFontData& data);
 
+    // Set for faces opened in a per-thread library, nullptr for faces in gFTLibrary.
+    sk_sp<FreeTypeLibrary> fLibrary;
+
     // Private to ref_ft_library and unref_ft_library
     static int gFTCount;
 
@@ -268,8 +305,10 @@ extern "C" {
     static void sk_ft_stream_close(FT_Stream) {}
 }
 
-SkTypeface_FreeType::FaceRec::FaceRec(std::unique_ptr<SkStreamAsset> stream)
+SkTypeface_FreeType::FaceRec::FaceRec(std::unique_ptr<SkStreamAsset> stream,
+                                      sk_sp<FreeTypeLibrary> library)
         : fSkStream(std::move(stream))
+        , fLibrary(std::move(library))
 {
     sk_bzero(&fFTStream, sizeof(fFTStream));
     fFTStream.size = fSkStream->getLength();
@@ -277,11 +316,18 @@ SkTypeface_FreeType::FaceRec::FaceRec(std::unique_ptr<SkStreamAsset> stream)
     fFTStream.read  = sk_ft_stream_io;
     fFTStream.close = sk_ft_stream_close;
 
-    f_t_mutex().assertHeld();
-    ref_ft_library();
+    if (!fLibrary) {
+        f_t_mutex().assertHeld();
+        ref_ft_library();
+    }
 }
 
 SkTypeface_FreeType::FaceRec::~FaceRec() {
+    if (fLibrary) {
+        SkAutoMutexExclusive ac(fLibrary->mutex());
+        fFace.reset(); // fLibrary is released after this, keeping the library alive until now.
+        return;
+    }
     f_t_mutex().assertHeld();
     fFace.reset(); // Must release face before the library, the library frees existing faces.
     unref_ft_library();
@@ -373,13 +419,29 @@ void SkTypeface_FreeType::FaceRec::setupPalette(const SkFontData& data) {
 std::unique_ptr<SkTypeface_FreeType::FaceRec>
 SkTypeface_FreeType::FaceRec::Make(const SkTypeface_FreeType* typeface) {
     f_t_mutex().assertHeld();
+    return Make(typeface, nullptr);
+}
 
+// Will return nullptr on failure
+std::unique_ptr<SkTypeface_FreeType::FaceRec>
+SkTypeface_FreeType::FaceRec::MakeForCurrentThread(const SkTypeface_FreeType* typeface) {
+    sk_sp<FreeTypeLibrary> library = thread_ft_library();
+    if (!library->library()) {
+        return nullptr;
+    }
+    return Make(typeface, std::move(library));
+}
+
+std::unique_ptr<SkTypeface_FreeType::FaceRec>
+SkTypeface_FreeType::FaceRec::Make(const SkTypeface_FreeType* typeface,
+                                   sk_sp<FreeTypeLibrary> library) {
     std::unique_ptr<SkFontData> data = typeface->makeFontData();
     if (nullptr == data || !data->hasStream()) {
         return nullptr;
     }
 
-    std::unique_ptr<FaceRec> rec(new FaceRec(data->detachStream()));
+    // Memory backed font data is shared by every face opened on it, not copied.
+    std::unique_ptr<FaceRec> rec(new FaceRec(data->detachStream(), std::move(library)));
 
     FT_Open_Args args;
     memset(&args, 0, sizeof(args));
@@ -395,7 +457,13 @@ SkTypeface_FreeType::FaceRec::Make(const SkTypeface_FreeType* typeface) {
 
     {
         FT_Face rawFace;
-        FT_Error err = FT_Open_Face(gFTLibrary->library(), &args, data->getIndex(), &rawFace);
+        FT_Error err;
+        if (rec->fLibrary) {
+            SkAutoMutexExclusive ac(rec->fLibrary->mutex());
+            err = FT_Open_Face(rec->fLibrary->library(), &args, data->getIndex(), &rawFace);
+        } else {
+            err = FT_Open_Face(gFTLibrary->library(), &args, data->getIndex(), &rawFace);
+        }
         if (err) {
             SK_TRACEFTR(err, "unable to open font '%x'", typeface->uniqueID());
             return nullptr;
@@ -459,7 +527,12 @@ protected:
     void generateFontMetrics(SkFontMetrics*) override;
 
 private:
-    SkTypeface_FreeType::FaceRec* fFaceRec; // Borrowed face from the typeface's FaceRec.
+    SkTypeface_FreeType::FaceRec* fFaceRec; // The typeface's FaceRec or fOwnedFaceRec.
+    // Set when this context has a face of its own (see SkTypeface_FreeType::SetPerThreadFaces).
+    std::unique_ptr<SkTypeface_FreeType::FaceRec> fOwnedFaceRec;
+    // Held while using fFace: f_t_mutex() when the face is shared, else fOwnedFaceMutex.
+    SkMutex*  fFaceMutex;
+    SkMutex   fOwnedFaceMutex;
     FT_Face   fFace;  // Borrowed face from fFaceRec.
     FT_Size   fFTSize;  // The size to apply to the fFace.
     FT_Int    fStrikeIndex; // The bitmap strike for the fFace (or -1 if none).
@@ -482,9 +555,9 @@ private:
     static bool getBoundsOfCurrentOutlineGlyph(FT_GlyphSlot glyph, SkRect* bounds);
     static void setGlyphBounds(SkGlyph* glyph, SkRect* bounds, bool subpixel);
     bool getCBoxForLetter(char letter, FT_BBox* bbox);
-    // Caller must lock f_t_mutex() before calling this function.
+    // Caller must lock fFaceMutex before calling this function.
     void updateGlyphBoundsIfLCD(SkGlyph* glyph);
-    // Caller must lock f_t_mutex() before calling this function.
+    // Caller must lock fFaceMutex before calling this function.
     // update FreeType2 glyph slot with glyph emboldened
     void emboldenIfNeeded(FT_Face face, FT_GlyphSlot glyph, SkGlyphID gid);
     bool shouldSubpixelBitmap(const SkGlyph&, const SkMatrix&);
@@ -878,12 +951,20 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
                                                    const SkScalerContextEffects& effects,
                                                    const SkDescriptor* desc)
     : SkScalerContext_FreeType_Base(std::move(typeface), effects, desc)
+    , fFaceMutex(&f_t_mutex())
     , fFace(nullptr)
     , fFTSize(nullptr)
     , fStrikeIndex(-1)
 {
-    SkAutoMutexExclusive  ac(f_t_mutex());
-    fFaceRec = static_cast<SkTypeface_FreeType*>(this->getTypeface())->getFaceRec();
+    const auto* ftTypeface = static_cast<SkTypeface_FreeType*>(this->getTypeface());
+    if (ftTypeface->usesPerThreadFaces()) {
+        fOwnedFaceRec = SkTypeface_FreeType::FaceRec::MakeForCurrentThread(ftTypeface);
+        fFaceRec = fOwnedFaceRec.get();
+        fFaceMutex = &fOwnedFaceMutex;
+    } else {
+        SkAutoMutexExclusive ac(f_t_mutex());
+        fFaceRec = ftTypeface->getFaceRec();
+    }
 
     // load the font file
     if (nullptr == fFaceRec) {
@@ -891,6 +972,10 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
         return;
     }
 
+    // Nothing else uses an owned face yet, so the library lock (f_t_mutex() for a shared face)
+    // covers everything here.
+    SkAutoMutexExclusive  ac(fFaceRec->libraryMutex());
+
     fLCDIsVert = SkToBool(fRec.fFlags & SkScalerContext::kLCD_Vertical_Flag);
 
     // compute the flags we send to Load_Glyph
@@ -1059,20 +1144,20 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(sk_sp<SkTypeface_FreeType> ty
 }
 
 SkScalerContext_FreeType::~SkScalerContext_FreeType() {
-    SkAutoMutexExclusive  ac(f_t_mutex());
-
     if (fFTSize != nullptr) {
+        SkAutoMutexExclusive  ac(fFaceRec->libraryMutex());
         FT_Done_Size(fFTSize);
     }
 
     fFaceRec = nullptr;
+    fOwnedFaceRec.reset(); // Locks its library itself.
 }
 
 /*  We call this before each use of the fFace, since we may be sharing
     this face with other context (at different sizes).
 */
 FT_Error SkScalerContext_FreeType::setupSize() {
-    f_t_mutex().assertHeld();
+    fFaceMutex->assertHeld();
     FT_Error err = FT_Activate_Size(fFTSize);
     if (err != 0) {
         return err;
@@ -1089,7 +1174,7 @@ bool SkScalerContext_FreeType::generateAdvance(SkGlyph* glyph) {
         return false;
     }
 
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     if (this->setupSize()) {
         glyph->zeroMetrics();
@@ -1201,7 +1286,7 @@ bool SkScalerContext_FreeType::shouldSubpixelBitmap(const SkGlyph& glyph, const
 }
 
 void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph, SkArenaAlloc* alloc) {
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     if (this->setupSize()) {
         glyph->zeroMetrics();
@@ -1384,7 +1469,7 @@ void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph, SkArenaAlloc* all
 }
 
 void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph) {
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     if (this->setupSize()) {
         sk_bzero(glyph.fImage, glyph.imageSize());
@@ -1457,7 +1542,7 @@ sk_sp<SkDrawable> SkScalerContext_FreeType::generateDrawable(const SkGlyph& glyp
     // It should be possible to draw the drawable straight out of the FT_Face. However, this would
     // mean locking each time any such drawable is drawn. To avoid locking, this implementation
     // creates drawables backed as pictures so that they can be played back later without locking.
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     if (this->setupSize()) {
         return nullptr;
@@ -1508,7 +1593,7 @@ sk_sp<SkDrawable> SkScalerContext_FreeType::generateDrawable(const SkGlyph& glyp
 bool SkScalerContext_FreeType::generatePath(const SkGlyph& glyph, SkPath* path) {
     SkASSERT(path);
 
-    SkAutoMutexExclusive  ac(f_t_mutex());
+    SkAutoMutexExclusive  ac(*fFaceMutex);
 
     SkGlyphID glyphID = glyph.getGlyphID();
     // FT_IS_SCALABLE is documented to mean the face contains outline glyphs.
@@ -1550,7 +1635,7 @@ void SkScalerContext_FreeType::generateFontMetrics(SkFontMetrics* metrics) {
         return;
     }
 
-    SkAutoMutexExclusive ac(f_t_mutex());
+    SkAutoMutexExclusive ac(*fFaceMutex);
 
     if (this->setupSize()) {
         sk_bzero(metrics, sizeof(*metrics));
@@ -20,6 +20,8 @@
 
 #include "include/core/SkFontMgr.h"
 
+#include <atomic>
+
 // These are forward declared to avoid pimpl but also hide the FreeType implementation.
 typedef struct FT_LibraryRec_* FT_Library;
 typedef struct FT_FaceRec_* FT_Face;
@@ -112,6 +114,22 @@ public:
     /** Fetch units/EM from "head" table if needed (ie for bitmap fonts) */
     static int GetUnitsPerEm(FT_Face face);
 
+    /** When enabled, scaler contexts created afterwards open their own FT_Face in a FreeType
+     *  library owned by the creating thread instead of sharing the typeface's face under a
+     *  global lock, so different strikes rasterize glyphs concurrently. Each strike then costs
+     *  an FT_Face. Off by default.
+     */
+    static void SetPerThreadFaces(bool);
+    static bool GetPerThreadFaces();
+
+    /** Like SetPerThreadFaces(), for the scaler contexts of this typeface only. */
+    void setPerThreadFaces(bool enabled) {
+        fPerThreadFaces.store(enabled, std::memory_order_relaxed);
+    }
+    bool usesPerThreadFaces() const {
+        return fPerThreadFaces.load(std::memory_order_relaxed) || GetPerThreadFaces();
+    }
+
     /** Return the font data, or nullptr on failure. */
     std::unique_ptr<SkFontData> makeFontData() const;
     class FaceRec;
@@ -161,6 +179,8 @@ private:
     mutable SkOnce fGlyphMasksMayNeedCurrentColorOnce;
     mutable bool fGlyphMasksMayNeedCurrentColor;
 
+    std::atomic<bool> fPerThreadFaces{false};
+
     using INHERITED = SkTypeface;
 };
 
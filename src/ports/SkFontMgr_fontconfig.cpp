@@ -20,12 +20,19 @@
 #include "include/private/base/SkTDArray.h"
 #include "src/core/SkAdvancedTypefaceMetrics.h"
 #include "src/core/SkFontDescriptor.h"
+#include "src/core/SkLRUCache.h"
 #include "src/core/SkOSFile.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkTHash.h"
 #include "src/core/SkTypefaceCache.h"
 #include "src/ports/SkFontHost_FreeType_common.h"
+#include "src/ports/SkFontMgr_fontconfig_priv.h"
 
 #include <fontconfig/fontconfig.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <cstdio>
 
 class SkData;
 
@@ -449,6 +456,7 @@ public:
     }
     mutable SkAutoFcPattern fPattern;  // Mutable for passing to FontConfig API.
     const SkString fSysroot;
+    SkString fSnapshotPattern;  // The saved FcNameUnparse'd pattern, if made from a snapshot.
 
     void onGetFamilyName(SkString* familyName) const override {
         *familyName = get_string(fPattern, FC_FAMILY);
@@ -563,11 +571,54 @@ private:
 };
 
 class SkFontMgr_fontconfig : public SkFontMgr {
+    /** The arguments of a matchFamilyStyle or matchFamilyStyleCharacter call. */
+    struct MatchKey {
+        bool fHasFamilyName = false;
+        SkString fFamilyName;
+        SkFontStyle fStyle;
+        SkUnichar fCharacter = -1;  // -1 for matchFamilyStyle.
+        SkString fLanguages;        // The bcp47 tags, each followed by '\n'.
+
+        bool operator==(const MatchKey& that) const {
+            return fHasFamilyName == that.fHasFamilyName &&
+                   fFamilyName == that.fFamilyName &&
+                   fStyle == that.fStyle &&
+                   fCharacter == that.fCharacter &&
+                   fLanguages == that.fLanguages;
+        }
+        struct Hash {
+            uint32_t operator()(const MatchKey& key) const {
+                int32_t values[] = { key.fHasFamilyName, key.fStyle.weight(), key.fStyle.width(),
+                                     key.fStyle.slant(), key.fCharacter };
+                uint32_t hash = SkOpts::hash_fn(values, sizeof(values), 0);
+                hash = SkOpts::hash_fn(key.fFamilyName.c_str(), key.fFamilyName.size(), hash);
+                return SkOpts::hash_fn(key.fLanguages.c_str(), key.fLanguages.size(), hash);
+            }
+        };
+    };
+
+    /** What a font manager learned about the fonts, saved to skip asking FontConfig again.
+     *  The matches are FcNameUnparse'd patterns, or empty when there was no match.
+     */
+    struct Snapshot {
+        sk_sp<SkDataTable> fFamilyNames;
+        SkTHashMap<MatchKey, SkString, MatchKey::Hash> fMatches;
+    };
+
     mutable SkAutoFcConfig fFC;  // Only mutable to avoid const cast when passed to FontConfig API.
     const SkString fSysroot;
+    const SkString fSnapshotPath;
+    const Snapshot fSnapshot;
     const sk_sp<SkDataTable> fFamilyNames;
     const SkTypeface_FreeType::Scanner fScanner;
 
+    // Results of matchFamilyStyle and matchFamilyStyleCharacter, so repeated lookups (like
+    // fallback for every character of a run) don't go to FontConfig. Misses are cached as nullptr.
+    static constexpr int kMatchCacheLimit = 4096;
+    mutable SkMutex fMatchCacheMutex;
+    mutable SkLRUCache<MatchKey, sk_sp<SkTypeface>, MatchKey::Hash> fMatchCache{kMatchCacheLimit};
+    mutable std::atomic<int> fFontConfigMatchCount{0};  // Matches neither cache could answer.
+
     class StyleSet : public SkFontStyleSet {
     public:
         StyleSet(sk_sp<SkFontMgr_fontconfig> parent, SkAutoFcFontSet fontSet)
@@ -680,55 +731,312 @@ class SkFontMgr_fontconfig : public SkFontMgr {
                                            sizes.begin(), names.size());
     }
 
+    static SkString UnparsePattern(FcPattern* pattern) {
+        SkString unparsed;
+        if (FcChar8* chars = FcNameUnparse(pattern)) {
+            unparsed.set(reinterpret_cast<const char*>(chars));
+            FcStrFree(chars);
+        }
+        return unparsed;
+    }
+
+    struct PatternToFind {
+        FcPattern* fPattern;
+        SkString fSnapshotPattern;  // Non-empty if fPattern was parsed from a snapshot.
+    };
+
     static bool FindByFcPattern(SkTypeface* cached, void* ctx) {
         SkTypeface_fontconfig* cshFace = static_cast<SkTypeface_fontconfig*>(cached);
-        FcPattern* ctxPattern = static_cast<FcPattern*>(ctx);
-        return FcTrue == FcPatternEqual(cshFace->fPattern, ctxPattern);
+        PatternToFind* toFind = static_cast<PatternToFind*>(ctx);
+        if (FcTrue == FcPatternEqual(cshFace->fPattern, toFind->fPattern)) {
+            return true;
+        }
+        // FcNameParse(FcNameUnparse(p)) need not be FcPatternEqual to p (doubles are printed
+        // with %g, for one), so a pattern from a snapshot is compared in its unparsed form.
+        if (cshFace->fSnapshotPattern.isEmpty() && toFind->fSnapshotPattern.isEmpty()) {
+            return false;
+        }
+        const SkString& cshUnparsed = cshFace->fSnapshotPattern.isEmpty()
+                                    ? UnparsePattern(cshFace->fPattern)
+                                    : cshFace->fSnapshotPattern;
+        if (toFind->fSnapshotPattern.isEmpty()) {
+            toFind->fSnapshotPattern = UnparsePattern(toFind->fPattern);
+        }
+        return cshUnparsed == toFind->fSnapshotPattern;
     }
 
     mutable SkMutex fTFCacheMutex;
     mutable SkTypefaceCache fTFCache;
+
+    static MatchKey MakeMatchKey(const char familyName[], const SkFontStyle& style,
+                                 const char* bcp47[], int bcp47Count, SkUnichar character) {
+        MatchKey key;
+        key.fHasFamilyName = familyName != nullptr;
+        key.fFamilyName.set(familyName ? familyName : "");
+        key.fStyle = style;
+        key.fCharacter = character;
+        for (int i = 0; i < bcp47Count; ++i) {
+            key.fLanguages.append(bcp47[i]);
+            key.fLanguages.append("\n");
+        }
+        return key;
+    }
+
+    /** Returns the cached result for key, falling back to the snapshot, or false if neither
+     *  has one.
+     */
+    bool findMatch(const MatchKey& key, sk_sp<SkTypeface>* typeface) const {
+        {
+            SkAutoMutexExclusive ama(fMatchCacheMutex);
+            if (const sk_sp<SkTypeface>* cached = fMatchCache.find(key)) {
+                *typeface = *cached;
+                return true;
+            }
+        }
+
+        const SkString* saved = fSnapshot.fMatches.find(key);
+        if (!saved) {
+            return false;
+        }
+        if (!saved->isEmpty()) {
+            SkAutoFcPattern pattern([&]() -> FcPattern* {
+                FCLocker lock;
+                FcPattern* pattern = FcNameParse(reinterpret_cast<const FcChar8*>(saved->c_str()));
+                if (pattern && !FontAccessible(pattern)) {
+                    FcPatternDestroy(pattern);
+                    return nullptr;
+                }
+                return pattern;
+            }());
+            if (!pattern) {
+                // The font went away since the snapshot was taken; match again.
+                return false;
+            }
+            *typeface = createTypefaceFromFcPattern(std::move(pattern), *saved);
+        }
+        this->addMatch(key, *typeface);
+        return true;
+    }
+
+    void addMatch(const MatchKey& key, sk_sp<SkTypeface> typeface) const {
+        SkAutoMutexExclusive ama(fMatchCacheMutex);
+        fMatchCache.insert_or_update(key, std::move(typeface));
+    }
+
+    /** Identifies the installed fonts and configuration: changes when any font directory or
+     *  config file is added, removed, or modified.
+     */
+    static uint32_t FontDirsFingerprint(FcConfig* fcconfig) {
+        FCLocker lock;
+        int32_t version = FcGetVersion();
+        uint32_t hash = SkOpts::hash_fn(&version, sizeof(version), 0);
+        auto hashPaths = [&hash](FcStrList* paths) {
+            while (FcChar8* chars = FcStrListNext(paths)) {
+                const char* path = reinterpret_cast<const char*>(chars);
+                hash = SkOpts::hash_fn(path, strlen(path), hash);
+                struct stat status;
+                if (0 == stat(path, &status)) {
+                    int64_t mtime = status.st_mtime;
+                    hash = SkOpts::hash_fn(&mtime, sizeof(mtime), hash);
+                }
+            }
+            FcStrListDone(paths);
+        };
+        hashPaths(FcConfigGetFontDirs(fcconfig));
+        hashPaths(FcConfigGetConfigFiles(fcconfig));
+        return hash;
+    }
+
+    static constexpr uint32_t kSnapshotMagic = SkSetFourByteTag('S', 'k', 'F', 'C');
+    static constexpr uint32_t kSnapshotVersion = 2;
+
+    static bool ReadString(SkStream* stream, SkString* string) {
+        size_t length;
+        if (!stream->readPackedUInt(&length) || length > stream->getLength()) {
+            return false;
+        }
+        string->resize(length);
+        return stream->read(string->data(), length) == length;
+    }
+
+    static bool WriteString(SkWStream* stream, const SkString& string) {
+        return stream->writePackedUInt(string.size()) && stream->write(string.c_str(), string.size());
+    }
+
+    /** Reads a snapshot written by WriteSnapshot, if it was taken with the same fonts installed. */
+    static Snapshot ReadSnapshot(const SkString& path, FcConfig* fcconfig) {
+        Snapshot snapshot;
+        if (path.isEmpty()) {
+            return snapshot;
+        }
+        std::unique_ptr<SkStreamAsset> stream = SkStream::MakeFromFile(path.c_str());
+        uint32_t magic, version, fingerprint, familyCount, matchCount;
+        if (!stream ||
+            !stream->readU32(&magic) || magic != kSnapshotMagic ||
+            !stream->readU32(&version) || version != kSnapshotVersion ||
+            !stream->readU32(&fingerprint) || fingerprint != FontDirsFingerprint(fcconfig) ||
+            !stream->readU32(&familyCount))
+        {
+            return snapshot;
+        }
+
+        SkTArray<SkString> names;
+        for (uint32_t i = 0; i < familyCount; ++i) {
+            if (!ReadString(stream.get(), &names.push_back())) {
+                return Snapshot();
+            }
+        }
+        if (!stream->readU32(&matchCount)) {
+            return Snapshot();
+        }
+        for (uint32_t i = 0; i < matchCount; ++i) {
+            MatchKey key;
+            uint32_t hasFamilyName, style;
+            int32_t character;
+            SkString pattern;
+            if (!stream->readU32(&hasFamilyName) || !ReadString(stream.get(), &key.fFamilyName) ||
+                !stream->readU32(&style) || !stream->readS32(&character) ||
+                !ReadString(stream.get(), &key.fLanguages) || !ReadString(stream.get(), &pattern))
+            {
+                return Snapshot();
+            }
+            key.fHasFamilyName = hasFamilyName;
+            key.fStyle = SkFontStyle(style & 0xFFFF, (style >> 16) & 0xFF,
+                                     static_cast<SkFontStyle::Slant>(style >> 24));
+            key.fCharacter = character;
+            snapshot.fMatches.set(std::move(key), std::move(pattern));
+        }
+
+        SkTDArray<const char*> strings;
+        SkTDArray<size_t> sizes;
+        for (const SkString& name : names) {
+            strings.push_back(name.c_str());
+            sizes.push_back(name.size() + 1);
+        }
+        snapshot.fFamilyNames = SkDataTable::MakeCopyArrays((void const *const *)strings.begin(),
+                                                            sizes.begin(), strings.size());
+        return snapshot;
+    }
+
     /** Creates a typeface using a typeface cache.
      *  @param pattern a complete pattern from FcFontRenderPrepare.
+     *  @param snapshotPattern the unparsed form of pattern, if it was read from a snapshot.
      */
-    sk_sp<SkTypeface> createTypefaceFromFcPattern(SkAutoFcPattern pattern) const {
+    sk_sp<SkTypeface> createTypefaceFromFcPattern(SkAutoFcPattern pattern,
+                                                  const SkString& snapshotPattern = SkString())
+                                                  const {
         if (!pattern) {
             return nullptr;
         }
         // Cannot hold FCLocker when calling fTFCache.add; an evicted typeface may need to lock.
         // Must hold fTFCacheMutex when interacting with fTFCache.
         SkAutoMutexExclusive ama(fTFCacheMutex);
+        SkTypefaceCache::Key key;
         sk_sp<SkTypeface> face = [&]() {
             FCLocker lock;
-            sk_sp<SkTypeface> face = fTFCache.findByProcAndRef(FindByFcPattern, pattern);
+            // Equal patterns name the same file and index, so only typefaces with those need
+            // to be compared.
+            key.fIdentity.set(get_string(pattern, FC_FILE));
+            key.fIndex = get_int(pattern, FC_INDEX, 0);
+            PatternToFind toFind{pattern, snapshotPattern};
+            sk_sp<SkTypeface> face = fTFCache.findByKeyAndRef(key, FindByFcPattern, &toFind);
             if (face) {
                 pattern.reset();
             }
             return face;
         }();
         if (!face) {
-            face = SkTypeface_fontconfig::Make(std::move(pattern), fSysroot);
-            if (face) {
-                // Cannot hold FCLocker in fTFCache.add; evicted typefaces may need to lock.
-                fTFCache.add(face);
-            }
+            sk_sp<SkTypeface_fontconfig> fcFace =
+                    SkTypeface_fontconfig::Make(std::move(pattern), fSysroot);
+            fcFace->fSnapshotPattern = snapshotPattern;
+            face = std::move(fcFace);
+            // Cannot hold FCLocker in fTFCache.add; evicted typefaces may need to lock.
+            fTFCache.add(face, std::move(key));
         }
         return face;
     }
 
 public:
     /** Takes control of the reference to 'config'. */
-    explicit SkFontMgr_fontconfig(FcConfig* config)
+    explicit SkFontMgr_fontconfig(FcConfig* config, const char snapshotPath[] = nullptr)
         : fFC(config ? config : FcInitLoadConfigAndFonts())
         , fSysroot(reinterpret_cast<const char*>(FcConfigGetSysRoot(fFC)))
-        , fFamilyNames(GetFamilyNames(fFC)) { }
+        , fSnapshotPath(snapshotPath ? snapshotPath : "")
+        , fSnapshot(ReadSnapshot(fSnapshotPath, fFC))
+        , fFamilyNames(fSnapshot.fFamilyNames ? fSnapshot.fFamilyNames : GetFamilyNames(fFC)) { }
 
     ~SkFontMgr_fontconfig() override {
+        if (!fSnapshotPath.isEmpty()) {
+            this->writeSnapshot();
+        }
+        // Drop the cached typefaces before the config they came from.
+        fMatchCache.reset();
+
         // Hold the lock while unrefing the config.
         FCLocker lock;
         fFC.reset();
     }
 
+    /** Saves the family names and everything matched so far (or read from the last snapshot).
+     *  Written to a temporary file first so readers never see a partial snapshot.
+     */
+    bool writeSnapshot() const {
+        if (fSnapshotPath.isEmpty()) {
+            return false;
+        }
+        SkTHashMap<MatchKey, SkString, MatchKey::Hash> matches = fSnapshot.fMatches;
+        {
+            SkAutoMutexExclusive ama(fMatchCacheMutex);
+            FCLocker lock;
+            fMatchCache.foreach([&](const MatchKey* key, sk_sp<SkTypeface>* typeface) {
+                SkString pattern;
+                if (*typeface) {
+                    // The whole pattern is kept so the restored typeface is the one a live match
+                    // of the same font finds in the typeface cache.
+                    auto* fcTypeface = static_cast<SkTypeface_fontconfig*>(typeface->get());
+                    pattern = fcTypeface->fSnapshotPattern.isEmpty()
+                            ? UnparsePattern(fcTypeface->fPattern)
+                            : fcTypeface->fSnapshotPattern;
+                    if (pattern.isEmpty()) {
+                        return;
+                    }
+                }
+                matches.set(*key, std::move(pattern));
+            });
+        }
+
+        SkString tempPath = SkStringPrintf("%s.tmp", fSnapshotPath.c_str());
+        {
+            SkFILEWStream stream(tempPath.c_str());
+            if (!stream.isValid()) {
+                return false;
+            }
+            bool ok = stream.write32(kSnapshotMagic) &&
+                      stream.write32(kSnapshotVersion) &&
+                      stream.write32(FontDirsFingerprint(fFC)) &&
+                      stream.write32(fFamilyNames->count());
+            for (int i = 0; ok && i < fFamilyNames->count(); ++i) {
+                ok = WriteString(&stream, SkString(fFamilyNames->atStr(i)));
+            }
+            ok = ok && stream.write32(matches.count());
+            matches.foreach([&](const MatchKey& key, SkString* pattern) {
+                uint32_t style = key.fStyle.weight() | (key.fStyle.width() << 16) |
+                                 (key.fStyle.slant() << 24);
+                ok = ok && stream.write32(key.fHasFamilyName) &&
+                     WriteString(&stream, key.fFamilyName) &&
+                     stream.write32(style) && stream.write32(key.fCharacter) &&
+                     WriteString(&stream, key.fLanguages) && WriteString(&stream, *pattern);
+            });
+            if (!ok) {
+                return false;
+            }
+        }
+        return 0 == std::rename(tempPath.c_str(), fSnapshotPath.c_str());
+    }
+
+    /** The number of matches neither the match cache nor the snapshot answered. */
+    int fontConfigMatchCount() const { return fFontConfigMatchCount.load(); }
+
 protected:
     int onCountFamilies() const override {
         return fFamilyNames->count();
@@ -872,6 +1180,18 @@ protected:
     SkTypeface* onMatchFamilyStyle(const char familyName[],
                                    const SkFontStyle& style) const override
     {
+        MatchKey key = MakeMatchKey(familyName, style, nullptr, 0, -1);
+        sk_sp<SkTypeface> typeface;
+        if (!this->findMatch(key, &typeface)) {
+            fFontConfigMatchCount++;
+            typeface = this->matchFamilyStyleUncached(familyName, style);
+            this->addMatch(key, typeface);
+        }
+        return typeface.release();
+    }
+
+    sk_sp<SkTypeface> matchFamilyStyleUncached(const char familyName[],
+                                               const SkFontStyle& style) const {
         SkAutoFcPattern font([this, &familyName, &style]() {
             FCLocker lock;
 
@@ -906,7 +1226,7 @@ protected:
             }
             return font;
         }());
-        return createTypefaceFromFcPattern(std::move(font)).release();
+        return createTypefaceFromFcPattern(std::move(font));
     }
 
     SkTypeface* onMatchFamilyStyleCharacter(const char familyName[],
@@ -915,6 +1235,22 @@ protected:
                                             int bcp47Count,
                                             SkUnichar character) const override
     {
+        MatchKey key = MakeMatchKey(familyName, style, bcp47, bcp47Count, character);
+        sk_sp<SkTypeface> typeface;
+        if (!this->findMatch(key, &typeface)) {
+            fFontConfigMatchCount++;
+            typeface = this->matchFamilyStyleCharacterUncached(familyName, style,
+                                                               bcp47, bcp47Count, character);
+            this->addMatch(key, typeface);
+        }
+        return typeface.release();
+    }
+
+    sk_sp<SkTypeface> matchFamilyStyleCharacterUncached(const char familyName[],
+                                                        const SkFontStyle& style,
+                                                        const char* bcp47[],
+                                                        int bcp47Count,
+                                                        SkUnichar character) const {
         SkAutoFcPattern font([&](){
             FCLocker lock;
 
@@ -950,7 +1286,7 @@ protected:
             }
             return font;
         }());
-        return createTypefaceFromFcPattern(std::move(font)).release();
+        return createTypefaceFromFcPattern(std::move(font));
     }
 
     sk_sp<SkTypeface> onMakeFromStreamIndex(std::unique_ptr<SkStreamAsset> stream,
@@ -1019,3 +1355,15 @@ protected:
 SK_API sk_sp<SkFontMgr> SkFontMgr_New_FontConfig(FcConfig* fc) {
     return sk_make_sp<SkFontMgr_fontconfig>(fc);
 }
+
+SK_API sk_sp<SkFontMgr> SkFontMgr_New_FontConfig(FcConfig* fc, const char snapshotPath[]) {
+    return sk_make_sp<SkFontMgr_fontconfig>(fc, snapshotPath);
+}
+
+SK_API bool SkFontMgr_FontConfig_WriteSnapshot(SkFontMgr* fontMgr) {
+    return static_cast<SkFontMgr_fontconfig*>(fontMgr)->writeSnapshot();
+}
+
+int SkFontMgr_FontConfig_CountFontConfigMatches(SkFontMgr* fontMgr) {
+    return static_cast<SkFontMgr_fontconfig*>(fontMgr)->fontConfigMatchCount();
+}
@@ -0,0 +1,19 @@
+/*
+ * Copyright 2026 Google LLC
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkFontMgr_fontconfig_priv_DEFINED
+#define SkFontMgr_fontconfig_priv_DEFINED
+
+class SkFontMgr;
+
+/** For testing: the number of matches the font manager made by asking FontConfig, as opposed
+ *  to finding them in its match cache or snapshot. The font manager must have been made by
+ *  SkFontMgr_New_FontConfig.
+ */
+int SkFontMgr_FontConfig_CountFontConfigMatches(SkFontMgr* fontMgr);
+
+#endif  // SkFontMgr_fontconfig_priv_DEFINED
@@ -18,14 +18,22 @@
 
 std::unique_ptr<SkCanvas> SkSVGCanvas::Make(const SkRect& bounds, SkWStream* writer,
                                             uint32_t flags) {
+    return Make(bounds, writer, flags, kDefaultPrecision);
+}
+
+std::unique_ptr<SkCanvas> SkSVGCanvas::Make(const SkRect& bounds, SkWStream* writer,
+                                            uint32_t flags, int precision) {
     // TODO: pass full bounds to the device
     const auto size = bounds.roundOut().size();
-    const auto xml_flags = (flags & kNoPrettyXML_Flag) ? SkToU32(SkXMLStreamWriter::kNoPretty_Flag)
-                                                       : 0;
+    auto xml_flags = (flags & kNoPrettyXML_Flag) ? SkToU32(SkXMLStreamWriter::kNoPretty_Flag)
+                                                 : 0;
+    if (flags & kCompact_Flag) {
+        xml_flags |= SkXMLStreamWriter::kBuffered_Flag;
+    }
 
     auto svgDevice = SkSVGDevice::Make(size,
                                        std::make_unique<SkXMLStreamWriter>(writer, xml_flags),
-                                       flags);
+                                       flags, precision);
 
     return svgDevice ? std::make_unique<SkCanvas>(std::move(svgDevice))
                      : nullptr;
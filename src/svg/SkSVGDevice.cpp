@@ -48,6 +48,8 @@
 #include "src/core/SkClipStack.h"
 #include "src/core/SkDevice.h"
 #include "src/core/SkFontPriv.h"
+#include "src/core/SkGeometry.h"
+#include "src/core/SkPathPriv.h"
 #include "src/core/SkTHash.h"
 #include "src/core/SkTLazy.h"
 #include "src/image/SkImage_Base.h"
@@ -55,6 +57,7 @@
 #include "src/text/GlyphRun.h"
 #include "src/xml/SkXMLWriter.h"
 
+#include <cmath>
 #include <cstring>
 #include <memory>
 #include <string>
@@ -234,6 +237,188 @@ void AddPath(const sktext::GlyphRun& glyphRun, const SkPoint& offset, SkPath* pa
             }, &rec);
 }
 
+// Writes SVG path data with coordinates rounded to a fixed number of decimals.  It works on
+// the rounded values as integers, so relative coordinates do not accumulate error, and it
+// picks the shortest command for each segment (h/v lines, s/t curves whose first control
+// point mirrors the previous one) and leaves out every separator and repeated command letter
+// that SVG allows.
+class CompactPathWriter {
+public:
+    static constexpr int kMaxPrecision = 6;
+
+    explicit CompactPathWriter(int precision)
+            : fPrecision(SkTPin(precision, 0, kMaxPrecision)) {
+        for (int i = 0; i < fPrecision; ++i) {
+            fScale *= 10;
+        }
+    }
+
+    SkString write(const SkPath& path) {
+        // Walk the raw verbs: SkPath::Iter would add the closing line before each 'z'.
+        for (auto [verb, pts, weight] : SkPathPriv::Iterate(path)) {
+            switch (verb) {
+                case SkPathVerb::kMove:
+                    this->moveTo(this->round(pts[0]));
+                    break;
+                case SkPathVerb::kLine:
+                    this->lineTo(this->round(pts[1]));
+                    break;
+                case SkPathVerb::kQuad:
+                    this->quadTo(this->round(pts[1]), this->round(pts[2]));
+                    break;
+                case SkPathVerb::kConic: {
+                    const SkScalar tol = SK_Scalar1 / 1024; // how close to a quad
+                    SkAutoConicToQuads quadder;
+                    const SkPoint* quadPts = quadder.computeQuads(pts, *weight, tol);
+                    for (int i = 0; i < quadder.countQuads(); ++i) {
+                        this->quadTo(this->round(quadPts[i*2 + 1]), this->round(quadPts[i*2 + 2]));
+                    }
+                } break;
+                case SkPathVerb::kCubic:
+                    this->cubicTo(this->round(pts[1]), this->round(pts[2]), this->round(pts[3]));
+                    break;
+                case SkPathVerb::kClose:
+                    this->command('z');
+                    fCurrent = fSubpathStart;
+                    fLastControl = Point();
+                    break;
+            }
+        }
+        return std::move(fOut);
+    }
+
+private:
+    struct Point {
+        int64_t fX = 0, fY = 0;
+        bool operator==(const Point& that) const { return fX == that.fX && fY == that.fY; }
+        Point operator-(const Point& that) const { return {fX - that.fX, fY - that.fY}; }
+    };
+
+    Point round(SkPoint p) const {
+        // Keep far out coordinates from overflowing; they are far off any viewport anyway.
+        constexpr double kLimit = 1e15;
+        return {std::llround(SkTPin((double)p.fX * fScale, -kLimit, kLimit)),
+                std::llround(SkTPin((double)p.fY * fScale, -kLimit, kLimit))};
+    }
+
+    void moveTo(Point p) {
+        // Relative to the origin at the start, so the same as absolute.  Coordinate pairs
+        // after a moveto are linetos, so 'l' can be left out right after it.
+        this->command('m');
+        this->point(p - fCurrent);
+        fLastCommand = 'l';
+        fCurrent = fSubpathStart = p;
+    }
+
+    void lineTo(Point p) {
+        Point d = p - fCurrent;
+        if (d.fY == 0) {
+            this->command('h');
+            this->number(d.fX);
+        } else if (d.fX == 0) {
+            this->command('v');
+            this->number(d.fY);
+        } else {
+            this->command('l');
+            this->point(d);
+        }
+        fCurrent = p;
+    }
+
+    void quadTo(Point c, Point p) {
+        if ((fLastCommand == 'q' || fLastCommand == 't') && c == this->reflectedControl()) {
+            this->command('t');
+        } else {
+            this->command('q');
+            this->point(c - fCurrent);
+        }
+        this->point(p - fCurrent);
+        fLastControl = c;
+        fCurrent = p;
+    }
+
+    void cubicTo(Point c1, Point c2, Point p) {
+        if ((fLastCommand == 'c' || fLastCommand == 's') && c1 == this->reflectedControl()) {
+            this->command('s');
+        } else {
+            this->command('c');
+            this->point(c1 - fCurrent);
+        }
+        this->point(c2 - fCurrent);
+        this->point(p - fCurrent);
+        fLastControl = c2;
+        fCurrent = p;
+    }
+
+    Point reflectedControl() const {
+        return {2 * fCurrent.fX - fLastControl.fX, 2 * fCurrent.fY - fLastControl.fY};
+    }
+
+    void command(char cmd) {
+        // A command letter may be left out when it repeats, except for moveto.
+        if (cmd != fLastCommand || cmd == 'm' || cmd == 'z') {
+            fOut.append(&cmd, 1);
+            fNeedSeparator = false;
+        }
+        fLastCommand = cmd;
+    }
+
+    void point(Point p) {
+        this->number(p.fX);
+        this->number(p.fY);
+    }
+
+    void number(int64_t value) {
+        char buffer[32];
+        char* end = buffer + sizeof(buffer);
+        char* start = end;
+        uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+        uint64_t integer = magnitude / fScale;
+        uint64_t fraction = magnitude % fScale;
+
+        bool hasFraction = fraction != 0;
+        if (hasFraction) {
+            int digits = fPrecision;
+            while (fraction % 10 == 0) {
+                fraction /= 10;
+                --digits;
+            }
+            for (; digits > 0; --digits) {
+                *--start = '0' + fraction % 10;
+                fraction /= 10;
+            }
+            *--start = '.';
+        }
+        if (integer != 0 || !hasFraction) {
+            do {
+                *--start = '0' + integer % 10;
+                integer /= 10;
+            } while (integer != 0);
+        }
+        if (value < 0) {
+            *--start = '-';
+        }
+
+        // A sign, or a point following a number that already has one, separates numbers.
+        if (fNeedSeparator && *start != '-' && !(*start == '.' && fLastHadPoint)) {
+            fOut.append(" ", 1);
+        }
+        fOut.append(start, end - start);
+        fNeedSeparator = true;
+        fLastHadPoint = hasFraction;
+    }
+
+    const int fPrecision;
+    int64_t fScale = 1;
+    SkString fOut;
+    Point fCurrent;
+    Point fSubpathStart;
+    Point fLastControl;
+    char fLastCommand = 0;
+    bool fNeedSeparator = false;
+    bool fLastHadPoint = false;
+};
+
 }  // namespace
 
 // For now all this does is serve unique serial IDs, but it will eventually evolve to track
@@ -265,7 +450,28 @@ public:
       return SkStringPrintf("pattern_%d", fPatternCount++);
     }
 
+    // Paints are written as attributes the first time they are seen.  The second time, the
+    // paint's CSS declarations get a class, defined by a <style> element written before that
+    // use, and it and every later use refer to the class.
+    SkString findOrAddPaintClass(const SkString& declarations, SkXMLWriter* writer) {
+        SkString* name = fPaintClasses.find(declarations);
+        if (!name) {
+            fPaintClasses.set(declarations, SkString());
+            return SkString();
+        }
+        if (name->isEmpty()) {
+            *name = SkStringPrintf("p%d", fPaintClassCount++);
+            SkString rule = SkStringPrintf(".%s{%s}", name->c_str(), declarations.c_str());
+            writer->startElement("style");
+            writer->addText(rule.c_str(), rule.size());
+            writer->endElement();
+        }
+        return *name;
+    }
+
 private:
+    SkTHashMap<SkString, SkString> fPaintClasses;
+    uint32_t fPaintClassCount = 0;
     uint32_t fGradientCount;
     uint32_t fPathCount;
     uint32_t fImageCount;
@@ -281,6 +487,78 @@ struct SkSVGDevice::MxCp {
     MxCp(SkSVGDevice* device) : fMatrix(&device->localToDevice()), fClipStack(&device->cs()) {}
 };
 
+// Presentation attributes of a paint, in the order they are written.
+using PaintAttributes = SkSTArray<8, std::pair<const char*, SkString>>;
+
+static void add_paint_attributes(const SkPaint& paint, const Resources& resources,
+                                 PaintAttributes* attributes) {
+    auto addAttribute = [attributes](const char name[], const SkString& value) {
+        attributes->push_back({name, value});
+    };
+    auto addScalarAttribute = [attributes](const char name[], SkScalar value) {
+        SkString str;
+        str.appendScalar(value);
+        attributes->push_back({name, std::move(str)});
+    };
+
+    // Path effects are applied to all vector graphics (rects, rrects, ovals,
+    // paths etc).  This should only happen when a path effect is attached to
+    // non-vector graphics (text, image) or a new vector graphics primitive is
+    //added that is not handled by base drawPath() routine.
+    if (paint.getPathEffect() != nullptr) {
+        SkDebugf("Unsupported path effect in addPaint.");
+    }
+    SkPaint::Style style = paint.getStyle();
+    if (style == SkPaint::kFill_Style || style == SkPaint::kStrokeAndFill_Style) {
+        static constexpr char kDefaultFill[] = "black";
+        if (!resources.fPaintServer.equals(kDefaultFill)) {
+            addAttribute("fill", resources.fPaintServer);
+
+            if (SK_AlphaOPAQUE != SkColorGetA(paint.getColor())) {
+                addScalarAttribute("fill-opacity", svg_opacity(paint.getColor()));
+            }
+        }
+    } else {
+        SkASSERT(style == SkPaint::kStroke_Style);
+        addAttribute("fill", SkString("none"));
+    }
+
+    if (!resources.fColorFilter.isEmpty()) {
+        addAttribute("filter", resources.fColorFilter);
+    }
+
+    if (style == SkPaint::kStroke_Style || style == SkPaint::kStrokeAndFill_Style) {
+        addAttribute("stroke", resources.fPaintServer);
+
+        SkScalar strokeWidth = paint.getStrokeWidth();
+        if (strokeWidth == 0) {
+            // Hairline stroke
+            strokeWidth = 1;
+            addAttribute("vector-effect", SkString("non-scaling-stroke"));
+        }
+        addScalarAttribute("stroke-width", strokeWidth);
+
+        if (const char* cap = svg_cap(paint.getStrokeCap())) {
+            addAttribute("stroke-linecap", SkString(cap));
+        }
+
+        if (const char* join = svg_join(paint.getStrokeJoin())) {
+            addAttribute("stroke-linejoin", SkString(join));
+        }
+
+        if (paint.getStrokeJoin() == SkPaint::kMiter_Join) {
+            addScalarAttribute("stroke-miterlimit", paint.getStrokeMiter());
+        }
+
+        if (SK_AlphaOPAQUE != SkColorGetA(paint.getColor())) {
+            addScalarAttribute("stroke-opacity", svg_opacity(paint.getColor()));
+        }
+    } else {
+        SkASSERT(style == SkPaint::kFill_Style);
+        // SVG default stroke value is "none".
+    }
+}
+
 class SkSVGDevice::AutoElement : ::SkNoncopyable {
 public:
     AutoElement(const char name[], SkXMLWriter* writer)
@@ -300,9 +578,27 @@ public:
         svgdev->syncClipStack(*mc.fClipStack);
         Resources res = this->addResources(mc, paint);
 
+        PaintAttributes paintAttributes;
+        add_paint_attributes(paint, res, &paintAttributes);
+        SkString paintClass;
+        if ((svgdev->fFlags & SkSVGCanvas::kCompact_Flag) && !paintAttributes.empty()) {
+            SkString declarations;
+            for (const auto& [attribute, value] : paintAttributes) {
+                declarations.appendf("%s%s:%s", declarations.isEmpty() ? "" : ";",
+                                     attribute, value.c_str());
+            }
+            paintClass = fResourceBucket->findOrAddPaintClass(declarations, fWriter);
+        }
+
         fWriter->startElement(name);
 
-        this->addPaint(paint, res);
+        if (!paintClass.isEmpty()) {
+            this->addAttribute("class", paintClass);
+        } else {
+            for (const auto& [attribute, value] : paintAttributes) {
+                this->addAttribute(attribute, value);
+            }
+        }
 
         if (!mc.fMatrix->isIdentity()) {
             this->addAttribute("transform", svg_transform(*mc.fMatrix));
@@ -334,7 +630,6 @@ public:
     }
 
     void addRectAttributes(const SkRect&);
-    void addPathAttributes(const SkPath&, SkParsePath::PathEncoding);
     void addTextAttributes(const SkFont&);
 
 private:
@@ -348,8 +643,6 @@ private:
 
     void addPatternDef(const SkBitmap& bm);
 
-    void addPaint(const SkPaint& paint, const Resources& resources);
-
     SkString addLinearGradientDef(const SkShaderBase::GradientInfo& info,
                                   const SkShader* shader,
                                   const SkMatrix& localMatrix);
@@ -358,65 +651,6 @@ private:
     ResourceBucket*            fResourceBucket;
 };
 
-void SkSVGDevice::AutoElement::addPaint(const SkPaint& paint, const Resources& resources) {
-    // Path effects are applied to all vector graphics (rects, rrects, ovals,
-    // paths etc).  This should only happen when a path effect is attached to
-    // non-vector graphics (text, image) or a new vector graphics primitive is
-    //added that is not handled by base drawPath() routine.
-    if (paint.getPathEffect() != nullptr) {
-        SkDebugf("Unsupported path effect in addPaint.");
-    }
-    SkPaint::Style style = paint.getStyle();
-    if (style == SkPaint::kFill_Style || style == SkPaint::kStrokeAndFill_Style) {
-        static constexpr char kDefaultFill[] = "black";
-        if (!resources.fPaintServer.equals(kDefaultFill)) {
-            this->addAttribute("fill", resources.fPaintServer);
-
-            if (SK_AlphaOPAQUE != SkColorGetA(paint.getColor())) {
-                this->addAttribute("fill-opacity", svg_opacity(paint.getColor()));
-            }
-        }
-    } else {
-        SkASSERT(style == SkPaint::kStroke_Style);
-        this->addAttribute("fill", "none");
-    }
-
-    if (!resources.fColorFilter.isEmpty()) {
-        this->addAttribute("filter", resources.fColorFilter.c_str());
-    }
-
-    if (style == SkPaint::kStroke_Style || style == SkPaint::kStrokeAndFill_Style) {
-        this->addAttribute("stroke", resources.fPaintServer);
-
-        SkScalar strokeWidth = paint.getStrokeWidth();
-        if (strokeWidth == 0) {
-            // Hairline stroke
-            strokeWidth = 1;
-            this->addAttribute("vector-effect", "non-scaling-stroke");
-        }
-        this->addAttribute("stroke-width", strokeWidth);
-
-        if (const char* cap = svg_cap(paint.getStrokeCap())) {
-            this->addAttribute("stroke-linecap", cap);
-        }
-
-        if (const char* join = svg_join(paint.getStrokeJoin())) {
-            this->addAttribute("stroke-linejoin", join);
-        }
-
-        if (paint.getStrokeJoin() == SkPaint::kMiter_Join) {
-            this->addAttribute("stroke-miterlimit", paint.getStrokeMiter());
-        }
-
-        if (SK_AlphaOPAQUE != SkColorGetA(paint.getColor())) {
-            this->addAttribute("stroke-opacity", svg_opacity(paint.getColor()));
-        }
-    } else {
-        SkASSERT(style == SkPaint::kFill_Style);
-        // SVG default stroke value is "none".
-    }
-}
-
 Resources SkSVGDevice::AutoElement::addResources(const MxCp& mc, const SkPaint& paint) {
     Resources resources(paint);
 
@@ -667,10 +901,6 @@ void SkSVGDevice::AutoElement::addRectAttributes(const SkRect& rect) {
     this->addAttribute("height", rect.height());
 }
 
-void SkSVGDevice::AutoElement::addPathAttributes(const SkPath& path,
-                                                 SkParsePath::PathEncoding encoding) {
-    this->addAttribute("d", SkParsePath::ToSVGString(path, encoding));
-}
 
 void SkSVGDevice::AutoElement::addTextAttributes(const SkFont& font) {
     this->addAttribute("font-size", font.getSize());
@@ -720,17 +950,20 @@ void SkSVGDevice::AutoElement::addTextAttributes(const SkFont& font) {
 }
 
 sk_sp<SkBaseDevice> SkSVGDevice::Make(const SkISize& size, std::unique_ptr<SkXMLWriter> writer,
-                                      uint32_t flags) {
-    return writer ? sk_sp<SkBaseDevice>(new SkSVGDevice(size, std::move(writer), flags))
+                                      uint32_t flags, int precision) {
+    return writer ? sk_sp<SkBaseDevice>(new SkSVGDevice(size, std::move(writer), flags,
+                                                        precision))
                   : nullptr;
 }
 
-SkSVGDevice::SkSVGDevice(const SkISize& size, std::unique_ptr<SkXMLWriter> writer, uint32_t flags)
+SkSVGDevice::SkSVGDevice(const SkISize& size, std::unique_ptr<SkXMLWriter> writer, uint32_t flags,
+                         int precision)
     : INHERITED(SkImageInfo::MakeUnknown(size.fWidth, size.fHeight),
                 SkSurfaceProps(0, kUnknown_SkPixelGeometry))
     , fWriter(std::move(writer))
     , fResourceBucket(new ResourceBucket)
     , fFlags(flags)
+    , fPrecision(SkTPin(precision, 0, CompactPathWriter::kMaxPrecision))
 {
     SkASSERT(fWriter);
 
@@ -752,10 +985,21 @@ SkSVGDevice::~SkSVGDevice() {
     }
 }
 
-SkParsePath::PathEncoding SkSVGDevice::pathEncoding() const {
-    return (fFlags & SkSVGCanvas::kRelativePathEncoding_Flag)
-        ? SkParsePath::PathEncoding::Relative
-        : SkParsePath::PathEncoding::Absolute;
+SkString SkSVGDevice::pathData(const SkPath& path) const {
+    if (fFlags & SkSVGCanvas::kCompact_Flag) {
+        return CompactPathWriter(fPrecision).write(path);
+    }
+    return SkParsePath::ToSVGString(path, (fFlags & SkSVGCanvas::kRelativePathEncoding_Flag)
+                                                  ? SkParsePath::PathEncoding::Relative
+                                                  : SkParsePath::PathEncoding::Absolute);
+}
+
+SkScalar SkSVGDevice::quantize(SkScalar v) const {
+    if (!(fFlags & SkSVGCanvas::kCompact_Flag)) {
+        return v;
+    }
+    const double scale = std::pow(10.0, fPrecision);
+    return static_cast<SkScalar>(std::round(v * scale) / scale);
 }
 
 void SkSVGDevice::syncClipStack(const SkClipStack& cs) {
@@ -807,7 +1051,7 @@ void SkSVGDevice::syncClipStack(const SkClipStack& cs) {
         case SkClipStack::Element::DeviceSpaceType::kPath: {
             const auto& p = e->getDeviceSpacePath();
             AutoElement path("path", fWriter);
-            path.addPathAttributes(p, this->pathEncoding());
+            path.addAttribute("d", this->pathData(p));
             if (p.getFillType() == SkPathFillType::kEvenOdd) {
                 path.addAttribute("clip-rule", "evenodd");
             }
@@ -906,21 +1150,23 @@ void SkSVGDevice::drawRect(const SkRect& r, const SkPaint& paint) {
       rect.addAttribute("width", "100%");
       rect.addAttribute("height", "100%");
     } else {
-      rect.addRectAttributes(r);
+      rect.addRectAttributes(SkRect::MakeLTRB(this->quantize(r.fLeft), this->quantize(r.fTop),
+                                              this->quantize(r.fRight),
+                                              this->quantize(r.fBottom)));
     }
 }
 
 void SkSVGDevice::drawOval(const SkRect& oval, const SkPaint& paint) {
     AutoElement ellipse("ellipse", this, fResourceBucket.get(), MxCp(this), paint);
-    ellipse.addAttribute("cx", oval.centerX());
-    ellipse.addAttribute("cy", oval.centerY());
-    ellipse.addAttribute("rx", oval.width() / 2);
-    ellipse.addAttribute("ry", oval.height() / 2);
+    ellipse.addAttribute("cx", this->quantize(oval.centerX()));
+    ellipse.addAttribute("cy", this->quantize(oval.centerY()));
+    ellipse.addAttribute("rx", this->quantize(oval.width() / 2));
+    ellipse.addAttribute("ry", this->quantize(oval.height() / 2));
 }
 
 void SkSVGDevice::drawRRect(const SkRRect& rr, const SkPaint& paint) {
     AutoElement elem("path", this, fResourceBucket.get(), MxCp(this), paint);
-    elem.addPathAttributes(SkPath::RRect(rr), this->pathEncoding());
+    elem.addAttribute("d", this->pathData(SkPath::RRect(rr)));
 }
 
 void SkSVGDevice::drawPath(const SkPath& path, const SkPaint& paint, bool pathIsMutable) {
@@ -953,7 +1199,7 @@ void SkSVGDevice::drawPath(const SkPath& path, const SkPaint& paint, bool pathIs
 
     // Create path element.
     AutoElement elem("path", this, fResourceBucket.get(), MxCp(this), *path_paint);
-    elem.addPathAttributes(*pathPtr, this->pathEncoding());
+    elem.addAttribute("d", this->pathData(*pathPtr));
 
     // TODO: inverse fill types?
     if (pathPtr->getFillType() == SkPathFillType::kEvenOdd) {
@@ -13,6 +13,7 @@
 #include "include/core/SkTypes.h"
 #include "include/private/base/SkTArray.h"
 #include "include/private/base/SkTypeTraits.h"
+#include "include/svg/SkSVGCanvas.h"
 #include "include/utils/SkParsePath.h"
 #include "src/core/SkClipStackDevice.h"
 
@@ -47,7 +48,8 @@ class SkMesh;
 class SkSVGDevice final : public SkClipStackDevice {
 public:
     static sk_sp<SkBaseDevice> Make(const SkISize& size, std::unique_ptr<SkXMLWriter>,
-                                    uint32_t flags);
+                                    uint32_t flags,
+                                    int precision = SkSVGCanvas::kDefaultPrecision);
 
 protected:
     void drawPaint(const SkPaint& paint) override;
@@ -73,7 +75,7 @@ protected:
     void drawMesh(const SkMesh&, sk_sp<SkBlender>, const SkPaint&) override;
 #endif
 private:
-    SkSVGDevice(const SkISize& size, std::unique_ptr<SkXMLWriter>, uint32_t);
+    SkSVGDevice(const SkISize& size, std::unique_ptr<SkXMLWriter>, uint32_t, int precision);
     ~SkSVGDevice() override;
 
     struct MxCp;
@@ -81,7 +83,9 @@ private:
 
     void syncClipStack(const SkClipStack&);
 
-    SkParsePath::PathEncoding pathEncoding() const;
+    SkString pathData(const SkPath&) const;
+    // Rounds to fPrecision decimals in compact mode.
+    SkScalar quantize(SkScalar) const;
 
     class AutoElement;
     class ResourceBucket;
@@ -89,6 +93,7 @@ private:
     const std::unique_ptr<SkXMLWriter>    fWriter;
     const std::unique_ptr<ResourceBucket> fResourceBucket;
     const uint32_t                        fFlags;
+    const int                             fPrecision;
 
     struct ClipRec {
         std::unique_ptr<AutoElement> fClipPathElem;
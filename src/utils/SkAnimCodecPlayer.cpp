@@ -13,6 +13,7 @@
 #include "include/core/SkBlendMode.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMatrix.h"
@@ -33,6 +34,7 @@ SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec) : fCodec(st
     fImageInfo = fCodec->getInfo();
     fFrameInfos = fCodec->getFrameInfo();
     fImages.resize(fFrameInfos.size());
+    fLastUsed.resize(fFrameInfos.size());
 
     // change the interpretation of fDuration to a end-time for that frame
     size_t dur = 0;
@@ -51,10 +53,13 @@ SkAnimCodecPlayer::SkAnimCodecPlayer(std::unique_ptr<SkCodec> codec) : fCodec(st
     }
 }
 
-SkAnimCodecPlayer::~SkAnimCodecPlayer() {}
+SkAnimCodecPlayer::~SkAnimCodecPlayer() {
+    this->waitForDecodeAhead();
+}
 
 SkISize SkAnimCodecPlayer::dimensions() const {
     if (!fCodec) {
+        SkAutoMutexExclusive lock(fMutex);
         auto image = fImages.front();
         return image ? image->dimensions() : SkISize::MakeEmpty();
     }
@@ -68,6 +73,7 @@ sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
     SkASSERT((unsigned)index < fFrameInfos.size());
 
     if (fImages[index]) {
+        fLastUsed[index] = ++fUseCounter;
         return fImages[index];
     }
 
@@ -125,15 +131,102 @@ sk_sp<SkImage> SkAnimCodecPlayer::getFrameAt(int index) {
         canvas->drawImage(image, 0, 0, SkSamplingOptions(), &paint);
         image = SkImage::MakeRasterData(imageInfo, std::move(data), rb);
     }
-    return fImages[index] = image;
+    fImages[index] = image;
+    fLastUsed[index] = ++fUseCounter;
+    fStats.fCacheBytes += imageInfo.computeByteSize(rb);
+    this->purgeToBudget(index);
+    return image;
+}
+
+void SkAnimCodecPlayer::purgeToBudget(int keepIndex) {
+    while (fCacheBudget && fStats.fCacheBytes > fCacheBudget) {
+        // Linear scan; animations rarely have more than a few hundred frames.
+        int victim = -1;
+        for (int i = 0; i < (int)fImages.size(); i++) {
+            if (i != keepIndex && i != fCurrIndex && fImages[i] &&
+                    (victim < 0 || fLastUsed[i] < fLastUsed[victim])) {
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            break;
+        }
+        fStats.fCacheBytes -= fImages[victim]->imageInfo().computeMinByteSize();
+        fStats.fEvicted++;
+        fImages[victim] = nullptr;
+    }
 }
 
 sk_sp<SkImage> SkAnimCodecPlayer::getFrame() {
+    SkAutoMutexExclusive lock(fMutex);
     SkASSERT(fTotalDuration > 0 || fImages.size() == 1);
 
-    return fTotalDuration > 0
-        ? this->getFrameAt(fCurrIndex)
-        : fImages.front();
+    if (!fTotalDuration) {
+        return fImages.front();
+    }
+    if (fImages[fCurrIndex]) {
+        fStats.fHits++;
+    } else {
+        fStats.fMisses++;
+    }
+    return this->getFrameAt(fCurrIndex);
+}
+
+void SkAnimCodecPlayer::setFrameCacheBudget(size_t bytes) {
+    SkAutoMutexExclusive lock(fMutex);
+    fCacheBudget = bytes;
+    this->purgeToBudget(fCurrIndex);
+}
+
+void SkAnimCodecPlayer::setDecodeAhead(SkExecutor* executor, int depth) {
+    if (!executor || depth <= 0) {
+        this->waitForDecodeAhead();
+        executor = nullptr;
+        depth = 0;
+    }
+    fExecutor = executor;
+    fDecodeAhead = depth;
+    this->scheduleDecodeAhead();
+}
+
+SkAnimCodecPlayer::CacheStats SkAnimCodecPlayer::cacheStats() const {
+    SkAutoMutexExclusive lock(fMutex);
+    return fStats;
+}
+
+void SkAnimCodecPlayer::waitForDecodeAhead() {
+    if (fDecodeAheadPending) {
+        fDecodeAheadDone.wait();
+        fDecodeAheadPending = false;
+    }
+}
+
+void SkAnimCodecPlayer::scheduleDecodeAhead() {
+    if (!fExecutor || !fTotalDuration) {
+        return;
+    }
+    // Only one batch is in flight at a time. If the previous one is still running, skip this
+    // round rather than queueing work for frames that may already be out of date.
+    if (fDecodeAheadPending) {
+        if (!fDecodeAheadDone.try_wait()) {
+            return;
+        }
+        fDecodeAheadPending = false;
+    }
+
+    const int start = fCurrIndex,
+              count = std::min<int>(fDecodeAhead, (int)fFrameInfos.size() - 1);
+    fDecodeAheadPending = true;
+    fExecutor->add([this, start, count] {
+        for (int i = 1; i <= count; i++) {
+            const int index = (start + i) % (int)fFrameInfos.size();
+            SkAutoMutexExclusive lock(fMutex);
+            if (!fImages[index] && this->getFrameAt(index)) {
+                fStats.fPrefetched++;
+            }
+        }
+        fDecodeAheadDone.signal();
+    });
 }
 
 bool SkAnimCodecPlayer::seek(uint32_t msec) {
@@ -148,8 +241,16 @@ bool SkAnimCodecPlayer::seek(uint32_t msec) {
                                       return (uint32_t)info.fDuration <= msec;
                                   });
     int prevIndex = fCurrIndex;
-    fCurrIndex = lower - fFrameInfos.begin();
-    return fCurrIndex != prevIndex;
+    {
+        // Decode-ahead reads fCurrIndex while purging.
+        SkAutoMutexExclusive lock(fMutex);
+        fCurrIndex = lower - fFrameInfos.begin();
+    }
+    if (fCurrIndex == prevIndex) {
+        return false;
+    }
+    this->scheduleDecodeAhead();
+    return true;
 }
 
 
@@ -7,6 +7,8 @@
 
 #include "src/utils/SkCharToGlyphCache.h"
 
+#include <cstring>
+
 SkCharToGlyphCache::SkCharToGlyphCache() {
     this->reset();
 }
@@ -14,6 +16,10 @@ SkCharToGlyphCache::SkCharToGlyphCache() {
 SkCharToGlyphCache::~SkCharToGlyphCache() {}
 
 void SkCharToGlyphCache::reset() {
+    // fLatin1 is only read where fLatin1Known has the bit set, so it is left as is.
+    memset(fLatin1Known, 0, sizeof(fLatin1Known));
+    fLatin1Count = 0;
+
     fK32.reset();
     fV16.reset();
 
@@ -92,7 +98,7 @@ static int find_with_slope(const SkUnichar base[], int count, SkUnichar value, d
     return index;
 }
 
-int SkCharToGlyphCache::findGlyphIndex(SkUnichar unichar) const {
+int SkCharToGlyphCache::findGlyphIndexInSorted(SkUnichar unichar) const {
     const int count = fK32.size();
     int index;
     if (count <= kSmallCountLimit) {
@@ -107,6 +113,14 @@ int SkCharToGlyphCache::findGlyphIndex(SkUnichar unichar) const {
 }
 
 void SkCharToGlyphCache::insertCharAndGlyph(int index, SkUnichar unichar, SkGlyphID glyph) {
+    if ((uint32_t)unichar < kLatin1Count) {
+        SkASSERT(!this->hasLatin1(unichar));
+        fLatin1[unichar] = glyph;
+        fLatin1Known[unichar >> 5] |= 1u << (unichar & 31);
+        fLatin1Count += 1;
+        return;
+    }
+
     SkASSERT(fK32.size() == fV16.size());
     SkASSERT(index < fK32.size());
     SkASSERT(unichar < fK32[index]);
@@ -21,7 +21,7 @@ public:
 
     // return number of unichars cached
     int count() const {
-        return fK32.size();
+        return fK32.size() + fLatin1Count;
     }
 
     void reset();       // forget all cache entries (to save memory)
@@ -37,12 +37,21 @@ public:
      *      glyphID = compute_glyph_using_typeface(unichar);
      *      cache.insertCharAndGlyph(~result, unichar, glyphID);
      *  }
+     *
+     *  Latin-1 unichars are looked up in a direct-mapped table, which is what most text hits, so
+     *  the index returned for them is not meaningful beyond being negative.
      */
-    int findGlyphIndex(SkUnichar c) const;
+    int findGlyphIndex(SkUnichar c) const {
+        if ((uint32_t)c < kLatin1Count) {
+            return this->hasLatin1(c) ? fLatin1[c] : ~0;
+        }
+        return this->findGlyphIndexInSorted(c);
+    }
 
     /**
      *  Insert a new char/glyph pair into the cache at the specified index.
      *  See charToGlyph() for how to compute the bit-not of the index.
+     *  The index is ignored for Latin-1 unichars.
      */
     void insertCharAndGlyph(int index, SkUnichar, SkGlyphID);
 
@@ -57,6 +66,18 @@ public:
     }
 
 private:
+    static constexpr uint32_t kLatin1Count = 256;
+
+    bool hasLatin1(SkUnichar c) const {
+        return (fLatin1Known[c >> 5] >> (c & 31)) & 1;
+    }
+
+    int findGlyphIndexInSorted(SkUnichar c) const;
+
+    SkGlyphID            fLatin1[kLatin1Count];
+    uint32_t             fLatin1Known[kLatin1Count / 32];
+    int                  fLatin1Count;
+
     SkTDArray<int32_t>   fK32;
     SkTDArray<uint16_t>  fV16;
     double               fDenom;
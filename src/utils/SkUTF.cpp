@@ -5,6 +5,9 @@
 
 #include "include/private/base/SkTFitsIn.h"
 
+#include <algorithm>
+#include <cstring>
+
 static constexpr inline int32_t left_shift(int32_t value, int32_t shift) {
     return (int32_t) ((uint32_t) value << shift);
 }
@@ -42,6 +45,25 @@ static bool utf8_type_is_valid_leading_byte(int type) { return type > 0; }
 
 static bool utf8_byte_is_continuation(uint8_t c) { return utf8_byte_type(c) == 0; }
 
+/** @returns the end of the run of ASCII bytes starting at utf8.
+    The bytes are checked eight at a time, which is where most of the time goes for Latin text.
+*/
+static const char* utf8_skip_ascii(const char* utf8, const char* stop) {
+    constexpr uint64_t kHighBits = 0x8080808080808080;
+    while (stop - utf8 >= 8) {
+        uint64_t bytes;
+        memcpy(&bytes, utf8, sizeof(bytes));
+        if (bytes & kHighBits) {
+            break;
+        }
+        utf8 += 8;
+    }
+    while (utf8 < stop && *(const uint8_t*)utf8 < 0x80) {
+        ++utf8;
+    }
+    return utf8;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 int SkUTF::CountUTF8(const char* utf8, size_t byteLength) {
@@ -51,6 +73,12 @@ int SkUTF::CountUTF8(const char* utf8, size_t byteLength) {
     int count = 0;
     const char* stop = utf8 + byteLength;
     while (utf8 < stop) {
+        if (*(const uint8_t*)utf8 < 0x80) {
+            const char* run = utf8;
+            utf8 = utf8_skip_ascii(utf8, stop);
+            count += utf8 - run;
+            continue;
+        }
         int type = utf8_byte_type(*(const uint8_t*)utf8);
         if (!utf8_type_is_valid_leading_byte(type) || utf8 + type > stop) {
             return -1;  // Sequence extends beyond end.
@@ -283,6 +311,41 @@ int SkUTF::UTF8ToUTF16(uint16_t dst[], int dstCapacity, const char src[], size_t
     return dstLength;
 }
 
+int SkUTF::UTF8ToUTF32(SkUnichar dst[], int dstCapacity, const char src[], size_t srcByteLength) {
+    if (!src && srcByteLength) {
+        return -1;
+    }
+    if (!dst) {
+        dstCapacity = 0;
+    }
+
+    int dstLength = 0;
+    const char* endSrc = src + srcByteLength;
+    while (src < endSrc) {
+        if (*(const uint8_t*)src < 0x80) {
+            const char* run = src;
+            src = utf8_skip_ascii(src, endSrc);
+            const int runLength = (int)(src - run);
+            const int fits = std::min(runLength, std::max(dstCapacity - dstLength, 0));
+            for (int i = 0; i < fits; ++i) {
+                dst[dstLength + i] = (uint8_t)run[i];
+            }
+            dstLength += runLength;
+            continue;
+        }
+
+        SkUnichar uni = NextUTF8(&src, endSrc);
+        if (uni < 0) {
+            return -1;
+        }
+        if (dstLength < dstCapacity) {
+            dst[dstLength] = uni;
+        }
+        dstLength += 1;
+    }
+    return dstLength;
+}
+
 int SkUTF::UTF16ToUTF8(char dst[], int dstCapacity, const uint16_t src[], size_t srcLength) {
     if (!dst) {
         dstCapacity = 0;
@@ -196,27 +196,54 @@ SkXMLStreamWriter::SkXMLStreamWriter(SkWStream* stream, uint32_t flags)
 
 SkXMLStreamWriter::~SkXMLStreamWriter() {
     this->flush();
+    this->flushBuffer();
+}
+
+// Elements and attributes are written a few bytes at a time, which costs a virtual call
+// or more per write into the stream.
+static constexpr size_t kStreamBufferSize = 32 * 1024;
+
+void SkXMLStreamWriter::write(const char text[], size_t length) {
+    if (!(fFlags & kBuffered_Flag)) {
+        fStream.write(text, length);
+        return;
+    }
+    if (fBuffer.size() + length > kStreamBufferSize) {
+        this->flushBuffer();
+        if (length > kStreamBufferSize) {
+            fStream.write(text, length);
+            return;
+        }
+    }
+    fBuffer.append(SkToInt(length), text);
+}
+
+void SkXMLStreamWriter::flushBuffer() {
+    if (!fBuffer.empty()) {
+        fStream.write(fBuffer.begin(), fBuffer.size());
+        fBuffer.clear();
+    }
 }
 
 void SkXMLStreamWriter::onAddAttributeLen(const char name[], const char value[], size_t length) {
     SkASSERT(!fElems.back()->fHasChildren && !fElems.back()->fHasText);
-    fStream.writeText(" ");
-    fStream.writeText(name);
-    fStream.writeText("=\"");
-    fStream.write(value, length);
-    fStream.writeText("\"");
+    this->writeText(" ");
+    this->writeText(name);
+    this->writeText("=\"");
+    this->write(value, length);
+    this->writeText("\"");
 }
 
 void SkXMLStreamWriter::onAddText(const char text[], size_t length) {
     Elem* elem = fElems.back();
 
     if (!elem->fHasChildren && !elem->fHasText) {
-        fStream.writeText(">");
+        this->writeText(">");
         this->newline();
     }
 
     this->tab(fElems.size() + 1);
-    fStream.write(text, length);
+    this->write(text, length);
     this->newline();
 }
 
@@ -224,11 +251,11 @@ void SkXMLStreamWriter::onEndElement() {
     Elem* elem = getEnd();
     if (elem->fHasChildren || elem->fHasText) {
         this->tab(fElems.size());
-        fStream.writeText("</");
-        fStream.writeText(elem->fName.c_str());
-        fStream.writeText(">");
+        this->writeText("</");
+        this->writeText(elem->fName.c_str());
+        this->writeText(">");
     } else {
-        fStream.writeText("/>");
+        this->writeText("/>");
     }
     this->newline();
     doEnd(elem);
@@ -238,31 +265,31 @@ void SkXMLStreamWriter::onStartElementLen(const char name[], size_t length) {
     int level = fElems.size();
     if (this->doStart(name, length)) {
         // the first child, need to close with >
-        fStream.writeText(">");
+        this->writeText(">");
         this->newline();
     }
 
     this->tab(level);
-    fStream.writeText("<");
-    fStream.write(name, length);
+    this->writeText("<");
+    this->write(name, length);
 }
 
 void SkXMLStreamWriter::writeHeader() {
     const char* header = getHeader();
-    fStream.write(header, strlen(header));
+    this->write(header, strlen(header));
     this->newline();
 }
 
 void SkXMLStreamWriter::newline() {
     if (!(fFlags & kNoPretty_Flag)) {
-        fStream.newline();
+        this->write("\n", 1);
     }
 }
 
 void SkXMLStreamWriter::tab(int level) {
     if (!(fFlags & kNoPretty_Flag)) {
         for (int i = 0; i < level; i++) {
-            fStream.writeText("\t");
+            this->writeText("\t");
         }
     }
 }
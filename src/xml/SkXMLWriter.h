@@ -65,6 +65,7 @@ class SkXMLStreamWriter : public SkXMLWriter {
 public:
     enum : uint32_t {
         kNoPretty_Flag = 0x01,
+        kBuffered_Flag = 0x02,  // write to the stream in large blocks; complete once destroyed
     };
 
     SkXMLStreamWriter(SkWStream*, uint32_t flags = 0);
@@ -80,9 +81,13 @@ protected:
 private:
     void newline();
     void tab(int lvl);
+    void write(const char text[], size_t length);
+    void writeText(const char text[]) { this->write(text, strlen(text)); }
+    void flushBuffer();
 
     SkWStream&      fStream;
     const uint32_t  fFlags;
+    SkTDArray<char> fBuffer;
 };
 
 class SkXMLParserWriter : public SkXMLWriter {
@@ -7,6 +7,7 @@
 
 #include "include/codec/SkAndroidCodec.h"
 #include "include/codec/SkCodec.h"
+#include "include/core/SkBitmap.h"
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
@@ -238,3 +239,77 @@ DEF_TEST(AndroidCodec_xmpMetadata, r) {
         }
     }
 }
+
+DEF_TEST(AndroidCodec_areaAverage, r) {
+    auto data = GetResourceAsData("images/mandrill_512.png");
+    if (!data) {
+        return;
+    }
+
+    // Decode at full size to compute the expected box-filtered result by hand.
+    auto full = SkAndroidCodec::MakeFromData(data);
+    if (!full) {
+        ERRORF(r, "Failed to create a codec");
+        return;
+    }
+    const SkImageInfo fullInfo = full->getInfo().makeColorType(kRGBA_8888_SkColorType)
+                                                .makeAlphaType(kPremul_SkAlphaType);
+    SkBitmap fullBm;
+    fullBm.allocPixels(fullInfo);
+    REPORTER_ASSERT(r, SkCodec::kSuccess == full->getAndroidPixels(fullInfo, fullBm.getPixels(),
+                                                                   fullBm.rowBytes()));
+
+    // A size that is not an integer fraction of 512 exercises uneven spans.
+    for (SkISize size : { SkISize{100, 77}, SkISize{256, 256}, SkISize{1, 1} }) {
+        auto codec = SkAndroidCodec::MakeFromData(data);
+        const SkImageInfo info = fullInfo.makeDimensions(size);
+        SkBitmap bm;
+        bm.allocPixels(info);
+
+        SkAndroidCodec::AndroidOptions options;
+        options.fDownsample = SkAndroidCodec::AndroidOptions::Downsample::kAreaAverage;
+        auto result = codec->getAndroidPixels(info, bm.getPixels(), bm.rowBytes(), &options);
+        if (result != SkCodec::kSuccess) {
+            ERRORF(r, "Area-average decode to %dx%d failed: %s", size.width(), size.height(),
+                   SkCodec::ResultToString(result));
+            continue;
+        }
+
+        for (int y = 0; y < size.height(); y++) {
+            const int top    = y       * fullInfo.height() / size.height(),
+                      bottom = (y + 1) * fullInfo.height() / size.height();
+            for (int x = 0; x < size.width(); x++) {
+                const int left  = x       * fullInfo.width() / size.width(),
+                          right = (x + 1) * fullInfo.width() / size.width();
+                const uint32_t area = (right - left) * (bottom - top);
+                for (int c = 0; c < 4; c++) {
+                    uint32_t sum = 0;
+                    for (int sy = top; sy < bottom; sy++) {
+                        for (int sx = left; sx < right; sx++) {
+                            sum += ((const uint8_t*)fullBm.getAddr32(sx, sy))[c];
+                        }
+                    }
+                    const uint8_t expected = (uint8_t)((sum + area / 2) / area),
+                                  actual   = ((const uint8_t*)bm.getAddr32(x, y))[c];
+                    if (expected != actual) {
+                        ERRORF(r, "Mismatch at (%d, %d) channel %d for %dx%d: %u vs %u",
+                               x, y, c, size.width(), size.height(), actual, expected);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    // An empty destination has no valid scale (and must not divide by zero).
+    for (SkISize size : { SkISize{0, 77}, SkISize{100, 0} }) {
+        auto codec = SkAndroidCodec::MakeFromData(data);
+        const SkImageInfo info = fullInfo.makeDimensions(size);
+        uint32_t pixel;
+        SkAndroidCodec::AndroidOptions options;
+        options.fDownsample = SkAndroidCodec::AndroidOptions::Downsample::kAreaAverage;
+        auto result = codec->getAndroidPixels(info, &pixel, info.minRowBytes(), &options);
+        REPORTER_ASSERT(r, result == SkCodec::kInvalidScale, "%dx%d: %s",
+                        size.width(), size.height(), SkCodec::ResultToString(result));
+    }
+}
@@ -13,6 +13,7 @@
 #include "include/core/SkBitmap.h"
 #include "include/core/SkColorType.h"
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMatrix.h"
@@ -626,3 +627,41 @@ DEF_TEST(AnimCodecPlayer, r) {
                         "Mismatched size for frame at 500 ms of %s", test.fFile);
     }
 }
+
+DEF_TEST(AnimCodecPlayer_decodeAhead, r) {
+    auto data = GetResourceAsData("images/alphabetAnim.gif");
+    if (!data) {
+        return;
+    }
+
+    SkAnimCodecPlayer reference(SkCodec::MakeFromData(data));
+    SkAnimCodecPlayer player(SkCodec::MakeFromData(data));
+
+    const SkISize dims = player.dimensions();
+    const size_t frameBytes = SkImageInfo::MakeN32Premul(dims).computeMinByteSize();
+    player.setFrameCacheBudget(2 * frameBytes);
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(1);
+    player.setDecodeAhead(executor.get(), 3);
+
+    int getFrameCalls = 0;
+    for (uint32_t msec = 0; msec < 2 * player.duration(); msec += 50) {
+        reference.seek(msec);
+        player.seek(msec);
+        auto expected = reference.getFrame(),
+             actual   = player.getFrame();
+        getFrameCalls++;
+        if (!expected || !actual) {
+            ERRORF(r, "Failed to decode frame at %u ms", msec);
+            return;
+        }
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected.get(), actual.get()),
+                        "Frame at %u ms differs with decode-ahead", msec);
+    }
+    player.setDecodeAhead(nullptr, 0);
+
+    const auto stats = player.cacheStats();
+    REPORTER_ASSERT(r, stats.fHits + stats.fMisses == getFrameCalls);
+    REPORTER_ASSERT(r, stats.fEvicted > 0);
+    REPORTER_ASSERT(r, stats.fCacheBytes <= 2 * frameBytes);
+}
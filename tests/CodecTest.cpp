@@ -1939,3 +1939,47 @@ DEF_TEST(Codec_noConversion, r) {
         REPORTER_ASSERT(r, bm.getColor(0, 0) == rec.color);
     }
 }
+
+DEF_TEST(Codec_ProbeInfo, r) {
+    for (const char* path : { "images/mandrill_512_q075.jpg",
+                              "images/color_wheel.png",
+                              "images/color_wheel.webp",
+                              "images/color_wheel.gif",
+                              "images/wide_gamut_yellow_224_224_64.jpeg",
+                              "images/stoplight.webp",
+                              "images/orientation/6_420.jpg",
+                              "images/orientation/8_444.jpg",
+                              "images/orientation/5.webp",
+                              "images/orientation/7.webp" }) {
+        auto data = GetResourceAsData(path);
+        if (!data) {
+            continue;
+        }
+        auto codec = SkCodec::MakeFromData(data);
+        if (!codec) {
+            // The format is not compiled in; ProbeInfo should not claim to support it either.
+            SkCodec::ProbeResult probe;
+            REPORTER_ASSERT(r, !SkCodec::ProbeInfo(data->data(), data->size(), &probe), "%s",
+                            path);
+            continue;
+        }
+
+        SkCodec::ProbeResult probe;
+        if (!SkCodec::ProbeInfo(data->data(), data->size(), &probe)) {
+            ERRORF(r, "Failed to probe %s", path);
+            continue;
+        }
+        REPORTER_ASSERT(r, probe.fFormat == codec->getEncodedFormat(), "%s", path);
+        REPORTER_ASSERT(r, probe.fDimensions == codec->dimensions(), "%s", path);
+        REPORTER_ASSERT(r, probe.fOrigin == codec->getOrigin(), "%s", path);
+        if (probe.fICCProfile) {
+            skcms_ICCProfile profile;
+            REPORTER_ASSERT(r, skcms_Parse(probe.fICCProfile, probe.fICCProfileSize, &profile),
+                            "%s", path);
+        }
+
+        // Headers cut short must fail rather than read past the end.
+        SkCodec::ProbeResult truncated;
+        REPORTER_ASSERT(r, !SkCodec::ProbeInfo(data->data(), 4, &truncated), "%s", path);
+    }
+}
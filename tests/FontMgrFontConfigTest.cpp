@@ -21,12 +21,16 @@
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
 #include "include/ports/SkFontMgr_fontconfig.h"
+#include "src/core/SkOSFile.h"
+#include "src/ports/SkFontMgr_fontconfig_priv.h"
+#include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
 #include "tools/Resources.h"
 
 #include <fontconfig/fontconfig.h>
 
 #include <array>
+#include <cstdio>
 #include <memory>
 
 namespace {
@@ -124,3 +128,67 @@ DEF_TEST(FontMgrFontConfig, reporter) {
         REPORTER_ASSERT(reporter, success);
     }
 }
+
+DEF_TEST(FontMgrFontConfig_MatchSnapshot, reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        INFOF(reporter, "No tmpDir; FontMgrFontConfig_MatchSnapshot skipped.");
+        return;
+    }
+    SkString path = SkOSPath::Join(tmpDir.c_str(), "FontMgrFontConfig.snapshot");
+    std::remove(path.c_str());
+
+    const char* bcp47[] = { "en" };
+    auto match = [&](const sk_sp<SkFontMgr>& fontMgr, SkUnichar character) {
+        return sk_sp<SkTypeface>(fontMgr->matchFamilyStyleCharacter(
+                "Distortable", SkFontStyle(), bcp47, std::size(bcp47), character));
+    };
+
+    sk_sp<SkFontMgr> fontMgr = SkFontMgr_New_FontConfig(
+            build_fontconfig_with_fontfile("/fonts/Distortable.ttf"), path.c_str());
+    sk_sp<SkTypeface> first = match(fontMgr, 'a');
+    if (!first) {
+        ERRORF(reporter, "Could not find typeface. FcVersion: %d", FcGetVersion());
+        return;
+    }
+    // Characters the font lacks match nothing.
+    REPORTER_ASSERT(reporter, !match(fontMgr, 0x4E00));
+    REPORTER_ASSERT(reporter, SkFontMgr_FontConfig_CountFontConfigMatches(fontMgr.get()) == 2);
+
+    // Repeated lookups, including misses, are answered without asking FontConfig.
+    REPORTER_ASSERT(reporter, match(fontMgr, 'a') == first);
+    REPORTER_ASSERT(reporter, !match(fontMgr, 0x4E00));
+    REPORTER_ASSERT(reporter, SkFontMgr_FontConfig_CountFontConfigMatches(fontMgr.get()) == 2);
+
+    // The snapshot can be written while the font manager is still in use.
+    REPORTER_ASSERT(reporter, SkFontMgr_FontConfig_WriteSnapshot(fontMgr.get()));
+    REPORTER_ASSERT(reporter, sk_exists(path.c_str()));
+    SkString expected;
+    first->getFamilyName(&expected);
+    first.reset();
+    fontMgr.reset();
+
+    // A new font manager starts from the snapshot and asks FontConfig only for new lookups.
+    fontMgr = SkFontMgr_New_FontConfig(
+            build_fontconfig_with_fontfile("/fonts/Distortable.ttf"), path.c_str());
+    REPORTER_ASSERT(reporter, fontMgr->countFamilies() > 0);
+    sk_sp<SkTypeface> restored = match(fontMgr, 'a');
+    REPORTER_ASSERT(reporter, restored);
+    REPORTER_ASSERT(reporter, !match(fontMgr, 0x4E00));
+    REPORTER_ASSERT(reporter, SkFontMgr_FontConfig_CountFontConfigMatches(fontMgr.get()) == 0);
+    if (restored) {
+        SkString actual;
+        restored->getFamilyName(&actual);
+        REPORTER_ASSERT(reporter, expected == actual, "%s != %s", expected.c_str(), actual.c_str());
+    }
+
+    // A live match of the same font finds the typeface restored from the snapshot.
+    sk_sp<SkTypeface> live = match(fontMgr, 'b');
+    REPORTER_ASSERT(reporter, SkFontMgr_FontConfig_CountFontConfigMatches(fontMgr.get()) == 1);
+    REPORTER_ASSERT(reporter, live == restored);
+
+    restored.reset();
+    live.reset();
+    fontMgr.reset();
+    std::remove(path.c_str());
+}
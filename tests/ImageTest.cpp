@@ -48,9 +48,11 @@
 #include "modules/skcms/skcms.h"
 #include "src/core/SkAutoPixmapStorage.h"
 #include "src/core/SkBitmapCache.h"
+#include "src/core/SkCachedData.h"
 #include "src/core/SkColorSpacePriv.h"
 #include "src/core/SkImagePriv.h"
 #include "src/core/SkOpts.h"
+#include "src/core/SkYUVPlanesCache.h"
 #include "src/gpu/ResourceKey.h"
 #include "src/gpu/ganesh/GrCaps.h"
 #include "src/gpu/ganesh/GrDirectContextPriv.h"
@@ -74,6 +76,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <initializer_list>
@@ -1461,6 +1464,61 @@ DEF_TEST(ImageScalePixels, reporter) {
     test_scale_pixels(reporter, codecImage.get(), pmRed);
 }
 
+// Lazy JPEG images downscale from their YUV planes; the result should be close to converting
+// to RGB at full size first.
+DEF_TEST(ImageScalePixels_LazyYUV, reporter) {
+    sk_sp<SkData> data = GetResourceAsData("images/mandrill_512_q075.jpg");
+    if (!data) {
+        return;
+    }
+    sk_sp<SkImage> lazy = SkImage::MakeFromEncoded(data);
+    sk_sp<SkImage> raster = SkImage::MakeFromEncoded(data)->makeRasterImage();
+    REPORTER_ASSERT(reporter, lazy && raster);
+
+    const SkSamplingOptions sampling(SkFilterMode::kLinear, SkMipmapMode::kLinear);
+    SkAutoPixmapStorage fromYUV, fromRGB;
+    fromYUV.alloc(SkImageInfo::MakeN32Premul(100, 80, SkColorSpace::MakeSRGB()));
+    fromRGB.alloc(fromYUV.info());
+    REPORTER_ASSERT(reporter, lazy->scalePixels(fromYUV, sampling));
+    REPORTER_ASSERT(reporter, raster->scalePixels(fromRGB, sampling));
+
+    // The planes path ran: the planes are cached and the full-size pixels never were.
+    SkBitmap cachedBitmap;
+    REPORTER_ASSERT(reporter, !SkBitmapCache::Find(SkBitmapCacheDesc::Make(lazy.get()),
+                                                   &cachedBitmap));
+    SkYUVAPixmaps cachedPlanes;
+    sk_sp<SkCachedData> planeData(SkYUVPlanesCache::FindAndRef(lazy->uniqueID(), &cachedPlanes));
+    REPORTER_ASSERT(reporter, planeData);
+
+    // With caching disallowed, neither the planes nor the pixels are left in the caches.
+    sk_sp<SkImage> uncached = SkImage::MakeFromEncoded(data);
+    SkAutoPixmapStorage fromUncached;
+    fromUncached.alloc(fromYUV.info());
+    REPORTER_ASSERT(reporter, uncached->scalePixels(fromUncached, sampling,
+                                                    SkImage::kDisallow_CachingHint));
+    REPORTER_ASSERT(reporter, !SkBitmapCache::Find(SkBitmapCacheDesc::Make(uncached.get()),
+                                                   &cachedBitmap));
+    sk_sp<SkCachedData> uncachedData(SkYUVPlanesCache::FindAndRef(uncached->uniqueID(),
+                                                                  &cachedPlanes));
+    REPORTER_ASSERT(reporter, !uncachedData);
+    REPORTER_ASSERT(reporter, 0 == memcmp(fromUncached.addr(), fromYUV.addr(),
+                                          fromYUV.computeByteSize()));
+
+    // The two paths filter chroma differently, so compare on average rather than exactly.
+    uint64_t totalDiff = 0;
+    for (int y = 0; y < fromYUV.height(); ++y) {
+        for (int x = 0; x < fromYUV.width(); ++x) {
+            const uint8_t* a = static_cast<const uint8_t*>(fromYUV.addr(x, y));
+            const uint8_t* b = static_cast<const uint8_t*>(fromRGB.addr(x, y));
+            for (int c = 0; c < 4; ++c) {
+                totalDiff += std::abs(a[c] - b[c]);
+            }
+        }
+    }
+    const double meanDiff = (double)totalDiff / (fromYUV.width() * fromYUV.height() * 4);
+    REPORTER_ASSERT(reporter, meanDiff < 3, "mean difference %g", meanDiff);
+}
+
 DEF_GANESH_TEST_FOR_RENDERING_CONTEXTS(ImageScalePixels_Gpu,
                                        reporter,
                                        ctxInfo,
@@ -13,17 +13,25 @@
 #include "include/core/SkFont.h"
 #include "include/core/SkImage.h" // IWYU pragma: keep
 #include "include/core/SkPaint.h"
+#include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
+#include "include/core/SkSpan.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/docs/SkPDFDocument.h"
+#include "include/effects/SkImageFilters.h"
+#include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
+#include "tools/ToolUtils.h"
 
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 static void test_empty(skiatest::Reporter* reporter) {
     SkDynamicMemoryWStream stream;
@@ -264,3 +272,317 @@ DEF_TEST(SkPDF_abort_jobs, rep) {
     doc->abort();
 }
 
+static sk_sp<SkData> draw_pages_to_pdf(SkExecutor* executor, SkSpan<const SkPDF::Page> pages) {
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream);
+    SkPDF::DrawPages(doc.get(), pages, executor);
+    doc->close();
+    return stream.detachAsData();
+}
+
+// Pages recorded concurrently must produce the same bytes as pages drawn serially.
+DEF_TEST(SkPDF_draw_pages, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_draw_pages, r);
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(64, 64);
+    bitmap.eraseColor(0xFF4F9643);
+    sk_sp<SkImage> image = bitmap.asImage();
+
+    std::vector<SkPDF::Page> pages;
+    for (int i = 0; i < 40; ++i) {
+        SkPDF::Page page;
+        page.fSize = {612, 792};
+        page.fDraw = [i, image](SkCanvas* canvas) {
+            SkPaint paint;
+            paint.setColor(SkColorSetARGB(0xFF, (uint8_t)(6 * i), 0x00, 0x80));
+            canvas->drawRect(SkRect::MakeXYWH(10 * i, 20, 100, 100), paint);
+            canvas->drawImage(image, 50, 200 + i);
+            canvas->drawString("Page", 72, 600, SkFont(), paint);
+        };
+        pages.push_back(std::move(page));
+    }
+
+    sk_sp<SkData> serial = draw_pages_to_pdf(nullptr, pages);
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    sk_sp<SkData> parallel = draw_pages_to_pdf(executor.get(), pages);
+    REPORTER_ASSERT(r, serial->size() > 0);
+    REPORTER_ASSERT(r, serial->equals(parallel.get()));
+}
+
+// With fStreamPages, finished pages are written out immediately instead of being held until
+// close(), so the document's footprint does not grow with the page count.
+static void check_pages_released(skiatest::Reporter* r, bool streamPages,
+                                 bool useObjectStreams = false) {
+    SkPDF::Metadata metadata;
+    metadata.fStreamPages = streamPages;
+    // Uncompressed, so that page dictionaries packed into object streams can be found.
+    metadata.fUseObjectStreams = useObjectStreams;
+    metadata.fCompressionLevel = SkPDF::Metadata::CompressionLevel::None;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    auto pdf = static_cast<SkPDFDocument*>(doc.get());
+    SkPaint paint;
+    std::vector<uint8_t> written;
+    size_t offset = 0;
+    for (int i = 0; i < 2000; ++i) {
+        paint.setColor(SkColorSetARGB(0xFF, (uint8_t)i, (uint8_t)(i >> 8), 0x00));
+        doc->beginPage(612, 792)->drawRect(SkRect::MakeXYWH(i % 500, 20, 100, 100), paint);
+        doc->endPage();
+
+        // Everything the page produced, its dictionary included, is in the output once the
+        // page ends, and nothing of it is kept by the document.
+        written.resize(stream.bytesWritten() - offset);
+        stream.read(written.data(), offset, written.size());
+        offset = stream.bytesWritten();
+        const char kPageDict[] = "/Type /Page\n";
+        const bool pageWritten = written.size() >= strlen(kPageDict) &&
+                                 contains(written.data(), written.size(), kPageDict);
+        const size_t retainedPages = pdf->retainedPageCount();
+        if (streamPages && (!pageWritten || retainedPages != 0)) {
+            ERRORF(r, "Page %d: written %d, %zu pages retained.", i, pageWritten, retainedPages);
+            break;
+        }
+        if (!streamPages && (pageWritten || retainedPages != (size_t)i + 1)) {
+            ERRORF(r, "Page %d without fStreamPages: written %d, %zu pages retained.",
+                   i, pageWritten, retainedPages);
+            break;
+        }
+    }
+    doc->close();
+}
+
+DEF_TEST(SkPDF_stream_pages, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_stream_pages, r);
+    check_pages_released(r, true);
+    check_pages_released(r, true, /*useObjectStreams=*/true);
+    // The same checks fail when pages are held until close().
+    check_pages_released(r, false);
+
+    SkPDF::Metadata metadata;
+    metadata.fStreamPages = true;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    for (int i = 0; i < 70; ++i) {
+        doc->beginPage(612, 792)->drawColor(SK_ColorBLUE);
+    }
+    doc->close();
+    sk_sp<SkData> data = stream.detachAsData();
+    // Eight full leaf nodes and one holding the last 6 pages, grouped under the root
+    // as nodes of 64 and 6 pages.
+    for (const char* expectation : {"/Type /Pages\n/Count 70", "/Type /Pages\n/Count 64",
+                                    "/Type /Pages\n/Count 6", "/Type /Pages\n/Count 8"}) {
+        if (!contains(data->bytes(), data->size(), expectation)) {
+            ERRORF(r, "PDF expectation missing: '%s'.", expectation);
+        }
+    }
+}
+
+// Distinct images and layers with the same content are written to the document only once.
+DEF_TEST(SkPDF_content_dedup, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_content_dedup, r);
+    auto makeImage = [](SkColor color) {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(128, 128);
+        bitmap.eraseColor(color);
+        return bitmap.asImage();
+    };
+    SkPDF::DedupStats stats;
+    SkPDF::Metadata metadata;
+    metadata.fDedupStats = &stats;
+    SkNullWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    for (int i = 0; i < 3; ++i) {
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        // A new SkImage on each page, but only two distinct contents.
+        canvas->drawImage(makeImage(SK_ColorRED), 10, 10);
+        canvas->drawImage(makeImage(i == 2 ? SK_ColorGREEN : SK_ColorRED), 200, 10);
+        canvas->saveLayerAlpha(nullptr, 0x80);
+        canvas->drawRect({300, 300, 400, 400}, SkPaint());
+        canvas->restore();
+        doc->endPage();
+    }
+    doc->close();
+    REPORTER_ASSERT(r, stats.fImagesDeduplicated == 4, "%d", stats.fImagesDeduplicated);
+    REPORTER_ASSERT(r, stats.fFormXObjectsDeduplicated >= 2, "%d",
+                    stats.fFormXObjectsDeduplicated);
+    REPORTER_ASSERT(r, stats.fBytesSaved > 0);
+}
+
+// If unusedObject is not null, an object number is reserved and never written, and returned
+// through it.
+static sk_sp<SkData> make_object_stream_test_pdf(bool useObjectStreams,
+                                                 SkPDF::Metadata::CompressionLevel level,
+                                                 int* unusedObject = nullptr) {
+    SkPDF::Metadata metadata;
+    metadata.fUseObjectStreams = useObjectStreams;
+    metadata.fCompressionLevel = level;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    for (int i = 0; i < 150; ++i) {
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        if (i == 0 && unusedObject) {
+            *unusedObject = static_cast<SkPDFDocument*>(doc.get())->reserveRef().fValue;
+        }
+        SkPaint paint;
+        paint.setAlphaf((i % 50 + 1) / 51.0f);
+        canvas->drawRect({10, 10, 100, 100}, paint);
+        canvas->drawString("Text", 72, 200, SkFont(), paint);
+    }
+    doc->close();
+    return stream.detachAsData();
+}
+
+static uint32_t read_big_endian(const uint8_t* bytes, int count) {
+    uint32_t value = 0;
+    for (int i = 0; i < count; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// Every cross-reference stream entry must point at its object, either directly in the file or
+// through the header of the object stream holding it.
+DEF_TEST(SkPDF_object_streams, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_object_streams, r);
+    int unusedObject = 0;
+    sk_sp<SkData> data = make_object_stream_test_pdf(
+            true, SkPDF::Metadata::CompressionLevel::None, &unusedObject);
+    std::string pdf(static_cast<const char*>(data->data()), data->size());
+    REPORTER_ASSERT(r, pdf.compare(0, 8, "%PDF-1.5") == 0);
+    REPORTER_ASSERT(r, pdf.find("\nxref\n") == std::string::npos);
+
+    size_t startxref = pdf.rfind("startxref\n");
+    REPORTER_ASSERT(r, startxref != std::string::npos);
+    if (startxref == std::string::npos) {
+        return;
+    }
+    size_t xrefOffset = std::stoul(pdf.substr(startxref + 10));
+    REPORTER_ASSERT(r, pdf.find("/Type /XRef", xrefOffset) < startxref);
+    int size = std::stoi(pdf.substr(pdf.find("/Size ", xrefOffset) + 6));
+    const uint8_t* entries = data->bytes() + pdf.find("stream\n", xrefOffset) + 7;
+
+    auto startsObject = [&pdf](size_t offset, int objectNumber) {
+        std::string header = std::to_string(objectNumber) + " 0 obj\n";
+        return pdf.compare(offset, header.size(), header) == 0;
+    };
+    int packedObjects = 0;
+    for (int i = 1; i < size; ++i) {
+        const uint8_t* entry = entries + 7 * i;
+        uint32_t field2 = read_big_endian(entry + 1, 4);
+        uint32_t field3 = read_big_endian(entry + 5, 2);
+        if (i == unusedObject) {
+            REPORTER_ASSERT(r, entry[0] == 0, "reserved object %d is not free", i);
+            continue;
+        }
+        if (entry[0] == 1) {
+            REPORTER_ASSERT(r, startsObject(field2, i), "object %d", i);
+            continue;
+        }
+        REPORTER_ASSERT(r, entry[0] == 2, "object %d", i);
+        // The object stream holding it must be a direct object listing this one.
+        const uint8_t* streamEntry = entries + 7 * field2;
+        REPORTER_ASSERT(r, streamEntry[0] == 1);
+        size_t streamOffset = read_big_endian(streamEntry + 1, 4);
+        REPORTER_ASSERT(r, startsObject(streamOffset, field2));
+        size_t header = pdf.find("stream\n", streamOffset) + 7;
+        REPORTER_ASSERT(r, pdf.find("/Type /ObjStm", streamOffset) < header);
+        std::istringstream pairs(pdf.substr(header, 20 * (field3 + 1)));
+        int objectNumber = 0, offset = 0;
+        for (uint32_t j = 0; j <= field3; ++j) {
+            pairs >> objectNumber >> offset;
+        }
+        REPORTER_ASSERT(r, objectNumber == i, "object %d listed as %d", i, objectNumber);
+        ++packedObjects;
+    }
+    REPORTER_ASSERT(r, packedObjects > 150);
+
+    size_t classicSize =
+            make_object_stream_test_pdf(false, SkPDF::Metadata::CompressionLevel::Default)->size();
+    size_t packedSize =
+            make_object_stream_test_pdf(true, SkPDF::Metadata::CompressionLevel::Default)->size();
+    REPORTER_ASSERT(r, packedSize < classicSize, "%zu >= %zu", packedSize, classicSize);
+}
+
+// PDF/A-1 does not allow object streams, so fPDFA wins over fUseObjectStreams.
+DEF_TEST(SkPDF_object_streams_pdfa, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_object_streams_pdfa, r);
+    SkPDF::Metadata metadata;
+    metadata.fPDFA = true;
+    metadata.fUseObjectStreams = true;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    doc->beginPage(612, 792)->drawColor(SK_ColorBLUE);
+    doc->close();
+    sk_sp<SkData> data = stream.detachAsData();
+    std::string pdf(static_cast<const char*>(data->data()), data->size());
+    REPORTER_ASSERT(r, pdf.compare(0, 8, "%PDF-1.4") == 0);
+    REPORTER_ASSERT(r, pdf.find("\nxref\n") != std::string::npos);
+    REPORTER_ASSERT(r, pdf.find("/Type /ObjStm") == std::string::npos);
+}
+
+static int count_occurrences(const SkData* data, const char needle[]) {
+    std::string haystack(static_cast<const char*>(data->data()), data->size());
+    int count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+         pos = haystack.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+DEF_TEST(SkPDF_coalesce_content, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_coalesce_content, r);
+    SkPDF::Metadata metadata;
+    metadata.fCompressionLevel = SkPDF::Metadata::CompressionLevel::None;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    SkCanvas* canvas = doc->beginPage(612, 792);
+    SkPaint opaque;
+    opaque.setColor(SK_ColorBLUE);
+    for (int i = 0; i < 4; ++i) {
+        canvas->drawRect(SkRect::MakeXYWH(10.0f + 20 * i, 10, 15, 15), opaque);
+    }
+    SkFont font(ToolUtils::create_portable_typeface());
+    for (int i = 0; i < 3; ++i) {
+        canvas->drawString("text", 10, 100.0f + 20 * i, font, opaque);
+    }
+    SkPaint translucent;
+    translucent.setColor(0x800000FF);
+    canvas->drawRect({10, 200, 50, 250}, translucent);
+    canvas->drawRect({30, 220, 70, 270}, translucent);
+    doc->endPage();
+    doc->close();
+    sk_sp<SkData> data = stream.detachAsData();
+
+    REPORTER_ASSERT(r, count_occurrences(data.get(), " re\n") == 6);
+    // The opaque rects share one fill, the overlapping translucent ones do not.
+    int fills = count_occurrences(data.get(), "\nf\n");
+    REPORTER_ASSERT(r, fills == 3, "%d", fills);
+    int textObjects = count_occurrences(data.get(), "BT\n");
+    REPORTER_ASSERT(r, textObjects == 1, "%d", textObjects);
+    REPORTER_ASSERT(r, textObjects == count_occurrences(data.get(), "ET\n"));
+}
+
+DEF_TEST(SkPDF_tiled_raster_fallback, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_tiled_raster_fallback, r);
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool();
+    SkPDF::Metadata metadata;
+    metadata.fExecutor = executor.get();
+    metadata.fCompressionLevel = SkPDF::Metadata::CompressionLevel::None;
+    SkDynamicMemoryWStream stream;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    SkCanvas* canvas = doc->beginPage(2000, 2000);
+    // The blurred layer is rasterized and, being larger than one tile, drawn as several images.
+    SkPaint layerPaint;
+    layerPaint.setImageFilter(SkImageFilters::Blur(4, 4, nullptr));
+    canvas->saveLayer(nullptr, &layerPaint);
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    canvas->drawRect({100, 100, 1900, 1900}, paint);
+    canvas->restore();
+    doc->endPage();
+    doc->close();
+    sk_sp<SkData> data = stream.detachAsData();
+    int images = count_occurrences(data.get(), "/Subtype /Image");
+    REPORTER_ASSERT(r, images >= 4, "%d", images);
+}
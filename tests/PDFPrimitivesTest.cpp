@@ -29,6 +29,7 @@
 #include "include/core/SkString.h"
 #include "include/core/SkTypes.h"
 #include "include/docs/SkPDFDocument.h"
+#include "include/effects/SkGradientShader.h"
 #include "include/effects/SkImageFilters.h"
 #include "include/effects/SkPerlinNoiseShader.h"
 #include "include/private/SkFloatingPoint.h"
@@ -40,6 +41,9 @@
 #include "src/pdf/SkClusterator.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/pdf/SkPDFFont.h"
+#include "src/pdf/SkPDFGradientShader.h"
+#include "src/pdf/SkPDFGlyphUse.h"
+#include "src/pdf/SkPDFSubsetFont.h"
 #include "src/pdf/SkPDFTypes.h"
 #include "src/pdf/SkPDFUnion.h"
 #include "src/pdf/SkPDFUtils.h"
@@ -485,4 +489,59 @@ DEF_TEST(fuzz875632f0, reporter) {
 
     canvas->drawPath(SkPath(), paint);
 }
+
+DEF_TEST(SkPDF_SubsetFontCache, reporter) {
+    // Use a typeface ID no real typeface will have, so other tests cannot fill the cache.
+    constexpr uint32_t kTypefaceID = 0xFFFFFFF0;
+    int loads = 0;
+    auto fontData = [&loads]() {
+        ++loads;
+        return GetResourceAsData("fonts/Roboto-Regular.ttf");
+    };
+    SkPDFGlyphUse glyphs(1, 100), otherGlyphs(1, 100);
+    glyphs.set(5);
+    glyphs.set(60);
+    otherGlyphs.set(5);
+    auto subsetter = SkPDF::Metadata::kHarfbuzz_Subsetter;
+
+    sk_sp<SkData> first = SkPDFSubsetFontCached(kTypefaceID, fontData, glyphs, subsetter, "", 0);
+    sk_sp<SkData> second = SkPDFSubsetFontCached(kTypefaceID, fontData, glyphs, subsetter, "", 0);
+    REPORTER_ASSERT(reporter, loads == 1);
+    REPORTER_ASSERT(reporter, first == second);
+
+    // A different glyph set or typeface is a different subset.
+    SkPDFSubsetFontCached(kTypefaceID, fontData, otherGlyphs, subsetter, "", 0);
+    REPORTER_ASSERT(reporter, loads == 2);
+    SkPDFSubsetFontCached(kTypefaceID + 1, fontData, glyphs, subsetter, "", 0);
+    REPORTER_ASSERT(reporter, loads == 3);
+}
+
+DEF_TEST(SkPDF_GradientFunctionCache, reporter) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_GradientFunctionCache, reporter);
+    // Colors no other test uses, so that the first document here is a cache miss.
+    const SkColor colors[] = {0xFF123457, 0xFF89ABCF, 0xFF2468AD};
+    const SkPoint pts[2] = {{0, 0}, {97, 89}};
+    SkPaint linear, sweep;
+    linear.setShader(SkGradientShader::MakeLinear(pts, colors, nullptr, std::size(colors),
+                                                  SkTileMode::kClamp));
+    sweep.setShader(SkGradientShader::MakeSweep(53, 59, colors, nullptr, std::size(colors)));
+    auto makePDF = [&]() {
+        SkDynamicMemoryWStream stream;
+        auto doc = SkPDF::MakeDocument(&stream);
+        SkCanvas* canvas = doc->beginPage(200, 200);
+        canvas->drawRect({0, 0, 100, 100}, linear);
+        canvas->drawRect({100, 100, 200, 200}, sweep);
+        doc->close();
+        return stream.bytesWritten();
+    };
+    SkPDFGradientShader::FunctionCacheStats before = SkPDFGradientShader::GetFunctionCacheStats();
+    size_t firstSize = makePDF();
+    SkPDFGradientShader::FunctionCacheStats middle = SkPDFGradientShader::GetFunctionCacheStats();
+    size_t secondSize = makePDF();
+    SkPDFGradientShader::FunctionCacheStats after = SkPDFGradientShader::GetFunctionCacheStats();
+    // Other tests may use the cache concurrently, so only check lower bounds.
+    REPORTER_ASSERT(reporter, middle.fMisses - before.fMisses >= 2);
+    REPORTER_ASSERT(reporter, after.fHits - middle.fHits >= 2);
+    REPORTER_ASSERT(reporter, firstSize == secondSize, "%zu %zu", firstSize, secondSize);
+}
 #endif
@@ -592,6 +592,98 @@ DEF_TEST(SVGDevice_relative_path_encoding, reporter) {
     REPORTER_ASSERT(reporter, !strcmp(d, "m100 50l100 0l0 100l-100 -100Z"));
 }
 
+DEF_TEST(SVGDevice_compact_path_encoding, reporter) {
+    SkDOM dom;
+    {
+        auto svgCanvas = MakeDOMCanvas(&dom, SkSVGCanvas::kCompact_Flag);
+        SkPath path;
+        path.moveTo(100, 50);
+        path.lineTo(200, 50);
+        path.lineTo(200, 150);
+        path.close();
+        path.moveTo(10.123f, 0.5f);
+        path.lineTo(20.5f, -0.25f);
+        path.cubicTo(30, 10, 40, 10, 50, 0);
+        path.cubicTo(60, -10, 70, -10, 80, 0);
+
+        svgCanvas->drawPath(path, SkPaint());
+    }
+
+    const auto* rootElement = dom.finishParsing();
+    REPORTER_ASSERT(reporter, rootElement, "root element not found");
+    const auto* pathElement = dom.getFirstChild(rootElement, "path");
+    REPORTER_ASSERT(reporter, pathElement, "path element not found");
+    const auto* d = dom.findAttr(pathElement, "d");
+    REPORTER_ASSERT(reporter,
+                    !strcmp(d, "m100 50h100v100zm-89.88-49.5 10.38-.75c9.5 10.25 19.5 10.25 29.5.25"
+                               "s20-10 30 0"),
+                    "%s", d);
+}
+
+DEF_TEST(SVGDevice_compact_paint_classes, reporter) {
+    SkDOM dom;
+    {
+        auto svgCanvas = MakeDOMCanvas(&dom, SkSVGCanvas::kCompact_Flag);
+        SkPaint paint;
+        paint.setColor(SK_ColorBLUE);
+        paint.setStyle(SkPaint::kStroke_Style);
+        paint.setStrokeWidth(2);
+
+        for (int i = 0; i < 3; ++i) {
+            svgCanvas->drawRect(SkRect::MakeXYWH(i * 10, 0, 5, 5), paint);
+        }
+    }
+
+    const auto* rootElement = dom.finishParsing();
+    REPORTER_ASSERT(reporter, rootElement, "root element not found");
+    const auto* styleElement = dom.getFirstChild(rootElement, "style");
+    REPORTER_ASSERT(reporter, styleElement, "style element not found");
+
+    // The first use spells the paint out, the next ones refer to the class.
+    int classCount = 0;
+    for (const auto* rect = dom.getFirstChild(rootElement, "rect"); rect;
+         rect = dom.getNextSibling(rect, "rect")) {
+        if (const char* cls = dom.findAttr(rect, "class")) {
+            REPORTER_ASSERT(reporter, !strcmp(cls, "p0"));
+            REPORTER_ASSERT(reporter, !dom.findAttr(rect, "stroke"));
+            classCount++;
+        } else {
+            REPORTER_ASSERT(reporter, dom.findAttr(rect, "stroke"));
+        }
+    }
+    REPORTER_ASSERT(reporter, classCount == 2);
+}
+
+// The compact flags should make typical output, many paths sharing a few paints, smaller.
+DEF_TEST(SVGDevice_compact_size, reporter) {
+    auto svgSize = [](uint32_t flags) {
+        SkDynamicMemoryWStream stream;
+        {
+            auto canvas = SkSVGCanvas::Make(SkRect::MakeWH(500, 500), &stream, flags);
+            SkPaint fill, stroke;
+            fill.setColor(0xff1f77b4);
+            stroke.setColor(0xffff7f0e);
+            stroke.setStyle(SkPaint::kStroke_Style);
+            stroke.setStrokeWidth(2);
+            for (int i = 0; i < 50; ++i) {
+                SkPath path;
+                path.moveTo(i, 2.5f * i);
+                path.lineTo(i + 100.25f, 2.5f * i);
+                path.cubicTo(i + 150, 3.0f * i, i + 200, 3.5f * i, i + 250.5f, 2.5f * i);
+                canvas->drawPath(path, i % 2 ? fill : stroke);
+            }
+        }
+        return stream.bytesWritten();
+    };
+    const size_t defaultSize = svgSize(0);
+    const size_t compactSize = svgSize(SkSVGCanvas::kCompact_Flag);
+    const size_t smallestSize = svgSize(SkSVGCanvas::kCompact_Flag |
+                                        SkSVGCanvas::kNoPrettyXML_Flag);
+    REPORTER_ASSERT(reporter, compactSize < defaultSize, "%zu >= %zu", compactSize, defaultSize);
+    REPORTER_ASSERT(reporter, smallestSize < compactSize, "%zu >= %zu",
+                    smallestSize, compactSize);
+}
+
 DEF_TEST(SVGDevice_color_shader, reporter) {
     SkDOM dom;
     {
@@ -15,8 +15,12 @@
 #include "include/core/SkSurfaceProps.h"
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
+#include "include/private/base/SkTArray.h"
 #include "include/private/base/SkTo.h"
+#include "src/core/SkArenaAlloc.h"
+#include "src/core/SkGlyph.h"
 #include "src/core/SkGlyphBuffer.h"
+#include "src/core/SkMask.h"
 #include "src/core/SkScalerCache.h"
 #include "src/core/SkScalerContext.h"
 #include "src/core/SkStrikeSpec.h"
@@ -27,6 +31,7 @@
 
 #include <atomic>
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <memory>
@@ -96,3 +101,67 @@ DEF_TEST(SkScalerCacheMultiThread, Reporter) {
         SkTaskGroup(*executor).batch(kThreadCount, perThread);
     }
 }
+
+DEF_TEST(SkScalerCacheBatchedImages, reporter) {
+    SkFont font(ToolUtils::create_portable_typeface("serif", SkFontStyle()), 24);
+    font.setEdging(SkFont::Edging::kAntiAlias);
+
+    // Stroking makes the scaler context draw the images from the glyph paths, which the batch
+    // may rasterize on several threads.
+    SkPaint strokePaint;
+    strokePaint.setStyle(SkPaint::kStroke_Style);
+    strokePaint.setStrokeWidth(1);
+    SkStrikeSpec strikeSpec = SkStrikeSpec::MakeMask(
+            font, strokePaint, SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+            SkScalerContextFlags::kNone, SkMatrix::I());
+
+    constexpr int glyphCount = 'z' - ' ';
+    auto makeGlyphs = [&](SkArenaAlloc* alloc, SkScalerContext* context, SkGlyph* glyphs[]) {
+        for (int c = ' '; c < 'z'; c++) {
+            SkPackedGlyphID packedID{font.unicharToGlyph(c)};
+            glyphs[c - ' '] = alloc->make<SkGlyph>(context->makeGlyph(packedID, alloc));
+        }
+    };
+
+    SkArenaAlloc alloc{4096};
+    auto serialContext = strikeSpec.createScalerContext();
+    SkGlyph* serialGlyphs[glyphCount];
+    makeGlyphs(&alloc, serialContext.get(), serialGlyphs);
+    for (SkGlyph* glyph : serialGlyphs) {
+        glyph->setImage(&alloc, serialContext.get());
+    }
+
+    auto batchedContext = strikeSpec.createScalerContext();
+    SkGlyph* batchedGlyphs[glyphCount];
+    makeGlyphs(&alloc, batchedContext.get(), batchedGlyphs);
+    SkSTArray<glyphCount, const SkGlyph*, true> fromPath;
+    SkSTArray<glyphCount, SkMask, true> masks;
+    for (SkGlyph* glyph : batchedGlyphs) {
+        if (!glyph->setImageHasBeenCalled() && batchedContext->imageIsFromPath(*glyph)) {
+            SkMask& mask = masks.push_back(glyph->mask());
+            mask.fImage = static_cast<uint8_t*>(
+                    alloc.makeBytesAlignedTo(glyph->imageSize(), glyph->formatAlignment()));
+            fromPath.push_back(glyph);
+        }
+    }
+    REPORTER_ASSERT(reporter, fromPath.size() >= 32);
+    auto threadPool = SkExecutor::MakeFIFOThreadPool(4);
+    batchedContext->getImagesFromPaths(fromPath, masks, *threadPool);
+    for (int i = 0; i < fromPath.size(); i++) {
+        const_cast<SkGlyph*>(fromPath[i])->setImage(&alloc, masks[i].fImage);
+    }
+    for (SkGlyph* glyph : batchedGlyphs) {
+        glyph->setImage(&alloc, batchedContext.get());
+    }
+
+    for (int i = 0; i < glyphCount; i++) {
+        const SkGlyph* serial = serialGlyphs[i];
+        const SkGlyph* batched = batchedGlyphs[i];
+        REPORTER_ASSERT(reporter, serial->imageSize() == batched->imageSize());
+        if (serial->image() != nullptr && serial->imageSize() == batched->imageSize()) {
+            REPORTER_ASSERT(reporter,
+                            memcmp(serial->image(), batched->image(), serial->imageSize()) == 0,
+                            "glyph %d", serial->getGlyphID());
+        }
+    }
+}
@@ -6,18 +6,28 @@
  */
 
 #include "include/core/SkFont.h"
+#include "include/core/SkFontArguments.h"
 #include "include/core/SkFontStyle.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSurfaceProps.h"
 #include "include/core/SkTypeface.h"
+#include "include/private/base/SkTo.h"
+#include "src/core/SkOSFile.h"
+#include "src/core/SkPersistentGlyphCache.h"
 #include "src/core/SkScalerContext.h"
 #include "src/core/SkStrikeCache.h"
 #include "src/core/SkStrikeSpec.h"
+#include "src/utils/SkOSPath.h"
 #include "tests/Test.h"
+#include "tools/Resources.h"
 #include "tools/ToolUtils.h"
 
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
 DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
     SkStrikeCache cache;
 
@@ -59,3 +69,139 @@ DEF_TEST(SkStrikeCache_CachePurge, Reporter) {
 
 
 }
+
+DEF_TEST(SkStrikeCache_PersistentGlyphCache, reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        INFOF(reporter, "No tmpDir; SkStrikeCache_PersistentGlyphCache skipped.");
+        return;
+    }
+    sk_sp<SkTypeface> typeface = MakeResourceAsTypeface("fonts/Roboto-Regular.ttf");
+    sk_sp<SkTypeface> distortable = MakeResourceAsTypeface("fonts/Distortable.ttf");
+    if (!typeface || !distortable) {
+        INFOF(reporter, "No fonts; SkStrikeCache_PersistentGlyphCache skipped.");
+        return;
+    }
+
+    SkString directory = SkOSPath::Join(tmpDir.c_str(), "SkStrikeCache_PersistentGlyphCache");
+    auto clearDirectory = [&]() {
+        if (sk_isdir(directory.c_str())) {
+            SkOSFile::Iter iter(directory.c_str());
+            for (SkString name; iter.next(&name);) {
+                std::remove(SkOSPath::Join(directory.c_str(), name.c_str()).c_str());
+            }
+        }
+    };
+    clearDirectory();
+
+    auto makeStrikeSpec = [](sk_sp<SkTypeface> typeface, SkScalar size) {
+        SkFont font(std::move(typeface), size);
+        font.setEdging(SkFont::Edging::kAntiAlias);
+        return SkStrikeSpec::MakeMask(
+                font, SkPaint(), SkSurfaceProps(0, kUnknown_SkPixelGeometry),
+                SkScalerContextFlags::kNone, SkMatrix::I());
+    };
+
+    constexpr int glyphCount = 32;
+    SkPackedGlyphID glyphIDs[glyphCount];
+    for (int i = 0; i < glyphCount; i++) {
+        glyphIDs[i] = SkPackedGlyphID{SkTo<SkGlyphID>(i)};
+    }
+
+    // Each strike cache stands in for a process.
+    auto render = [&](sk_sp<SkPersistentGlyphCache> persistentCache,
+                      const SkStrikeSpec& strikeSpec, const SkGlyph* glyphs[]) {
+        SkStrikeCache cache;
+        cache.setPersistentGlyphCache(std::move(persistentCache));
+        sk_sp<SkStrike> strike = strikeSpec.findOrCreateStrike(&cache);
+        strike->prepareImages(glyphIDs, glyphs);
+        return strike;
+    };
+
+    const SkStrikeSpec strikeSpec = makeStrikeSpec(typeface, 24);
+    constexpr size_t kBudget = 1 << 20;
+    sk_sp<SkPersistentGlyphCache> first = SkPersistentGlyphCache::Make(directory.c_str(), kBudget);
+    REPORTER_ASSERT(reporter, first);
+    const SkGlyph* firstGlyphs[glyphCount];
+    sk_sp<SkStrike> firstStrike = render(first, strikeSpec, firstGlyphs);
+    const size_t strikeFileSize = first->bytesUsed();
+    REPORTER_ASSERT(reporter, strikeFileSize > 0);
+
+    sk_sp<SkPersistentGlyphCache> second = SkPersistentGlyphCache::Make(directory.c_str(),
+                                                                        kBudget);
+    REPORTER_ASSERT(reporter, second->bytesUsed() == strikeFileSize);
+    sk_sp<SkPersistentGlyphCache::Strike> stored =
+            second->openStrike(strikeSpec.descriptor(), strikeSpec.typeface());
+    REPORTER_ASSERT(reporter, stored->count() > 0);
+
+    const SkGlyph* secondGlyphs[glyphCount];
+    sk_sp<SkStrike> secondStrike = render(second, strikeSpec, secondGlyphs);
+    for (int i = 0; i < glyphCount; i++) {
+        const SkGlyph* a = firstGlyphs[i];
+        const SkGlyph* b = secondGlyphs[i];
+        REPORTER_ASSERT(reporter, a->imageSize() == b->imageSize());
+        if (a->image() != nullptr && a->imageSize() == b->imageSize()) {
+            REPORTER_ASSERT(reporter, stored->findImage(*b) != nullptr);
+            REPORTER_ASSERT(reporter, memcmp(a->image(), b->image(), a->imageSize()) == 0,
+                            "glyph %d", a->getGlyphID());
+        }
+    }
+    // Nothing was new, so nothing was written.
+    REPORTER_ASSERT(reporter, second->bytesUsed() == strikeFileSize);
+
+    // Without its data a font has no identity that holds across processes; nothing is stored.
+    const SkStrikeSpec portableSpec = makeStrikeSpec(
+            ToolUtils::create_portable_typeface("serif", SkFontStyle()), 24);
+    const SkGlyph* portableGlyphs[glyphCount];
+    (void)render(second, portableSpec, portableGlyphs);
+    REPORTER_ASSERT(reporter, second->bytesUsed() == strikeFileSize);
+    REPORTER_ASSERT(reporter, second->openStrike(portableSpec.descriptor(),
+                                                 portableSpec.typeface())->count() == 0);
+
+    // Instances of a variable font do not share glyphs.
+    auto makeInstance = [&](SkScalar weight) {
+        SkFontArguments::VariationPosition::Coordinate coordinates[] = {
+                {SkSetFourByteTag('w', 'g', 'h', 't'), weight}};
+        return distortable->makeClone(SkFontArguments().setVariationDesignPosition(
+                {coordinates, std::size(coordinates)}));
+    };
+    const SkStrikeSpec lightSpec = makeStrikeSpec(makeInstance(0.5f), 24);
+    const SkStrikeSpec boldSpec = makeStrikeSpec(makeInstance(2.0f), 24);
+    const SkGlyph* lightGlyphs[glyphCount];
+    (void)render(second, lightSpec, lightGlyphs);
+    REPORTER_ASSERT(reporter,
+                    second->openStrike(lightSpec.descriptor(), lightSpec.typeface())->count() > 0);
+    REPORTER_ASSERT(reporter,
+                    second->openStrike(boldSpec.descriptor(), boldSpec.typeface())->count() == 0);
+
+    // The budget counts what every process wrote, not just this one.
+    clearDirectory();
+    const size_t budget = strikeFileSize + strikeFileSize / 2;
+    sk_sp<SkPersistentGlyphCache> processA = SkPersistentGlyphCache::Make(directory.c_str(),
+                                                                          budget);
+    sk_sp<SkPersistentGlyphCache> processB = SkPersistentGlyphCache::Make(directory.c_str(),
+                                                                          budget);
+    const SkGlyph* aGlyphs[glyphCount];
+    (void)render(processA, strikeSpec, aGlyphs);
+    REPORTER_ASSERT(reporter, processB->bytesUsed() == strikeFileSize);
+    const SkGlyph* bGlyphs[glyphCount];
+    (void)render(processB, makeStrikeSpec(typeface, 25), bGlyphs);
+    REPORTER_ASSERT(reporter, processA->bytesUsed() <= budget);
+
+    // Opening with a smaller budget evicts the files.
+    sk_sp<SkPersistentGlyphCache> small = SkPersistentGlyphCache::Make(directory.c_str(), 16);
+    REPORTER_ASSERT(reporter, small->bytesUsed() == 0);
+    REPORTER_ASSERT(reporter,
+                    small->openStrike(strikeSpec.descriptor(), strikeSpec.typeface())->count() == 0);
+
+    // Files still being written count against the budget too.
+    {
+        SkFILEWStream tmp(SkOSPath::Join(directory.c_str(), "strike.glyphs.1.2.tmp").c_str());
+        REPORTER_ASSERT(reporter, tmp.isValid());
+        char zeros[100] = {};
+        tmp.write(zeros, sizeof(zeros));
+    }
+    REPORTER_ASSERT(reporter,
+                    SkPersistentGlyphCache::Make(directory.c_str(), kBudget)->bytesUsed() == 100);
+    clearDirectory();
+}
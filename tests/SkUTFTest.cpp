@@ -6,7 +6,9 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 DEF_TEST(SkUTF_UTF16, reporter) {
     // Test non-basic-multilingual-plane unicode.
@@ -97,6 +99,60 @@ DEF_TEST(SkUTF_CountUTF8, r) {
     }
 }
 
+DEF_TEST(SkUTF_UTF8ToUTF32, r) {
+    // Long enough ASCII runs, at every alignment, to go through the word at a time path.
+    static const char* gTexts[] = {
+        "",
+        ASCII_BYTE,
+        "0123456789abcdefghij",
+        "0123456" LEADING_TWO_BYTE CONTINUATION_BYTE "89abcdefghijklmnop",
+        LEADING_THREE_BYTE CONTINUATION_BYTE CONTINUATION_BYTE "0123456789abcdefghij"
+            LEADING_FOUR_BYTE "\x90\x8C\xB0" "klmnopq",
+        "abcdefgh" LEADING_TWO_BYTE CONTINUATION_BYTE LEADING_TWO_BYTE CONTINUATION_BYTE
+            "ijklmnopqrstuvwx" LEADING_THREE_BYTE CONTINUATION_BYTE CONTINUATION_BYTE,
+    };
+    for (const char* text : gTexts) {
+        for (size_t offset = 0; offset < 8; ++offset) {
+            std::string str = std::string(offset, 'z') + text;
+            const int count = SkUTF::CountUTF8(str.data(), str.size());
+
+            std::vector<SkUnichar> expected;
+            const char* ptr = str.data();
+            const char* end = ptr + str.size();
+            while (ptr < end) {
+                expected.push_back(SkUTF::NextUTF8(&ptr, end));
+            }
+            REPORTER_ASSERT(r, count == (int)expected.size());
+            REPORTER_ASSERT(r, SkUTF::UTF8ToUTF32(nullptr, 0, str.data(), str.size()) == count);
+
+            std::vector<SkUnichar> unichars(count + 1, -2);
+            REPORTER_ASSERT(r, SkUTF::UTF8ToUTF32(unichars.data(), count,
+                                                  str.data(), str.size()) == count);
+            REPORTER_ASSERT(r, std::equal(expected.begin(), expected.end(), unichars.begin()));
+            REPORTER_ASSERT(r, unichars[count] == -2);
+
+            // A short buffer gets as many as fit, and nothing after them.
+            std::fill(unichars.begin(), unichars.end(), -2);
+            const int half = count / 2;
+            REPORTER_ASSERT(r, SkUTF::UTF8ToUTF32(unichars.data(), half,
+                                                  str.data(), str.size()) == count);
+            REPORTER_ASSERT(r, std::equal(expected.begin(), expected.begin() + half,
+                                          unichars.begin()));
+            REPORTER_ASSERT(r, unichars[half] == -2);
+        }
+    }
+
+    static const char* gInvalid[] = {
+        "0123456789" INVALID_BYTE "abcdefgh",
+        "0123456789abcdef" CONTINUATION_BYTE,
+        "0123456789abcdef" LEADING_THREE_BYTE CONTINUATION_BYTE,
+    };
+    for (const char* text : gInvalid) {
+        REPORTER_ASSERT(r, SkUTF::CountUTF8(text, strlen(text)) == -1);
+        REPORTER_ASSERT(r, SkUTF::UTF8ToUTF32(nullptr, 0, text, strlen(text)) == -1);
+    }
+}
+
 DEF_TEST(SkUTF_NextUTF8_ToUTF8, r) {
     struct {
         SkUnichar expected;
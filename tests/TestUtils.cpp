@@ -348,3 +348,27 @@ DEF_TEST(chartoglyph_cache, reporter) {
         }
     }
 }
+
+DEF_TEST(chartoglyph_cache_latin1, reporter) {
+    SkCharToGlyphCache cache;
+
+    // Interleave Latin-1 with unichars that go through the sorted search.
+    for (SkUnichar c = 0; c < 0x300; c += 5) {
+        int index = cache.findGlyphIndex(c);
+        REPORTER_ASSERT(reporter, index < 0);
+        cache.insertCharAndGlyph(~index, c, hash_to_glyph(c));
+    }
+    for (SkUnichar c = 0; c < 0x300; ++c) {
+        int index = cache.findGlyphIndex(c);
+        if (c % 5 == 0) {
+            REPORTER_ASSERT(reporter, (unsigned)index == hash_to_glyph(c));
+        } else {
+            REPORTER_ASSERT(reporter, index < 0);
+        }
+    }
+
+    cache.reset();
+    for (SkUnichar c = 0; c < 0x300; c += 5) {
+        REPORTER_ASSERT(reporter, cache.findGlyphIndex(c) < 0);
+    }
+}
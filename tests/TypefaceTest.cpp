@@ -11,6 +11,8 @@
 #include "include/core/SkFontMgr.h"
 #include "include/core/SkFontParameters.h"
 #include "include/core/SkFontStyle.h"
+#include "include/core/SkGraphics.h"
+#include "include/core/SkPath.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkScalar.h"
@@ -23,6 +25,7 @@
 #include "src/core/SkEndian.h"
 #include "src/core/SkFontDescriptor.h"
 #include "src/core/SkFontPriv.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/core/SkTypefaceCache.h"
 #include "src/sfnt/SkOTTable_OS_2.h"
 #include "src/sfnt/SkOTTable_OS_2_V0.h"
@@ -40,6 +43,10 @@
 #include <string>
 #include <utility>
 
+#if defined(SK_TYPEFACE_FREETYPE)
+#include "src/ports/SkFontHost_FreeType_common.h"
+#endif
+
 #if defined(SK_BUILD_FOR_WIN)
 #include "include/ports/SkTypeface_win.h"
 #include "src/core/SkFontMgrPriv.h"
@@ -525,6 +532,51 @@ DEF_TEST(TypefaceCache, reporter) {
     REPORTER_ASSERT(reporter, t1->unique());
 }
 
+static SkTypefaceCache::Key make_key(const char identity[], int index, float weight) {
+    SkTypefaceCache::Key key;
+    key.fIdentity.set(identity);
+    key.fIndex = index;
+    key.fAxes.push_back({SkSetFourByteTag('w','g','h','t'), weight});
+    return key;
+}
+
+DEF_TEST(TypefaceCache_key, reporter) {
+    sk_sp<SkTypeface> t1(TestEmptyTypeface::Make());
+    sk_sp<SkTypeface> t2(TestEmptyTypeface::Make());
+    {
+        SkTypefaceCache cache;
+        {
+            sk_sp<SkTypeface> t0(TestEmptyTypeface::Make());
+            cache.add(t0, make_key("a", 0, 400));
+            cache.add(t1, make_key("a", 1, 400));
+            cache.add(t2, make_key("a", 1, 400));
+            cache.add(TestEmptyTypeface::Make());
+            REPORTER_ASSERT(reporter, count(reporter, cache) == 4);
+
+            REPORTER_ASSERT(reporter, cache.findByKeyAndRef(make_key("a", 0, 400)) == t0);
+            REPORTER_ASSERT(reporter, cache.findByKeyAndRef(make_key("a", 1, 400)) == t1);
+            REPORTER_ASSERT(reporter, !cache.findByKeyAndRef(make_key("a", 0, 700)));
+            REPORTER_ASSERT(reporter, !cache.findByKeyAndRef(make_key("b", 0, 400)));
+
+            // The proc picks among typefaces with the same key.
+            auto isT2 = [](SkTypeface* face, void* ctx) { return face == ctx; };
+            REPORTER_ASSERT(reporter,
+                            cache.findByKeyAndRef(make_key("a", 1, 400), isT2, t2.get()) == t2);
+            REPORTER_ASSERT(reporter,
+                            !cache.findByKeyAndRef(make_key("a", 0, 400), isT2, t2.get()));
+        }
+        // Purged typefaces are gone from the index too.
+        cache.purgeAll();
+        REPORTER_ASSERT(reporter, count(reporter, cache) == 2);
+        REPORTER_ASSERT(reporter, !cache.findByKeyAndRef(make_key("a", 0, 400)));
+        REPORTER_ASSERT(reporter, cache.findByKeyAndRef(make_key("a", 1, 400)) == t1);
+        t1.reset();
+        cache.purgeAll();
+        REPORTER_ASSERT(reporter, cache.findByKeyAndRef(make_key("a", 1, 400)) == t2);
+    }
+    REPORTER_ASSERT(reporter, t2->unique());
+}
+
 static void check_serialize_behaviors(sk_sp<SkTypeface> tf, bool isLocalData,
                                       skiatest::Reporter* reporter) {
     if (!tf) {
@@ -551,6 +603,89 @@ DEF_TEST(Typeface_serialize, reporter) {
 
 }
 
+#if defined(SK_TYPEFACE_FREETYPE)
+namespace {
+// A FreeType typeface whatever the platform's font manager makes, so the per-thread face
+// setting can be made on it directly.
+class TestFreeTypeTypeface : public SkTypeface_FreeType {
+public:
+    explicit TestFreeTypeTypeface(std::unique_ptr<SkFontData> data)
+            : INHERITED(SkFontStyle(), false), fData(std::move(data)) {}
+
+    void onGetFamilyName(SkString* familyName) const override { familyName->reset(); }
+
+    void onGetFontDescriptor(SkFontDescriptor* desc, bool* serialize) const override {
+        *serialize = true;
+    }
+
+    std::unique_ptr<SkStreamAsset> onOpenStream(int* ttcIndex) const override {
+        *ttcIndex = fData->getIndex();
+        return fData->getStream()->duplicate();
+    }
+
+    std::unique_ptr<SkFontData> onMakeFontData() const override {
+        return std::make_unique<SkFontData>(*fData);
+    }
+
+    sk_sp<SkTypeface> onMakeClone(const SkFontArguments&) const override {
+        return sk_ref_sp(this);
+    }
+
+private:
+    const std::unique_ptr<const SkFontData> fData;
+
+    using INHERITED = SkTypeface_FreeType;
+};
+}  // namespace
+
+// The setting is made on typefaces of this test only, so other tests running concurrently in
+// the process are not affected.
+DEF_TEST(Typeface_FreeTypePerThreadFaces, reporter) {
+    auto makeTypeface = [] () -> sk_sp<TestFreeTypeTypeface> {
+        std::unique_ptr<SkStreamAsset> stream = GetResourceAsStream("fonts/Distortable.ttf");
+        if (!stream) {
+            return nullptr;
+        }
+        return sk_make_sp<TestFreeTypeTypeface>(
+                std::make_unique<SkFontData>(std::move(stream), 0, 0, nullptr, 0, nullptr, 0));
+    };
+    // Separate typefaces have separate strikes, so the second one's glyphs are all generated
+    // by its own scaler contexts.
+    sk_sp<TestFreeTypeTypeface> shared = makeTypeface();
+    sk_sp<TestFreeTypeTypeface> perThread = makeTypeface();
+    if (!shared || !perThread || shared->countGlyphs() == 0) {
+        INFOF(reporter, "Could not load fonts/Distortable.ttf with FreeType.");
+        return;
+    }
+    perThread->setPerThreadFaces(true);
+    REPORTER_ASSERT(reporter, perThread->usesPerThreadFaces());
+
+    constexpr int kThreads = 4;
+    constexpr SkGlyphID kGlyphCount = 16;
+    auto glyphPaths = [&](sk_sp<SkTypeface> typeface, int threadIndex,
+                          SkPath paths[kGlyphCount]) {
+        SkFont font(std::move(typeface), 10 + threadIndex);
+        for (SkGlyphID glyph = 0; glyph < kGlyphCount; ++glyph) {
+            font.getPath(glyph, &paths[glyph]);
+        }
+    };
+
+    SkPath expected[kThreads][kGlyphCount];
+    SkPath actual[kThreads][kGlyphCount];
+    for (int i = 0; i < kThreads; ++i) {
+        glyphPaths(shared, i, expected[i]);
+    }
+    SkTaskGroup().batch(kThreads, [&](int i) { glyphPaths(perThread, i, actual[i]); });
+
+    for (int i = 0; i < kThreads; ++i) {
+        for (SkGlyphID glyph = 0; glyph < kGlyphCount; ++glyph) {
+            REPORTER_ASSERT(reporter, expected[i][glyph] == actual[i][glyph],
+                            "size %d glyph %d", 10 + i, glyph);
+        }
+    }
+}
+#endif
+
 DEF_TEST(Typeface_glyph_to_char, reporter) {
     SkFont font(ToolUtils::emoji_typeface(), 12);
     SkASSERT(font.getTypeface());